@@ -0,0 +1,231 @@
+// FFI boundary microbenchmarks for WhisperFFIService
+//
+// Times, one at a time, the Dart<->native crossings the transcription calls
+// make: marshalling the audio path (toNativeUtf8 / malloc.free), the file
+// checks done before the native call, decoding the JSON result
+// (toDartString), handing over sample buffers, synchronous callbacks and
+// messages posted to the isolate from a native thread. Each crossing goes to
+// a whisper_ffi_probe_* export that does next to nothing.
+//
+// Rows share their names with native/whisper/bench/bench_ffi_boundary.cpp
+// (built with ./scripts/build_whisper.sh --bench), the native-only
+// baselines, so the difference is the cost of the boundary. Rows marked *
+// are alternative designs and have no native twin.
+//
+// Usage: dart run benchmark/ffi_boundary_benchmark.dart [library] [audio file] [iterations]
+
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+// 🧪 PROBE SIGNATURES (see whisper_wrapper.h)
+typedef ProbeNoopNative = Void Function();
+typedef ProbeNoop = void Function();
+
+typedef ProbeStringNative = Int64 Function(Pointer<Utf8> str);
+typedef ProbeString = int Function(Pointer<Utf8> str);
+
+typedef ProbeResultNative = Pointer<Utf8> Function(Int32 nSegments);
+typedef ProbeResult = Pointer<Utf8> Function(int nSegments);
+
+typedef ProbeFreeStringNative = Void Function(Pointer<Utf8> str);
+typedef ProbeFreeString = void Function(Pointer<Utf8> str);
+
+typedef ProbeSumNative = Double Function(Pointer<Float> samples, Int64 n);
+typedef ProbeSum = double Function(Pointer<Float> samples, int n);
+
+typedef ProbeCallbackNative = Void Function(Int64 value);
+typedef ProbeDriveNative = Void Function(Pointer<NativeFunction<ProbeCallbackNative>> callback, Int64 n);
+typedef ProbeDrive = void Function(Pointer<NativeFunction<ProbeCallbackNative>> callback, int n);
+
+const int _rounds = 7;
+const int _callbacksPerOp = 1000;
+const int _samples30s = 30 * 16000;
+
+// Keeps results alive so the measured work is not dropped
+int _sink = 0;
+
+void _onCallback(int value) {
+  _sink = value;
+}
+
+String _defaultLibrary() {
+  if (Platform.isMacOS) return 'native/whisper/whisper.cpp/build/libwhisper_ffi.dylib';
+  if (Platform.isWindows) return 'whisper_ffi.dll';
+  return 'native/whisper/whisper.cpp/build/libwhisper_ffi.so';
+}
+
+double _nanoseconds(Stopwatch stopwatch) => stopwatch.elapsedTicks * 1e9 / stopwatch.frequency;
+
+void _report(String name, List<double> rounds) {
+  rounds.sort();
+  stdout.writeln('${name.padRight(36)} ${rounds[rounds.length ~/ 2].toStringAsFixed(1).padLeft(12)} ns/op');
+}
+
+/// Median over [_rounds] of the time per call of [body]
+void _measure(String name, int iterations, void Function() body, {int opsPerCall = 1}) {
+  for (var i = 0; i < iterations ~/ 10 + 1; i++) {
+    body();
+  }
+  final rounds = <double>[];
+  for (var r = 0; r < _rounds; r++) {
+    final stopwatch = Stopwatch()..start();
+    for (var i = 0; i < iterations; i++) {
+      body();
+    }
+    stopwatch.stop();
+    rounds.add(_nanoseconds(stopwatch) / (iterations * opsPerCall));
+  }
+  _report(name, rounds);
+}
+
+/// [_measure] for bodies that wait on the event loop
+Future<void> _measureAsync(String name, int iterations, Future<void> Function() body, {int opsPerCall = 1}) async {
+  for (var i = 0; i < iterations ~/ 10 + 1; i++) {
+    await body();
+  }
+  final rounds = <double>[];
+  for (var r = 0; r < _rounds; r++) {
+    final stopwatch = Stopwatch()..start();
+    for (var i = 0; i < iterations; i++) {
+      await body();
+    }
+    stopwatch.stop();
+    rounds.add(_nanoseconds(stopwatch) / (iterations * opsPerCall));
+  }
+  _report(name, rounds);
+}
+
+Future<void> main(List<String> args) async {
+  final library = DynamicLibrary.open(args.isNotEmpty ? args[0] : _defaultLibrary());
+  final path = args.length > 1 ? args[1] : Platform.resolvedExecutable;
+  final iterations = args.length > 2 ? int.parse(args[2]) : 100000;
+  if (!library.providesSymbol('whisper_ffi_probe_noop')) {
+    stderr.writeln('This library has no boundary probes; build it with ./scripts/build_whisper.sh --bench');
+    exit(1);
+  }
+
+  final noop = library.lookupFunction<ProbeNoopNative, ProbeNoop>('whisper_ffi_probe_noop');
+  final noopLeaf = library.lookupFunction<ProbeNoopNative, ProbeNoop>('whisper_ffi_probe_noop', isLeaf: true);
+  final probeString = library.lookupFunction<ProbeStringNative, ProbeString>('whisper_ffi_probe_string');
+  final probeResult = library.lookupFunction<ProbeResultNative, ProbeResult>('whisper_ffi_probe_result');
+  final freeString = library.lookupFunction<ProbeFreeStringNative, ProbeFreeString>('whisper_ffi_free_string');
+  final sum = library.lookupFunction<ProbeSumNative, ProbeSum>('whisper_ffi_probe_sum');
+  final sumLeaf = library.lookupFunction<ProbeSumNative, ProbeSum>('whisper_ffi_probe_sum', isLeaf: true);
+  final call = library.lookupFunction<ProbeDriveNative, ProbeDrive>('whisper_ffi_probe_call');
+  final post = library.lookupFunction<ProbeDriveNative, ProbeDrive>('whisper_ffi_probe_post');
+
+  stdout.writeln('iterations: $iterations, file: $path\n');
+
+  // 📞 Plain calls
+  _measure('call noop', iterations, () => noop());
+  _measure('* call noop (leaf)', iterations, () => noopLeaf());
+
+  // 🔤 String marshalling, as in transcribeAudio
+  _measure('path copy+free', iterations, () {
+    final pathPtr = path.toNativeUtf8();
+    _sink = pathPtr.address;
+    malloc.free(pathPtr);
+  });
+  _measure('call with path', iterations, () {
+    final pathPtr = path.toNativeUtf8();
+    _sink = probeString(pathPtr);
+    malloc.free(pathPtr);
+  });
+  final pathBuffer = malloc<Uint8>(4096);
+  _measure('* path into reused buffer', iterations, () {
+    final bytes = utf8.encode(path);
+    pathBuffer.asTypedList(bytes.length + 1)
+      ..setAll(0, bytes)
+      ..[bytes.length] = 0;
+    _sink = probeString(pathBuffer.cast<Utf8>());
+  });
+  malloc.free(pathBuffer);
+
+  // 📁 File checks before the native call
+  final file = File(path);
+  await _measureAsync('file exists+length', iterations ~/ 10, () async {
+    _sink = await file.exists() ? 1 : 0;
+    _sink = await file.length();
+  });
+  _measure('file stat', iterations ~/ 10, () {
+    _sink = FileStat.statSync(path).size;
+  });
+  _measure('* file existsSync+lengthSync', iterations ~/ 10, () {
+    _sink = file.existsSync() ? 1 : 0;
+    _sink = file.lengthSync();
+  });
+  await _measureAsync('* file stat (async)', iterations ~/ 10, () async {
+    _sink = (await FileStat.stat(path)).size;
+  });
+
+  // 📝 Results back to Dart
+  for (final nSegments in [20, 500]) {
+    final result = probeResult(nSegments);
+    final length = result.length;
+    final repeat = iterations ~/ nSegments > 0 ? iterations ~/ nSegments : 1;
+    _measure('result copy ($nSegments segs, $length B)', repeat, () {
+      _sink = result.toDartString().length;
+    });
+    _measure('* result copy, length known ($nSegments segs)', repeat, () {
+      _sink = result.toDartString(length: length).length;
+    });
+    freeString(result);
+  }
+  _measure('result alloc+free (20 segs)', iterations ~/ 20, () {
+    freeString(probeResult(20));
+  });
+
+  // 🎚️ Sample buffers: copied into native memory vs viewed in place
+  final samples = Float32List(_samples30s)..fillRange(0, _samples30s, 0.25);
+  final sampleIterations = iterations ~/ 1000 + 1;
+  _measure('samples copy+sum (30 s)', sampleIterations, () {
+    final buffer = malloc<Float>(_samples30s);
+    buffer.asTypedList(_samples30s).setAll(0, samples);
+    _sink = sum(buffer, _samples30s).toInt();
+    malloc.free(buffer);
+  });
+  _measure('samples view sum (30 s)', sampleIterations, () {
+    _sink = sumLeaf(samples.address, _samples30s).toInt();
+  });
+  final sampleBuffer = malloc<Float>(_samples30s);
+  final sampleView = sampleBuffer.asTypedList(_samples30s);
+  _measure('* samples into reused buffer+sum (30 s)', sampleIterations, () {
+    sampleView.setAll(0, samples);
+    _sink = sum(sampleBuffer, _samples30s).toInt();
+  });
+  malloc.free(sampleBuffer);
+
+  // 🔁 Callbacks on the calling thread
+  final callback = Pointer.fromFunction<ProbeCallbackNative>(_onCallback);
+  _measure('callback (per call)', iterations ~/ _callbacksPerOp + 1, () {
+    call(callback, _callbacksPerOp);
+  }, opsPerCall: _callbacksPerOp);
+  final isolateLocal = NativeCallable<ProbeCallbackNative>.isolateLocal(_onCallback);
+  _measure('* callback isolateLocal (per call)', iterations ~/ _callbacksPerOp + 1, () {
+    call(isolateLocal.nativeFunction, _callbacksPerOp);
+  }, opsPerCall: _callbacksPerOp);
+  isolateLocal.close();
+
+  // 📬 Messages posted to this isolate from a native thread
+  var received = 0;
+  var drained = Completer<void>();
+  final listener = NativeCallable<ProbeCallbackNative>.listener((int value) {
+    if (++received == _callbacksPerOp) {
+      drained.complete();
+    }
+  });
+  await _measureAsync('post to port (per message)', iterations ~/ _callbacksPerOp + 1, () async {
+    received = 0;
+    drained = Completer<void>();
+    post(listener.nativeFunction, _callbacksPerOp);
+    await drained.future;
+  }, opsPerCall: _callbacksPerOp);
+  listener.close();
+
+  stdout.writeln('\n(sink $_sink)');
+}
@@ -0,0 +1,121 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+
+/// Mirror of `struct whisper_ffi_caption_buffer` in whisper_wrapper.h.
+/// The native stream owns its buffer and Dart never writes to it;
+/// [LiveCaptionReader] reads consistent copies from a buffer of its own.
+final class WhisperCaptionBuffer extends Struct {
+  @Uint32()
+  external int sequence;
+
+  @Uint32()
+  external int stableLength;
+
+  @Uint32()
+  external int tentativeLength;
+
+  @Uint32()
+  external int flags;
+
+  @Int64()
+  external int audioMs;
+
+  @Uint32()
+  external int mode;
+
+  @Int32()
+  external int lagMs;
+
+  @Array(stableCapacity)
+  external Array<Uint8> stable;
+
+  @Array(tentativeCapacity)
+  external Array<Uint8> tentative;
+
+  static const int stableCapacity = 4096; // WHISPER_FFI_CAPTION_STABLE_BYTES
+  static const int tentativeCapacity = 1024; // WHISPER_FFI_CAPTION_TENTATIVE_BYTES
+  static const int finalFlag = 1; // WHISPER_FFI_CAPTION_FINAL
+}
+
+/// Decoding mode of a caption stream (WHISPER_FFI_STREAM_MODE_*), from full
+/// quality down; the stream steps down while it falls behind real time
+enum CaptionMode { full, shortContext, greedy, sparse, fallbackModel }
+
+/// One consistent caption snapshot
+class LiveCaption {
+  const LiveCaption({
+    required this.stable,
+    required this.tentative,
+    required this.audioMs,
+    required this.isFinal,
+    this.mode = CaptionMode.full,
+    this.lagMs = 0,
+  });
+
+  final String stable; // Committed text (tail)
+  final String tentative; // Text that may still change
+  final int audioMs; // Audio decoded so far
+  final bool isFinal; // Stream has stopped
+  final CaptionMode mode; // Decoding mode of the last pass
+  final int lagMs; // How far decoding trailed the pushed audio
+
+  String get text => stable + tentative;
+}
+
+/// Copies the caption buffer of a stream into `out` under the seqlock
+/// (whisper_ffi_stream_snapshot); false if the writer kept it busy
+typedef CaptionSnapshot = bool Function(Pointer<WhisperCaptionBuffer> out);
+
+/// 📺 LIVE CAPTION READER
+/// Polls the native seqlock caption buffer, e.g. once per frame from a
+/// Ticker. No ports or channels: an unchanged buffer costs one integer load
+/// through the shared pointer, and a changed one is copied into a buffer the
+/// reader owns by one leaf native call. The torn-read check has to run
+/// natively: plain Dart loads carry no acquire ordering, so on ARM64 the
+/// field reads could move around the sequence reads.
+class LiveCaptionReader implements Finalizable {
+  LiveCaptionReader(this._buffer, this._snapshot) : _copy = malloc<WhisperCaptionBuffer>() {
+    _finalizer.attach(this, _copy.cast(), detach: this);
+    _stableBytes = (_copy.cast<Uint8>() + _stableOffset).asTypedList(WhisperCaptionBuffer.stableCapacity);
+    _tentativeBytes = (_copy.cast<Uint8>() + _tentativeOffset).asTypedList(WhisperCaptionBuffer.tentativeCapacity);
+  }
+
+  // Field offsets of the C struct: 4 x u32, i64, u32, i32, then the two text arrays
+  static const int _stableOffset = 32;
+  static const int _tentativeOffset = _stableOffset + WhisperCaptionBuffer.stableCapacity;
+  static final NativeFinalizer _finalizer = NativeFinalizer(malloc.nativeFree);
+
+  final Pointer<WhisperCaptionBuffer> _buffer; // Shared with the writer, only `sequence` is read here
+  final CaptionSnapshot _snapshot;
+  final Pointer<WhisperCaptionBuffer> _copy; // Owned by the reader, freed with it
+  late final Uint8List _stableBytes;
+  late final Uint8List _tentativeBytes;
+
+  int _lastSequence = 0;
+  LiveCaption? _last;
+
+  /// Latest caption; returns the previous snapshot when nothing changed or
+  /// the writer is mid-update
+  LiveCaption? poll() {
+    // A stale value here only delays the update to the next poll
+    if (_buffer.ref.sequence == _lastSequence || !_snapshot(_copy)) {
+      return _last;
+    }
+
+    final WhisperCaptionBuffer copy = _copy.ref;
+    final int mode = copy.mode.clamp(0, CaptionMode.values.length - 1);
+    _lastSequence = copy.sequence;
+    _last = LiveCaption(
+      stable: utf8.decode(Uint8List.sublistView(_stableBytes, 0, copy.stableLength), allowMalformed: true),
+      tentative: utf8.decode(Uint8List.sublistView(_tentativeBytes, 0, copy.tentativeLength), allowMalformed: true),
+      audioMs: copy.audioMs,
+      isFinal: copy.flags & WhisperCaptionBuffer.finalFlag != 0,
+      mode: CaptionMode.values[mode],
+      lagMs: copy.lagMs,
+    );
+    return _last;
+  }
+}
@@ -1,10 +1,13 @@
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:typed_data';
 import 'package:ffi/ffi.dart';
 import 'package:path/path.dart' as path;
 import 'package:flutter/services.dart';
 import 'package:path_provider/path_provider.dart';
 import 'dart:developer' as developer;
+import 'live_caption_buffer.dart';
 
 /// 🎓 **WORKSHOP MODULE 3: Dart FFI Deep Dive**
 ///
@@ -50,6 +53,63 @@ typedef WhisperFree = void Function(Pointer<Void> ctx);
 typedef WhisperFreeStringNative = Void Function(Pointer<Utf8> str);
 typedef WhisperFreeString = void Function(Pointer<Utf8> str);
 
+// 🗜️ OPUS STORAGE ENCODER
+// C: bool whisper_ffi_encode_opus(const char* audio_path, const char* opus_path, int bitrate)
+typedef WhisperEncodeOpusNative = Bool Function(Pointer<Utf8> audioPath, Pointer<Utf8> opusPath, Int32 bitrate);
+typedef WhisperEncodeOpus = bool Function(Pointer<Utf8> audioPath, Pointer<Utf8> opusPath, int bitrate);
+
+// 🚀 PRELOADED MODEL ADOPTION
+// C: whisper_context* whisper_ffi_adopt_preloaded(const char* model_path)
+typedef WhisperAdoptPreloadedNative = Pointer<Void> Function(Pointer<Utf8> modelPath);
+typedef WhisperAdoptPreloaded = Pointer<Void> Function(Pointer<Utf8> modelPath);
+
+// 🧮 BUILD / CPU BACKEND INFO
+// C: const char* whisper_ffi_system_info(void)  (static string, never freed)
+typedef WhisperSystemInfoNative = Pointer<Utf8> Function();
+typedef WhisperSystemInfo = Pointer<Utf8> Function();
+
+// 📺 LIVE CAPTION STREAM FUNCTIONS
+// C: whisper_ffi_stream* whisper_ffi_stream_start(whisper_context* ctx, const whisper_ffi_stream_params* params)
+typedef WhisperStreamStartNative = Pointer<Void> Function(Pointer<Void> ctx, Pointer<Void> params);
+typedef WhisperStreamStart = Pointer<Void> Function(Pointer<Void> ctx, Pointer<Void> params);
+// C: bool whisper_ffi_stream_push(whisper_ffi_stream* stream, const float* samples, int n_samples)
+typedef WhisperStreamPushNative = Bool Function(Pointer<Void> stream, Pointer<Float> samples, Int32 nSamples);
+typedef WhisperStreamPush = bool Function(Pointer<Void> stream, Pointer<Float> samples, int nSamples);
+// C: const whisper_ffi_caption_buffer* whisper_ffi_stream_captions(whisper_ffi_stream* stream)
+typedef WhisperStreamCaptionsNative = Pointer<WhisperCaptionBuffer> Function(Pointer<Void> stream);
+typedef WhisperStreamCaptions = Pointer<WhisperCaptionBuffer> Function(Pointer<Void> stream);
+// C: bool whisper_ffi_stream_snapshot(whisper_ffi_stream* stream, whisper_ffi_caption_buffer* out)
+typedef WhisperStreamSnapshotNative = Bool Function(Pointer<Void> stream, Pointer<WhisperCaptionBuffer> out);
+typedef WhisperStreamSnapshot = bool Function(Pointer<Void> stream, Pointer<WhisperCaptionBuffer> out);
+// C: void whisper_ffi_stream_stop(whisper_ffi_stream* stream) / whisper_ffi_stream_free(...)
+typedef WhisperStreamReleaseNative = Void Function(Pointer<Void> stream);
+typedef WhisperStreamRelease = void Function(Pointer<Void> stream);
+
+// 👀 PREVIEW-FIRST TRANSCRIPTION
+// C: whisper_ffi_preview_job* whisper_ffi_preview_start(whisper_context* ctx, const char* audio_path,
+//                                                     const whisper_ffi_transcribe_params* params, int preview_ms)
+typedef WhisperPreviewStartNative = Pointer<Void> Function(
+    Pointer<Void> ctx, Pointer<Utf8> audioPath, Pointer<Void> params, Int32 previewMs);
+typedef WhisperPreviewStart = Pointer<Void> Function(
+    Pointer<Void> ctx, Pointer<Utf8> audioPath, Pointer<Void> params, int previewMs);
+// C: char* whisper_ffi_preview_json(whisper_ffi_preview_job* job) / whisper_ffi_preview_finish(...)
+typedef WhisperPreviewResultNative = Pointer<Utf8> Function(Pointer<Void> job);
+typedef WhisperPreviewResult = Pointer<Utf8> Function(Pointer<Void> job);
+// C: bool whisper_ffi_preview_done(whisper_ffi_preview_job* job)
+typedef WhisperPreviewDoneNative = Bool Function(Pointer<Void> job);
+typedef WhisperPreviewDone = bool Function(Pointer<Void> job);
+// C: void whisper_ffi_preview_cancel(whisper_ffi_preview_job* job)
+typedef WhisperPreviewCancelNative = Void Function(Pointer<Void> job);
+typedef WhisperPreviewCancel = void Function(Pointer<Void> job);
+
+// 🎯 TIME-RANGE TRANSCRIPTION
+// C: char* whisper_ffi_transcribe_range_json(whisper_context* ctx, const char* audio_path,
+//                                            int64_t t_start_ms, int64_t t_end_ms, const whisper_ffi_transcribe_params* params)
+typedef WhisperTranscribeRangeNative = Pointer<Utf8> Function(
+    Pointer<Void> ctx, Pointer<Utf8> audioPath, Int64 tStartMs, Int64 tEndMs, Pointer<Void> params);
+typedef WhisperTranscribeRange = Pointer<Utf8> Function(
+    Pointer<Void> ctx, Pointer<Utf8> audioPath, int tStartMs, int tEndMs, Pointer<Void> params);
+
 /// 🤖 WHISPER FFI SERVICE
 /// This class demonstrates advanced FFI patterns for AI library integration
 ///
@@ -73,6 +133,20 @@ class WhisperFFIService {
   late final WhisperTranscribe _whisperTranscribe; // 🎤 Audio processing function
   late final WhisperFree _whisperFree; // 🧹 Context cleanup function
   late final WhisperFreeString _whisperFreeString; // 🧹 String memory cleanup
+  WhisperEncodeOpus? _whisperEncodeOpus; // 🗜️ Opus encoder (null if the library was built without it)
+  WhisperAdoptPreloaded? _whisperAdoptPreloaded; // 🚀 Context preloaded by the desktop runner
+  WhisperStreamStart? _whisperStreamStart; // 📺 Live caption stream (null on older builds)
+  late final WhisperStreamPush _whisperStreamPush;
+  late final WhisperStreamCaptions _whisperStreamCaptions;
+  late final WhisperStreamSnapshot _whisperStreamSnapshot;
+  late final WhisperStreamRelease _whisperStreamStop;
+  late final WhisperStreamRelease _whisperStreamFree;
+  WhisperPreviewStart? _whisperPreviewStart; // 👀 Preview-first transcription (null on older builds)
+  late final WhisperPreviewResult _whisperPreviewJson;
+  late final WhisperPreviewDone _whisperPreviewDone;
+  late final WhisperPreviewCancel _whisperPreviewCancel;
+  late final WhisperPreviewResult _whisperPreviewFinish;
+  WhisperTranscribeRange? _whisperTranscribeRange; // 🎯 Partial decode of long files (null on older builds)
 
   // 💾 NATIVE RESOURCE MANAGEMENT
   // _whisperContext: Opaque pointer to native AI model context
@@ -128,8 +202,15 @@ class WhisperFFIService {
       final modelPathPtr = modelPath.toNativeUtf8();
 
       try {
-        // Initialize Whisper context
-        _whisperContext = _whisperInit(modelPathPtr);
+        // Adopt the context the runner preloaded at startup, if it loaded this model
+        final Pointer<Void> preloaded = _whisperAdoptPreloaded?.call(modelPathPtr) ?? nullptr;
+        if (preloaded != nullptr) {
+          developer.log('🚀 [WhisperFFI] Using preloaded model context', name: _logName);
+          _whisperContext = preloaded;
+        } else {
+          // Initialize Whisper context
+          _whisperContext = _whisperInit(modelPathPtr);
+        }
 
         if (_whisperContext == nullptr) {
           throw Exception('Failed to initialize Whisper context');
@@ -223,6 +304,160 @@ class WhisperFFIService {
     }
   }
 
+  /// Transcribe a long recording preview-first: yields the text of the opening
+  /// speech (about [preview] of it) as soon as it is decoded, then the full
+  /// transcription. Falls back to a single [transcribeAudio] result on
+  /// libraries without preview support.
+  Stream<String> transcribeAudioWithPreview(
+    String audioFilePath, {
+    Duration preview = const Duration(seconds: 60),
+  }) async* {
+    if (_whisperContext == null) {
+      throw StateError('Whisper model not loaded. Call initializeModel() first.');
+    }
+    if (_whisperPreviewStart == null) {
+      yield await transcribeAudio(audioFilePath);
+      return;
+    }
+
+    final audioPathPtr = audioFilePath.toNativeUtf8();
+    final Pointer<Void> job;
+    try {
+      job = _whisperPreviewStart!(_whisperContext!, audioPathPtr, nullptr, preview.inMilliseconds);
+    } finally {
+      malloc.free(audioPathPtr);
+    }
+    if (job == nullptr) {
+      throw Exception('Preview transcription failed for $audioFilePath');
+    }
+
+    Pointer<Utf8> fullPtr = nullptr;
+    bool completed = false;
+    try {
+      yield _takeResultText(_whisperPreviewJson(job));
+      developer.log('👀 [WhisperFFI] Preview ready, decoding the rest', name: _logName);
+      // The rest decodes on a native thread; poll so this isolate stays responsive
+      while (!_whisperPreviewDone(job)) {
+        await Future<void>.delayed(const Duration(milliseconds: 100));
+      }
+      completed = true;
+    } finally {
+      // Always frees the job, also when the listener cancels early; then the
+      // rest is stopped first so finishing does not wait for all of it
+      if (!completed) {
+        _whisperPreviewCancel(job);
+      }
+      fullPtr = _whisperPreviewFinish(job);
+      if (!completed && fullPtr != nullptr) {
+        _whisperFreeString(fullPtr);
+      }
+    }
+    yield _takeResultText(fullPtr);
+  }
+
+  /// Transcribe only [start] to [end] of a recording, e.g. to re-run a
+  /// passage the user is correcting. Only that part of a WAV or Opus file is
+  /// decoded. Throws [UnsupportedError] on libraries without range support.
+  Future<String> transcribeRange(String audioFilePath, Duration start, Duration end) async {
+    if (_whisperContext == null) {
+      throw StateError('Whisper model not loaded. Call initializeModel() first.');
+    }
+    if (_whisperTranscribeRange == null) {
+      throw UnsupportedError('Range transcription not available in native library');
+    }
+
+    final audioPathPtr = audioFilePath.toNativeUtf8();
+    try {
+      developer.log(
+        '🎯 [WhisperFFI] Transcribing ${start.inMilliseconds}-${end.inMilliseconds} ms of $audioFilePath',
+        name: _logName,
+      );
+      return _takeResultText(
+        _whisperTranscribeRange!(_whisperContext!, audioPathPtr, start.inMilliseconds, end.inMilliseconds, nullptr),
+      );
+    } finally {
+      malloc.free(audioPathPtr);
+    }
+  }
+
+  /// Text of a JSON result block, freeing the native string
+  String _takeResultText(Pointer<Utf8> resultPtr) {
+    if (resultPtr == nullptr) {
+      throw Exception('Transcription failed - native function returned null result');
+    }
+    try {
+      final Map<String, dynamic> result = jsonDecode(resultPtr.toDartString()) as Map<String, dynamic>;
+      return (result['text'] as String).trim();
+    } finally {
+      _whisperFreeString(resultPtr);
+    }
+  }
+
+  /// Encode a finished recording to Ogg Opus for compact storage.
+  /// The .opus file can be passed to [transcribeAudio] directly.
+  /// Not called by the app yet: AVAudioPlayer (iOS/macOS) cannot play Ogg Opus,
+  /// so the recorder's file must stay the one that is played back.
+  /// [bitrate] is in bits per second; 0 selects the 24 kbps speech default.
+  Future<bool> encodeToOpus(String audioFilePath, String opusFilePath, {int bitrate = 0}) async {
+    if (_whisperEncodeOpus == null) {
+      developer.log('⚠️ [WhisperFFI] Opus encoding not available in native library', name: _logName);
+      return false;
+    }
+
+    final audioPathPtr = audioFilePath.toNativeUtf8();
+    final opusPathPtr = opusFilePath.toNativeUtf8();
+    try {
+      final success = _whisperEncodeOpus!(audioPathPtr, opusPathPtr, bitrate);
+      developer.log(
+        success ? '✅ [WhisperFFI] Encoded to Opus: $opusFilePath' : '❌ [WhisperFFI] Opus encode failed: $audioFilePath',
+        name: _logName,
+      );
+      return success;
+    } finally {
+      malloc.free(audioPathPtr);
+      malloc.free(opusPathPtr);
+    }
+  }
+
+  /// Start a live caption stream on the loaded model.
+  /// Read captions with [captionReader]; release with [freeCaptionStream].
+  Pointer<Void> startCaptionStream() {
+    if (_whisperContext == null) {
+      throw StateError('Whisper model not loaded. Call initializeModel() first.');
+    }
+    if (_whisperStreamStart == null) {
+      throw UnsupportedError('Native library does not support caption streams');
+    }
+
+    final Pointer<Void> stream = _whisperStreamStart!(_whisperContext!, nullptr);
+    if (stream == nullptr) {
+      throw Exception('Failed to start caption stream');
+    }
+    developer.log('📺 [WhisperFFI] Caption stream started', name: _logName);
+    return stream;
+  }
+
+  /// Reader over the stream's shared caption buffer; poll it once per frame
+  LiveCaptionReader captionReader(Pointer<Void> stream) =>
+      LiveCaptionReader(_whisperStreamCaptions(stream), (out) => _whisperStreamSnapshot(stream, out));
+
+  /// Append 16 kHz mono samples to a caption stream
+  bool pushCaptionAudio(Pointer<Void> stream, Float32List samples) {
+    final Pointer<Float> samplesPtr = malloc<Float>(samples.length);
+    try {
+      samplesPtr.asTypedList(samples.length).setAll(0, samples);
+      return _whisperStreamPush(stream, samplesPtr, samples.length);
+    } finally {
+      malloc.free(samplesPtr);
+    }
+  }
+
+  /// Decode the remaining audio and publish the final caption
+  void stopCaptionStream(Pointer<Void> stream) => _whisperStreamStop(stream);
+
+  /// Free a caption stream; readers must not be polled afterwards
+  void freeCaptionStream(Pointer<Void> stream) => _whisperStreamFree(stream);
+
   /// Check if the service is initialized
   bool get isInitialized => _isInitialized;
 
@@ -231,6 +466,32 @@ class WhisperFFIService {
 
   /// Get model file path by extracting from Flutter assets to temporary location
   static Future<String> getDefaultModelPath() async {
+    // Linux bundles assets as plain files: use the model in place, which is
+    // also the path the runner preloads at startup. VOICE_BRIDGE_MODEL
+    // overrides it on both sides, so the preloaded context is adopted.
+    if (Platform.isLinux) {
+      final String? modelOverride = Platform.environment['VOICE_BRIDGE_MODEL'];
+      if (modelOverride != null) {
+        if (File(modelOverride).existsSync()) {
+          developer.log('📁 [WhisperFFI] Using VOICE_BRIDGE_MODEL: $modelOverride', name: _logName);
+          return modelOverride;
+        }
+        developer.log('⚠️ [WhisperFFI] VOICE_BRIDGE_MODEL not found, ignoring: $modelOverride', name: _logName);
+      }
+      final String bundledModelPath = path.join(
+        path.dirname(Platform.resolvedExecutable),
+        'data',
+        'flutter_assets',
+        'assets',
+        'models',
+        'ggml-base.en.bin',
+      );
+      if (File(bundledModelPath).existsSync()) {
+        developer.log('📁 [WhisperFFI] Using bundled model: $bundledModelPath', name: _logName);
+        return bundledModelPath;
+      }
+    }
+
     try {
       developer.log('📁 [WhisperFFI] Extracting model from assets...', name: _logName);
 
@@ -416,6 +677,77 @@ class WhisperFFIService {
           .lookup<NativeFunction<WhisperFreeStringNative>>('whisper_ffi_free_string')
           .asFunction<WhisperFreeString>();
 
+      // Optional: caption streams are only exported by newer builds
+      if (_whisperLib.providesSymbol('whisper_ffi_stream_start')) {
+        _whisperStreamStart = _whisperLib
+            .lookup<NativeFunction<WhisperStreamStartNative>>('whisper_ffi_stream_start')
+            .asFunction<WhisperStreamStart>();
+        _whisperStreamPush = _whisperLib
+            .lookup<NativeFunction<WhisperStreamPushNative>>('whisper_ffi_stream_push')
+            .asFunction<WhisperStreamPush>();
+        _whisperStreamCaptions = _whisperLib
+            .lookup<NativeFunction<WhisperStreamCaptionsNative>>('whisper_ffi_stream_captions')
+            .asFunction<WhisperStreamCaptions>();
+        // Leaf call: a short copy that never calls back into Dart
+        _whisperStreamSnapshot = _whisperLib
+            .lookup<NativeFunction<WhisperStreamSnapshotNative>>('whisper_ffi_stream_snapshot')
+            .asFunction<WhisperStreamSnapshot>(isLeaf: true);
+        _whisperStreamStop = _whisperLib
+            .lookup<NativeFunction<WhisperStreamReleaseNative>>('whisper_ffi_stream_stop')
+            .asFunction<WhisperStreamRelease>();
+        _whisperStreamFree = _whisperLib
+            .lookup<NativeFunction<WhisperStreamReleaseNative>>('whisper_ffi_stream_free')
+            .asFunction<WhisperStreamRelease>();
+      }
+
+      // Optional: preview-first transcription is only exported by newer builds
+      if (_whisperLib.providesSymbol('whisper_ffi_preview_start')) {
+        _whisperPreviewStart = _whisperLib
+            .lookup<NativeFunction<WhisperPreviewStartNative>>('whisper_ffi_preview_start')
+            .asFunction<WhisperPreviewStart>();
+        _whisperPreviewJson = _whisperLib
+            .lookup<NativeFunction<WhisperPreviewResultNative>>('whisper_ffi_preview_json')
+            .asFunction<WhisperPreviewResult>();
+        _whisperPreviewDone = _whisperLib
+            .lookup<NativeFunction<WhisperPreviewDoneNative>>('whisper_ffi_preview_done')
+            .asFunction<WhisperPreviewDone>();
+        _whisperPreviewCancel = _whisperLib
+            .lookup<NativeFunction<WhisperPreviewCancelNative>>('whisper_ffi_preview_cancel')
+            .asFunction<WhisperPreviewCancel>();
+        _whisperPreviewFinish = _whisperLib
+            .lookup<NativeFunction<WhisperPreviewResultNative>>('whisper_ffi_preview_finish')
+            .asFunction<WhisperPreviewResult>();
+      }
+
+      // Optional: range transcription is only exported by newer builds
+      if (_whisperLib.providesSymbol('whisper_ffi_transcribe_range_json')) {
+        _whisperTranscribeRange = _whisperLib
+            .lookup<NativeFunction<WhisperTranscribeRangeNative>>('whisper_ffi_transcribe_range_json')
+            .asFunction<WhisperTranscribeRange>();
+      }
+
+      // Optional: whisper_ffi_adopt_preloaded is only exported by newer builds
+      if (_whisperLib.providesSymbol('whisper_ffi_adopt_preloaded')) {
+        _whisperAdoptPreloaded = _whisperLib
+            .lookup<NativeFunction<WhisperAdoptPreloadedNative>>('whisper_ffi_adopt_preloaded')
+            .asFunction<WhisperAdoptPreloaded>();
+      }
+
+      // Optional: report which CPU matrix backend this library was built with
+      if (_whisperLib.providesSymbol('whisper_ffi_system_info')) {
+        final WhisperSystemInfo systemInfo = _whisperLib
+            .lookup<NativeFunction<WhisperSystemInfoNative>>('whisper_ffi_system_info')
+            .asFunction<WhisperSystemInfo>();
+        developer.log('🧮 [WhisperFFI] ${systemInfo().toDartString()}', name: _logName);
+      }
+
+      // Optional: whisper_ffi_encode_opus is only exported by newer builds
+      if (_whisperLib.providesSymbol('whisper_ffi_encode_opus')) {
+        _whisperEncodeOpus = _whisperLib
+            .lookup<NativeFunction<WhisperEncodeOpusNative>>('whisper_ffi_encode_opus')
+            .asFunction<WhisperEncodeOpus>();
+      }
+
       developer.log('✅ [WhisperFFI] Native functions bound successfully', name: _logName);
     } catch (e) {
       developer.log('❌ [WhisperFFI] Failed to bind native functions: $e', name: _logName, error: e);
@@ -19,6 +19,9 @@ abstract class VoiceMemoService {
 }
 
 class VoiceMemoServiceImpl implements VoiceMemoService {
+  // Recording formats: .m4a/.wav from the recorder, .opus from WhisperFFIService.encodeToOpus
+  static const List<String> _audioExtensions = ['.m4a', '.wav', '.opus'];
+
   @override
   Future<String> saveVoiceMemo(VoiceMemo voiceMemo) async {
     // Currently just logs - in future this could save to database
@@ -56,15 +59,15 @@ class VoiceMemoServiceImpl implements VoiceMemoService {
         return [];
       }
 
-      // List all audio files (.m4a and .wav) in the audio directory
+      // List all audio files (.m4a, .wav and .opus) in the audio directory
       final List<FileSystemEntity> entities = audioDir.listSync();
       final List<File> audioFiles = entities
-          .where((entity) => entity is File && (entity.path.endsWith('.m4a') || entity.path.endsWith('.wav')))
+          .where((entity) => entity is File && _isAudioFile(entity.path))
           .cast<File>()
           .toList();
 
       developer.log(
-        '🎵 [VoiceMemoService] Found ${audioFiles.length} audio files (.m4a/.wav)',
+        '🎵 [VoiceMemoService] Found ${audioFiles.length} audio files (.m4a/.wav/.opus)',
         name: 'VoiceBridge.Service',
       );
 
@@ -126,7 +129,7 @@ class VoiceMemoServiceImpl implements VoiceMemoService {
         int deletedCount = 0;
         
         for (final entity in entities) {
-          if (entity is File && (entity.path.endsWith('.m4a') || entity.path.endsWith('.wav'))) {
+          if (entity is File && _isAudioFile(entity.path)) {
             try {
               await entity.delete();
               deletedCount++;
@@ -151,13 +154,13 @@ class VoiceMemoServiceImpl implements VoiceMemoService {
     final FileStat stat = await file.stat();
     final String fileName = file.path.split('/').last;
 
-    // Extract timestamp from filename (voice_memo_1234567890123.m4a or .wav)
+    // Extract timestamp from filename (voice_memo_1234567890123.m4a, .wav or .opus)
     DateTime createdAt = stat.modified;
     if (fileName.contains('voice_memo_')) {
       try {
         String timestampStr = fileName.replaceAll('voice_memo_', '');
-        // Remove file extension (.m4a or .wav)
-        timestampStr = timestampStr.replaceAll('.m4a', '').replaceAll('.wav', '');
+        // Remove file extension
+        timestampStr = _stripAudioExtension(timestampStr);
         final int timestamp = int.parse(timestampStr);
         // The timestamp in filename is already in milliseconds
         createdAt = DateTime.fromMillisecondsSinceEpoch(timestamp);
@@ -175,7 +178,7 @@ class VoiceMemoServiceImpl implements VoiceMemoService {
     final String title = _generateFriendlyTitle(createdAt);
 
     return VoiceMemo(
-      id: fileName.replaceAll('.m4a', '').replaceAll('.wav', ''),
+      id: _stripAudioExtension(fileName),
       filePath: file.path,
       title: title,
       keywords: const [],
@@ -187,6 +190,17 @@ class VoiceMemoServiceImpl implements VoiceMemoService {
     );
   }
 
+  bool _isAudioFile(String path) => _audioExtensions.any(path.endsWith);
+
+  String _stripAudioExtension(String fileName) {
+    for (final String extension in _audioExtensions) {
+      if (fileName.endsWith(extension)) {
+        return fileName.substring(0, fileName.length - extension.length);
+      }
+    }
+    return fileName;
+  }
+
   // Helper method to generate friendly titles
   String _generateFriendlyTitle(DateTime dateTime) {
     final months = ['Jan', 'Feb', 'Mar', 'Apr', 'May', 'Jun', 'Jul', 'Aug', 'Sep', 'Oct', 'Nov', 'Dec'];
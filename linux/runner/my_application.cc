@@ -1,5 +1,6 @@
 #include "my_application.h"
 
+#include <dlfcn.h>
 #include <flutter_linux/flutter_linux.h>
 #ifdef GDK_WINDOWING_X11
 #include <gdk/gdkx.h>
@@ -81,11 +82,55 @@ static gboolean my_application_local_command_line(GApplication* application, gch
   return TRUE;
 }
 
+// Starts loading the Whisper model on a native background thread so it is
+// ready by the time Dart asks for it (WhisperFFIService adopts the context
+// through whisper_ffi_adopt_preloaded). The model path defaults to the
+// bundled asset and can be overridden with VOICE_BRIDGE_MODEL, which
+// WhisperFFIService.getDefaultModelPath reads too so it adopts this one.
+static void preload_whisper_model() {
+  g_autofree gchar* exe_path = g_file_read_link("/proc/self/exe", nullptr);
+  if (exe_path == nullptr) {
+    return;
+  }
+  g_autofree gchar* exe_dir = g_path_get_dirname(exe_path);
+
+  const gchar* model_override = g_getenv("VOICE_BRIDGE_MODEL");
+  g_autofree gchar* model_path =
+      model_override != nullptr
+          ? g_strdup(model_override)
+          : g_build_filename(exe_dir, "data", "flutter_assets", "assets",
+                             "models", "ggml-base.en.bin", nullptr);
+  if (!g_file_test(model_path, G_FILE_TEST_EXISTS)) {
+    g_message("Whisper preload skipped, model not found: %s", model_path);
+    return;
+  }
+
+  // Same library Dart opens later; the handle is kept so both share it.
+  g_autofree gchar* bundled_lib =
+      g_build_filename(exe_dir, "lib", "libwhisper_ffi.so", nullptr);
+  void* library = dlopen(bundled_lib, RTLD_NOW | RTLD_GLOBAL);
+  if (library == nullptr) {
+    library = dlopen("libwhisper_ffi.so", RTLD_NOW | RTLD_GLOBAL);
+  }
+  if (library == nullptr) {
+    g_message("Whisper preload skipped: %s", dlerror());
+    return;
+  }
+
+  using preload_fn = bool (*)(const char*);
+  preload_fn preload =
+      reinterpret_cast<preload_fn>(dlsym(library, "whisper_ffi_preload"));
+  if (preload == nullptr || !preload(model_path)) {
+    g_message("Whisper preload not started");
+  }
+}
+
 // Implements GApplication::startup.
 static void my_application_startup(GApplication* application) {
   //MyApplication* self = MY_APPLICATION(object);
 
   // Perform any actions required at application startup.
+  preload_whisper_model();
 
   G_APPLICATION_CLASS(my_application_parent_class)->startup(application);
 }
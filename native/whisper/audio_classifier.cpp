@@ -0,0 +1,205 @@
+#include "audio_classifier.h"
+#include <algorithm>
+#include <cmath>
+
+static const size_t CLASSIFIER_BLOCK_FRAMES = 100; // 1 s of 10 ms hops
+static const int CLASSIFIER_LO_BIN = 2;            // 62 Hz
+static const int CLASSIFIER_HI_BIN = 160;          // 5 kHz, where speech and most music live
+static const int CLASSIFIER_STABILITY_LAG = 4;     // Compare frames 40 ms apart (no window overlap)
+static const float CLASSIFIER_SILENCE_DB = -55.0f;
+
+// Features of one 1 s block
+struct block_features {
+    float level_db;         // Mean square of the samples, dBFS
+    float low_energy_ratio; // Frames under half the block's mean energy
+    float modulation_4hz;   // Share of envelope modulation at 2-8 Hz
+    float stability;        // Mean cosine similarity of spectra 40 ms apart
+    float flatness;         // Mean spectral flatness (1 = white noise)
+};
+
+// Share of the energy envelope's modulation (1-49 Hz) that falls at 2-8 Hz,
+// the syllable rate. The block spans about 1 s, so DFT bin k is about k Hz.
+static float syllabic_modulation(const std::vector<float>& envelope) {
+    const size_t n = envelope.size();
+    float mean = 0.0f;
+    for (float e : envelope) {
+        mean += e;
+    }
+    mean /= std::max<size_t>(1, n);
+
+    float syllabic = 0.0f;
+    float total = 0.0f;
+    for (size_t k = 1; k < n / 2; ++k) {
+        float re = 0.0f;
+        float im = 0.0f;
+        const float w = 2.0f * 3.14159265f * k / n;
+        for (size_t i = 0; i < n; ++i) {
+            re += (envelope[i] - mean) * cosf(w * i);
+            im -= (envelope[i] - mean) * sinf(w * i);
+        }
+        const float power = re * re + im * im;
+        total += power;
+        if (k >= 2 && k <= 8) {
+            syllabic += power;
+        }
+    }
+    return total > 0.0f ? syllabic / total : 0.0f;
+}
+
+static block_features analyze_block(const std::vector<float>& pcm, size_t begin, size_t end,
+                                    spectral_frame_analyzer& analyzer) {
+    const size_t n_bins = CLASSIFIER_HI_BIN - CLASSIFIER_LO_BIN;
+    block_features features = {};
+
+    double square_sum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        square_sum += (double) pcm[i] * pcm[i];
+    }
+    features.level_db = 10.0f * log10f((float) (square_sum / std::max<size_t>(1, end - begin)) + 1e-10f);
+
+    const size_t n_frames = feature_frame_count(end - begin);
+    std::vector<float> energy(n_frames);
+    std::vector<float> envelope(n_frames);
+    std::vector<std::vector<float>> history(CLASSIFIER_STABILITY_LAG + 1, std::vector<float>(n_bins));
+
+    float stability_sum = 0.0f;
+    size_t stability_count = 0;
+    float flatness_sum = 0.0f;
+    for (size_t f = 0; f < n_frames; ++f) {
+        const float* power = analyzer.power_spectrum(pcm.data() + begin, end - begin, f * FEATURE_HOP_SIZE);
+        std::vector<float>& magnitude = history[f % history.size()];
+
+        float sum = 0.0f;
+        float log_sum = 0.0f;
+        for (size_t k = 0; k < n_bins; ++k) {
+            const float p = power[CLASSIFIER_LO_BIN + k];
+            magnitude[k] = sqrtf(p);
+            sum += p;
+            log_sum += logf(p + 1e-12f);
+        }
+        energy[f] = sum;
+        envelope[f] = sqrtf(sum);
+        flatness_sum += expf(log_sum / n_bins) / (sum / n_bins + 1e-12f);
+
+        if (f >= (size_t) CLASSIFIER_STABILITY_LAG) {
+            const std::vector<float>& previous = history[(f - CLASSIFIER_STABILITY_LAG) % history.size()];
+            float dot = 0.0f;
+            float norm_a = 0.0f;
+            float norm_b = 0.0f;
+            for (size_t k = 0; k < n_bins; ++k) {
+                dot += magnitude[k] * previous[k];
+                norm_a += magnitude[k] * magnitude[k];
+                norm_b += previous[k] * previous[k];
+            }
+            if (norm_a > 0.0f && norm_b > 0.0f) {
+                stability_sum += dot / sqrtf(norm_a * norm_b);
+                ++stability_count;
+            }
+        }
+    }
+
+    float mean_energy = 0.0f;
+    for (float e : energy) {
+        mean_energy += e;
+    }
+    mean_energy /= std::max<size_t>(1, n_frames);
+    size_t low = 0;
+    for (float e : energy) {
+        low += e < 0.5f * mean_energy;
+    }
+
+    features.low_energy_ratio = (float) low / std::max<size_t>(1, n_frames);
+    features.modulation_4hz = syllabic_modulation(envelope);
+    features.stability = stability_count > 0 ? stability_sum / stability_count : 0.0f;
+    features.flatness = flatness_sum / std::max<size_t>(1, n_frames);
+    return features;
+}
+
+static audio_class classify_block(const block_features& features) {
+    if (features.level_db < CLASSIFIER_SILENCE_DB) {
+        return audio_class::noise; // Silence; Whisper hallucinates on it as well
+    }
+    // Broadband and steady: hiss, hum, line noise
+    if (features.flatness > 0.45f && features.low_energy_ratio < 0.1f && features.modulation_4hz < 0.35f) {
+        return audio_class::noise;
+    }
+    // Sustained harmonic peaks with hardly a dip between them
+    if (features.stability > 0.9f && features.low_energy_ratio < 0.15f) {
+        return audio_class::music;
+    }
+    // Continuous sound without syllable rhythm, even when the notes change
+    if (features.low_energy_ratio < 0.1f && features.modulation_4hz < 0.4f) {
+        return audio_class::music;
+    }
+    return audio_class::speech;
+}
+
+std::vector<classified_region> classify_audio(const std::vector<float>& pcm) {
+    const size_t block = CLASSIFIER_BLOCK_FRAMES * FEATURE_HOP_SIZE;
+    std::vector<audio_class> blocks;
+    spectral_frame_analyzer analyzer;
+    for (size_t begin = 0; begin < pcm.size(); begin += block) {
+        blocks.push_back(classify_block(analyze_block(pcm, begin, std::min(pcm.size(), begin + block), analyzer)));
+    }
+
+    // A block outvoted by both neighbours takes their class
+    std::vector<audio_class> smoothed = blocks;
+    for (size_t i = 1; i + 1 < blocks.size(); ++i) {
+        if (blocks[i - 1] == blocks[i + 1] && blocks[i] != blocks[i - 1]) {
+            smoothed[i] = blocks[i - 1];
+        }
+    }
+
+    std::vector<classified_region> regions;
+    for (size_t i = 0; i < smoothed.size(); ++i) {
+        const size_t begin = i * block;
+        const size_t end = std::min(pcm.size(), begin + block);
+        if (!regions.empty() && regions.back().kind == smoothed[i]) {
+            regions.back().end = end;
+        } else {
+            regions.push_back({begin, end, smoothed[i]});
+        }
+    }
+    return regions;
+}
+
+std::vector<classified_region> non_speech_regions(const std::vector<float>& pcm, size_t min_samples, size_t pad) {
+    const std::vector<classified_region> regions = classify_audio(pcm);
+    std::vector<classified_region> skipped;
+    for (size_t i = 0; i < regions.size();) {
+        if (regions[i].kind == audio_class::speech) {
+            ++i;
+            continue;
+        }
+        // One run of music and noise blocks, labelled by whichever lasts longer
+        classified_region run = regions[i];
+        size_t music = 0;
+        size_t noise = 0;
+        for (; i < regions.size() && regions[i].kind != audio_class::speech; ++i) {
+            (regions[i].kind == audio_class::music ? music : noise) += regions[i].end - regions[i].begin;
+            run.end = regions[i].end;
+        }
+        run.kind = music >= noise ? audio_class::music : audio_class::noise;
+
+        // Keep a margin next to speech, so no word is clipped
+        if (run.begin > 0) {
+            run.begin += pad;
+        }
+        if (run.end < pcm.size()) {
+            run.end = run.end > pad ? run.end - pad : 0;
+        }
+        if (run.end > run.begin && run.end - run.begin >= min_samples) {
+            skipped.push_back(run);
+        }
+    }
+    return skipped;
+}
+
+const char* audio_class_name(audio_class kind) {
+    switch (kind) {
+        case audio_class::speech: return "speech";
+        case audio_class::music:  return "music";
+        case audio_class::noise:  return "noise";
+    }
+    return "unknown";
+}
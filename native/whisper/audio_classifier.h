@@ -0,0 +1,37 @@
+#ifndef AUDIO_CLASSIFIER_H
+#define AUDIO_CLASSIFIER_H
+
+// Speech / music / noise classification on cheap spectral features.
+//
+// The energy VAD cannot tell hold music from a caller, and Whisper turns
+// music into hallucinated lyrics. Here every second of audio is described
+// by features that separate the three classes without a model:
+//   - 4 Hz modulation: speech energy rises and falls with syllables (2-8 Hz)
+//   - low-energy frames: speech pauses between words, music rarely does
+//   - spectral stability: held notes keep their harmonic peaks frame to
+//     frame, the formants of speech keep moving
+//   - spectral flatness: broadband noise has no peaks at all
+// Blocks are voted on with their neighbours, and only long non-speech
+// stretches are reported, so a misjudged second never drops speech.
+
+#include "audio_features.h"
+#include <vector>
+
+enum class audio_class { speech, music, noise };
+
+struct classified_region {
+    size_t begin;
+    size_t end;
+    audio_class kind;
+};
+
+// Classify 16 kHz mono PCM in 1 s blocks; adjacent blocks of one class are merged
+std::vector<classified_region> classify_audio(const std::vector<float>& pcm);
+
+// Music and noise regions of at least min_samples, shrunk by `pad` samples
+// at every edge that touches speech
+std::vector<classified_region> non_speech_regions(const std::vector<float>& pcm, size_t min_samples, size_t pad);
+
+const char* audio_class_name(audio_class kind);
+
+#endif // AUDIO_CLASSIFIER_H
@@ -0,0 +1,197 @@
+#include "audio_embedding.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifdef WHISPER_FFI_WITH_ENCODER_OUTPUT
+// Appended to whisper.cpp by build_whisper.sh: copies up to n_max floats of
+// the last encoder output (n_ctx frames of n_audio_state) and returns the
+// full count, so out = nullptr asks for the size
+extern "C" int whisper_ffi_encoder_output(struct whisper_state* state, float* out, int n_max);
+#endif
+
+static const int64_t ENCODER_FRAME_MS = 20;
+
+void embedding_capture::reset() {
+    window_start_ms = 0;
+    window_first_segment = 0;
+    first_window = true;
+    frames_valid = false;
+    n_frames = 0;
+    by_segment.clear();
+}
+
+int embedding_size(whisper_context* ctx) {
+#ifdef WHISPER_FFI_WITH_ENCODER_OUTPUT
+    return ctx ? whisper_model_n_audio_state(ctx) : 0;
+#else
+    (void) ctx;
+    return 0;
+#endif
+}
+
+// Runs before each encoder pass of whisper_full
+static bool on_encoder_begin(whisper_context* ctx, whisper_state* state, void* user_data) {
+    (void) ctx;
+    embedding_capture* capture = static_cast<embedding_capture*>(user_data);
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    if (!capture->first_window) {
+        if (n_segments > capture->window_first_segment) {
+            // Whisper moves on to where the last segment ended
+            capture->window_start_ms = whisper_full_get_segment_t1_from_state(state, n_segments - 1) * 10;
+        } else {
+            // A window without text is skipped whole
+            capture->window_start_ms += WHISPER_CHUNK_SIZE * 1000;
+        }
+    }
+    capture->first_window = false;
+    capture->window_first_segment = n_segments;
+    capture->frames_valid = false;
+    return true;
+}
+
+void install_embedding_capture(whisper_full_params& wparams, embedding_capture& capture) {
+    wparams.encoder_begin_callback = on_encoder_begin;
+    wparams.encoder_begin_callback_user_data = &capture;
+}
+
+static void read_frames(whisper_context* ctx, whisper_state* state, embedding_capture& capture) {
+    capture.frames_valid = true;
+    capture.n_frames = 0;
+#ifdef WHISPER_FFI_WITH_ENCODER_OUTPUT
+    const int n_state = whisper_model_n_audio_state(ctx);
+    const int n = whisper_ffi_encoder_output(state, nullptr, 0);
+    if (n_state <= 0 || n <= 0) {
+        return;
+    }
+    capture.frames.resize((size_t) n);
+    whisper_ffi_encoder_output(state, capture.frames.data(), n);
+    capture.n_frames = n / n_state;
+#else
+    (void) ctx;
+    (void) state;
+#endif
+}
+
+// Unit-length mean of the frames in [begin_ms, end_ms) of the window
+static std::vector<float> pool_frames(const embedding_capture& capture, int n_state, int64_t begin_ms, int64_t end_ms) {
+    const int64_t first = std::clamp<int64_t>(begin_ms / ENCODER_FRAME_MS, 0, capture.n_frames);
+    const int64_t last = std::clamp<int64_t>((end_ms + ENCODER_FRAME_MS - 1) / ENCODER_FRAME_MS, first, capture.n_frames);
+    if (last == first) {
+        return {};
+    }
+
+    std::vector<float> pooled(n_state, 0.0f);
+    for (int64_t f = first; f < last; ++f) {
+        const float* frame = capture.frames.data() + f * n_state;
+        for (int k = 0; k < n_state; ++k) {
+            pooled[k] += frame[k];
+        }
+    }
+    float norm = 0.0f;
+    for (float v : pooled) {
+        norm += v * v;
+    }
+    norm = sqrtf(norm);
+    if (norm > 0.0f) {
+        for (float& v : pooled) {
+            v /= norm;
+        }
+    }
+    return pooled;
+}
+
+void embed_new_segments(whisper_context* ctx, whisper_state* state, embedding_capture& capture) {
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    const int n_state = embedding_size(ctx);
+    for (int i = (int) capture.by_segment.size(); i < n_segments; ++i) {
+        // Segments of earlier windows can no longer be pooled
+        if (n_state <= 0 || i < capture.window_first_segment) {
+            capture.by_segment.emplace_back();
+            continue;
+        }
+        if (!capture.frames_valid) {
+            read_frames(ctx, state, capture);
+        }
+        const int64_t t0_ms = whisper_full_get_segment_t0_from_state(state, i) * 10 - capture.window_start_ms;
+        const int64_t t1_ms = whisper_full_get_segment_t1_from_state(state, i) * 10 - capture.window_start_ms;
+        capture.by_segment.push_back(pool_frames(capture, n_state, t0_ms, t1_ms));
+    }
+}
+
+std::vector<float> memo_embedding(const std::vector<ffi_segment>& segments) {
+    std::vector<float> memo;
+    for (const ffi_segment& segment : segments) {
+        if (segment.embedding.empty()) {
+            continue;
+        }
+        if (memo.empty()) {
+            memo.assign(segment.embedding.size(), 0.0f);
+        }
+        const float weight = (float) std::max<int64_t>(1, segment.t1_ms - segment.t0_ms);
+        for (size_t k = 0; k < memo.size() && k < segment.embedding.size(); ++k) {
+            memo[k] += weight * segment.embedding[k];
+        }
+    }
+    float norm = 0.0f;
+    for (float v : memo) {
+        norm += v * v;
+    }
+    norm = sqrtf(norm);
+    if (norm > 0.0f) {
+        for (float& v : memo) {
+            v /= norm;
+        }
+    }
+    return memo;
+}
+
+extern "C" {
+
+int whisper_ffi_embedding_size(whisper_context* ctx) {
+    return embedding_size(ctx);
+}
+
+char* whisper_ffi_transcribe_embed_json(whisper_context* ctx, const char* audio_path,
+                                        const struct whisper_ffi_transcribe_params* params, float* embedding) {
+    if (!ctx || !audio_path || !embedding) {
+        std::cerr << "❌ Invalid parameters for embedding transcription" << std::endl;
+        return nullptr;
+    }
+    if (embedding_size(ctx) == 0) {
+        std::cerr << "❌ Audio embeddings need the encoder output accessor (rebuild with build_whisper.sh)" << std::endl;
+        return nullptr;
+    }
+
+    try {
+        whisper_ffi_transcribe_params options = params ? *params : whisper_ffi_transcribe_default_params();
+        const bool keep_segment_embeddings = options.embeddings;
+        options.embeddings = true;
+
+        std::vector<ffi_segment> segments;
+        if (!transcribe_segments(ctx, audio_path, options, segments)) {
+            return nullptr;
+        }
+
+        const std::vector<float> memo = memo_embedding(segments);
+        if (memo.empty()) {
+            std::cerr << "⚠️ No speech to embed in " << audio_path << std::endl;
+        }
+        const size_t size = (size_t) embedding_size(ctx);
+        std::fill(embedding, embedding + size, 0.0f);
+        std::copy(memo.begin(), memo.begin() + std::min(size, memo.size()), embedding);
+
+        if (!keep_segment_embeddings) {
+            for (ffi_segment& segment : segments) {
+                segment.embedding.clear();
+            }
+        }
+        std::cerr << "🧭 Embedded " << audio_path << " (" << memo.size() << " dims)" << std::endl;
+        return result_to_c_string(segments);
+    } catch (...) {
+        std::cerr << "💥 Exception during embedding transcription" << std::endl;
+        return nullptr;
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef AUDIO_EMBEDDING_H
+#define AUDIO_EMBEDDING_H
+
+// Audio embeddings pooled from the Whisper encoder.
+//
+// Every decode already runs the encoder over each 30 s window, and its
+// output (one n_audio_state vector per 20 ms frame) describes the audio
+// well enough to find similar recordings. The frames under each segment are
+// mean-pooled into a unit-length segment embedding while the window's
+// output is still in the state; a memo embedding is the duration-weighted
+// mean of its segments.
+//
+// whisper.cpp keeps the encoder output private, so this needs the small
+// accessor that scripts/build_whisper.sh appends to it
+// (WHISPER_FFI_WITH_ENCODER_OUTPUT). Without it no embeddings are produced.
+
+#include "whisper_ffi_internal.h"
+#include <cstdint>
+#include <vector>
+
+// Tracks the encoder windows of one whisper_full call and pools the frames
+// under each new segment. Use one per concurrent decode.
+struct embedding_capture {
+    int64_t window_start_ms = 0; // Audio time of the first frame of the current window
+    int window_first_segment = 0;
+    bool first_window = true;
+
+    // Encoder output of the current window, copied once per window
+    std::vector<float> frames;
+    int n_frames = 0;
+    bool frames_valid = false;
+
+    // Embedding of segment i of the decode (empty when unavailable)
+    std::vector<std::vector<float>> by_segment;
+
+    // Forget the previous decode
+    void reset();
+};
+
+// Dimension of this context's embeddings; 0 if the build cannot read encoder output
+int embedding_size(whisper_context* ctx);
+
+// Track encoder windows through encoder_begin_callback
+void install_embedding_capture(whisper_full_params& wparams, embedding_capture& capture);
+
+// Pool embeddings for the segments decoded since the last call
+void embed_new_segments(whisper_context* ctx, whisper_state* state, embedding_capture& capture);
+
+// Duration-weighted, unit-length mean of segment embeddings (empty if none have one)
+std::vector<float> memo_embedding(const std::vector<ffi_segment>& segments);
+
+#endif // AUDIO_EMBEDDING_H
@@ -0,0 +1,245 @@
+#include "audio_features.h"
+#include <algorithm>
+#include <cmath>
+
+static const float FEATURE_PI = 3.14159265358979f;
+static const int FEATURE_SAMPLE_RATE = 16000;
+
+// Window and twiddle tables, built once per process
+struct fft_tables {
+    std::vector<float> window;
+    std::vector<float> cos_table;
+    std::vector<float> sin_table;
+    std::vector<int> bit_reverse;
+
+    fft_tables() : window(FEATURE_FRAME_SIZE), cos_table(FEATURE_FFT_SIZE / 2), sin_table(FEATURE_FFT_SIZE / 2),
+                   bit_reverse(FEATURE_FFT_SIZE) {
+        for (int i = 0; i < FEATURE_FRAME_SIZE; ++i) {
+            window[i] = 0.5f - 0.5f * cosf(2.0f * FEATURE_PI * i / FEATURE_FRAME_SIZE);
+        }
+        for (int i = 0; i < FEATURE_FFT_SIZE / 2; ++i) {
+            cos_table[i] = cosf(2.0f * FEATURE_PI * i / FEATURE_FFT_SIZE);
+            sin_table[i] = sinf(2.0f * FEATURE_PI * i / FEATURE_FFT_SIZE);
+        }
+        int bits = 0;
+        while ((1 << bits) < FEATURE_FFT_SIZE) {
+            ++bits;
+        }
+        for (int i = 0; i < FEATURE_FFT_SIZE; ++i) {
+            int r = 0;
+            for (int b = 0; b < bits; ++b) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bit_reverse[i] = r;
+        }
+    }
+};
+
+static const fft_tables& get_fft_tables() {
+    static const fft_tables tables;
+    return tables;
+}
+
+// In-place iterative radix-2 FFT
+static void fft(std::vector<float>& re, std::vector<float>& im) {
+    const fft_tables& tables = get_fft_tables();
+    const int n = FEATURE_FFT_SIZE;
+
+    for (int i = 0; i < n; ++i) {
+        const int j = tables.bit_reverse[i];
+        if (j > i) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    for (int size = 2; size <= n; size <<= 1) {
+        const int half = size / 2;
+        const int step = n / size;
+        for (int start = 0; start < n; start += size) {
+            for (int k = 0; k < half; ++k) {
+                const float wr = tables.cos_table[k * step];
+                const float wi = -tables.sin_table[k * step];
+                const int a = start + k;
+                const int b = a + half;
+                const float tr = re[b] * wr - im[b] * wi;
+                const float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+size_t feature_frame_count(size_t n_samples) {
+    if (n_samples == 0) {
+        return 0;
+    }
+    if (n_samples < (size_t) FEATURE_FRAME_SIZE) {
+        return 1;
+    }
+    return 1 + (n_samples - FEATURE_FRAME_SIZE) / FEATURE_HOP_SIZE;
+}
+
+spectral_frame_analyzer::spectral_frame_analyzer()
+    : re(FEATURE_FFT_SIZE), im(FEATURE_FFT_SIZE), power(FEATURE_N_BINS) {}
+
+const float* spectral_frame_analyzer::power_spectrum(const float* pcm, size_t n_samples, size_t offset) {
+    const std::vector<float>& window = get_fft_tables().window;
+
+    const size_t available = offset < n_samples ? std::min<size_t>(FEATURE_FRAME_SIZE, n_samples - offset) : 0;
+    for (size_t i = 0; i < available; ++i) {
+        re[i] = pcm[offset + i] * window[i];
+    }
+    std::fill(re.begin() + available, re.end(), 0.0f);
+    std::fill(im.begin(), im.end(), 0.0f);
+
+    fft(re, im);
+
+    for (int k = 0; k < FEATURE_N_BINS; ++k) {
+        power[k] = re[k] * re[k] + im[k] * im[k];
+    }
+    return power.data();
+}
+
+static float hz_to_mel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float mel_to_hz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+mel_filterbank::mel_filterbank(int n) : n_mels(n), first_bin(n), weights(n) {
+    const float mel_lo = hz_to_mel(60.0f);
+    const float mel_hi = hz_to_mel(FEATURE_SAMPLE_RATE / 2.0f);
+    const float bin_hz = (float) FEATURE_SAMPLE_RATE / FEATURE_FFT_SIZE;
+
+    std::vector<float> edges(n + 2);
+    for (int i = 0; i < n + 2; ++i) {
+        edges[i] = mel_to_hz(mel_lo + (mel_hi - mel_lo) * i / (n + 1)) / bin_hz;
+    }
+
+    for (int m = 0; m < n; ++m) {
+        const float left = edges[m];
+        const float center = edges[m + 1];
+        const float right = edges[m + 2];
+        first_bin[m] = std::max(0, (int) ceilf(left));
+        const int last_bin = std::min(FEATURE_N_BINS - 1, (int) floorf(right));
+        for (int k = first_bin[m]; k <= last_bin; ++k) {
+            const float w = k <= center ? (k - left) / std::max(1e-6f, center - left)
+                                        : (right - k) / std::max(1e-6f, right - center);
+            weights[m].push_back(std::max(0.0f, w));
+        }
+    }
+}
+
+void mel_filterbank::log_energies(const float* power, float* out) const {
+    for (int m = 0; m < n_mels; ++m) {
+        const float* p = power + first_bin[m];
+        const float* w = weights[m].data();
+        const size_t len = weights[m].size();
+        float sum = 0.0f;
+        for (size_t k = 0; k < len; ++k) {
+            sum += p[k] * w[k];
+        }
+        out[m] = logf(std::max(sum, 1e-10f));
+    }
+}
+
+void compute_mfcc(const float* pcm, size_t n_samples, int n_mfcc, std::vector<float>& mfcc) {
+    const int n_mels = 40;
+    const size_t n_frames = feature_frame_count(n_samples);
+
+    spectral_frame_analyzer analyzer;
+    mel_filterbank filters(n_mels);
+
+    // DCT-II basis, one row per coefficient
+    std::vector<float> dct((size_t) n_mfcc * n_mels);
+    for (int c = 0; c < n_mfcc; ++c) {
+        for (int m = 0; m < n_mels; ++m) {
+            dct[(size_t) c * n_mels + m] = cosf(FEATURE_PI * c * (m + 0.5f) / n_mels);
+        }
+    }
+
+    mfcc.assign(n_frames * n_mfcc, 0.0f);
+    std::vector<float> log_mel(n_mels);
+    for (size_t f = 0; f < n_frames; ++f) {
+        filters.log_energies(analyzer.power_spectrum(pcm, n_samples, f * FEATURE_HOP_SIZE), log_mel.data());
+        float* out = mfcc.data() + f * n_mfcc;
+        for (int c = 0; c < n_mfcc; ++c) {
+            const float* basis = dct.data() + (size_t) c * n_mels;
+            float sum = 0.0f;
+            for (int m = 0; m < n_mels; ++m) {
+                sum += basis[m] * log_mel[m];
+            }
+            out[c] = sum;
+        }
+    }
+}
+
+std::vector<audio_region> detect_speech_regions(const std::vector<float>& pcm) {
+    const size_t frame = FEATURE_SAMPLE_RATE / 50; // 20 ms
+    const size_t n_frames = pcm.size() / frame;
+    std::vector<audio_region> regions;
+    if (n_frames == 0) {
+        return regions;
+    }
+
+    std::vector<float> energy_db(n_frames);
+    for (size_t f = 0; f < n_frames; ++f) {
+        const float* x = pcm.data() + f * frame;
+        float sum = 0.0f;
+        for (size_t i = 0; i < frame; ++i) {
+            sum += x[i] * x[i];
+        }
+        energy_db[f] = 10.0f * log10f(sum / frame + 1e-10f);
+    }
+
+    // Threshold relative to the recording's own noise floor and loud level,
+    // so quiet phone memos and loud meeting rooms both work
+    std::vector<float> sorted = energy_db;
+    std::nth_element(sorted.begin(), sorted.begin() + n_frames / 10, sorted.end());
+    const float floor_db = sorted[n_frames / 10];
+    std::nth_element(sorted.begin(), sorted.begin() + n_frames * 9 / 10, sorted.end());
+    const float loud_db = sorted[n_frames * 9 / 10];
+    const float margin = std::max(6.0f, std::min(12.0f, (loud_db - floor_db) / 2.0f));
+    const float threshold = std::max(floor_db + margin, -55.0f);
+
+    const size_t min_gap = 15;    // Bridge pauses shorter than 300 ms
+    const size_t min_speech = 10; // Drop blips shorter than 200 ms
+    const size_t pad = 5;         // Keep 100 ms around each region
+
+    size_t f = 0;
+    while (f < n_frames) {
+        while (f < n_frames && energy_db[f] < threshold) {
+            ++f;
+        }
+        if (f == n_frames) {
+            break;
+        }
+        const size_t start = f;
+        size_t last_speech = f;
+        while (f < n_frames && f - last_speech <= min_gap) {
+            if (energy_db[f] >= threshold) {
+                last_speech = f;
+            }
+            ++f;
+        }
+        if (last_speech + 1 - start < min_speech) {
+            continue;
+        }
+
+        audio_region region;
+        region.begin = (start > pad ? start - pad : 0) * frame;
+        region.end = std::min(n_frames, last_speech + 1 + pad) * frame;
+        if (!regions.empty() && region.begin <= regions.back().end) {
+            regions.back().end = std::max(regions.back().end, region.end);
+        } else {
+            regions.push_back(region);
+        }
+    }
+    return regions;
+}
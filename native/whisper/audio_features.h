@@ -0,0 +1,63 @@
+#ifndef AUDIO_FEATURES_H
+#define AUDIO_FEATURES_H
+
+// Frame-level spectral features shared by the native analysis stages
+// (voice activity, speaker embeddings). Everything works on 16 kHz mono
+// float PCM as produced by read_audio_file, with 25 ms frames every 10 ms.
+// Inner loops run over contiguous float arrays so the compiler can
+// vectorize them.
+
+#include <cstddef>
+#include <vector>
+
+static const int FEATURE_FRAME_SIZE = 400; // 25 ms
+static const int FEATURE_HOP_SIZE   = 160; // 10 ms
+static const int FEATURE_FFT_SIZE   = 512;
+static const int FEATURE_N_BINS     = FEATURE_FFT_SIZE / 2 + 1;
+
+// A span of samples [begin, end)
+struct audio_region {
+    size_t begin;
+    size_t end;
+};
+
+// Number of analysis frames for n samples
+size_t feature_frame_count(size_t n_samples);
+
+// Hann-windowed power spectrum of one frame at a time. Frames are analysed
+// one by one so hour-long recordings never hold a full spectrogram.
+struct spectral_frame_analyzer {
+    spectral_frame_analyzer();
+
+    // FEATURE_N_BINS power values for the frame starting at pcm[offset],
+    // zero padded past n_samples. Valid until the next call.
+    const float* power_spectrum(const float* pcm, size_t n_samples, size_t offset);
+
+private:
+    std::vector<float> re;
+    std::vector<float> im;
+    std::vector<float> power;
+};
+
+// Triangular mel filters over the power spectrum bins
+struct mel_filterbank {
+    explicit mel_filterbank(int n_mels);
+
+    // n_mels log energies for one power spectrum
+    void log_energies(const float* power, float* out) const;
+
+    int n_mels;
+
+private:
+    std::vector<int> first_bin;
+    std::vector<std::vector<float>> weights;
+};
+
+// MFCCs (c0..c{n_mfcc-1}), n_mfcc values per frame
+void compute_mfcc(const float* pcm, size_t n_samples, int n_mfcc, std::vector<float>& mfcc);
+
+// Energy-based voice activity: regions whose 20 ms energy stays clearly
+// above the recording's own noise floor, with short gaps bridged
+std::vector<audio_region> detect_speech_regions(const std::vector<float>& pcm);
+
+#endif // AUDIO_FEATURES_H
@@ -0,0 +1,74 @@
+#include "audio_range.h"
+#include "audio_stream.h"
+#include "opus_codec.h"
+#include "whisper_ffi_internal.h"
+#include <algorithm>
+#include <iostream>
+
+static const int64_t SAMPLES_PER_MS = WHISPER_SAMPLE_RATE / 1000;
+// Audio decoded on each side of the requested range so words at its edges keep their context
+static const int64_t RANGE_MARGIN_MS = 2000;
+
+std::vector<float> read_audio_range(const std::string& path, int64_t begin_ms, int64_t end_ms) {
+    const size_t begin = (size_t) (std::max<int64_t>(begin_ms, 0) * SAMPLES_PER_MS);
+    const size_t end = (size_t) (std::max<int64_t>(end_ms, 0) * SAMPLES_PER_MS);
+    const std::string extension = get_file_extension(path);
+
+    if (extension == "wav") {
+        std::vector<float> pcm;
+        read_wav_file(path, begin, end, pcm);
+        return pcm;
+    }
+    if (extension == "opus" || extension == "ogg") {
+        return decode_ogg_opus_range(path, begin, end);
+    }
+
+    std::vector<float> pcm = read_audio_file(path);
+    if (begin >= pcm.size()) {
+        return {};
+    }
+    return std::vector<float>(pcm.begin() + begin, pcm.begin() + std::min(end, pcm.size()));
+}
+
+extern "C" {
+
+char* whisper_ffi_transcribe_range_json(whisper_context* ctx, const char* audio_path, int64_t t_start_ms,
+                                        int64_t t_end_ms, const struct whisper_ffi_transcribe_params* params) {
+    if (!ctx || !audio_path || t_start_ms < 0 || t_end_ms <= t_start_ms) {
+        std::cerr << "❌ Invalid parameters for range transcription" << std::endl;
+        return nullptr;
+    }
+
+    try {
+        const int64_t from_ms = std::max<int64_t>(0, t_start_ms - RANGE_MARGIN_MS);
+        const int64_t to_ms = t_end_ms + RANGE_MARGIN_MS;
+        std::cerr << "🎯 Transcribing " << audio_path << " from " << t_start_ms << " to " << t_end_ms << " ms"
+                  << std::endl;
+        const std::vector<float> pcm = read_audio_range(audio_path, from_ms, to_ms);
+        if (pcm.empty()) {
+            std::cerr << "❌ No audio in range of " << audio_path << std::endl;
+            return nullptr;
+        }
+
+        // Segments in the margins only lend context to the ones in range
+        std::vector<ffi_segment> segments;
+        const bool ok = transcribe_pcm(ctx, nullptr, pcm, params ? *params : whisper_ffi_transcribe_default_params(),
+                                       [&](ffi_segment&& segment) {
+            shift_segment(segment, from_ms);
+            if (segment.t1_ms > t_start_ms && segment.t0_ms < t_end_ms) {
+                segments.push_back(std::move(segment));
+            }
+            return true;
+        });
+        if (!ok) {
+            return nullptr;
+        }
+        std::cerr << "✅ Range transcription completed (" << segments.size() << " segments)" << std::endl;
+        return result_to_c_string(segments);
+    } catch (...) {
+        std::cerr << "💥 Exception during range transcription" << std::endl;
+        return nullptr;
+    }
+}
+
+}
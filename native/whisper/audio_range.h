@@ -0,0 +1,20 @@
+#ifndef AUDIO_RANGE_H
+#define AUDIO_RANGE_H
+
+// Random access into long recordings.
+//
+// Correcting one minute of a two-hour memo should not decode two hours of
+// audio. WAV data is fixed-size frames, so the byte offset of any time is
+// computed from the header; Ogg Opus is decoded from the page before the
+// requested time, found in a seek table that is built once per file and
+// cached (see decode_ogg_opus_range). Other files are read whole and cut.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Mono 16 kHz samples of [begin_ms, end_ms) of an audio file, clamped to
+// the recording; sample 0 of the result is at max(begin_ms, 0)
+std::vector<float> read_audio_range(const std::string& path, int64_t begin_ms, int64_t end_ms);
+
+#endif // AUDIO_RANGE_H
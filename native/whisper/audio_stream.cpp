@@ -0,0 +1,400 @@
+#include "audio_stream.h"
+#include "opus_codec.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#ifdef WHISPER_FFI_WITH_FLAC
+#include <FLAC/stream_decoder.h>
+#endif
+
+static const size_t STREAM_CHUNK_BYTES = 64 * 1024;
+static const uint32_t WAV_SIZE_UNKNOWN = 0xFFFFFFFFu;
+static const uint16_t WAV_FORMAT_PCM = 1;
+static const uint16_t WAV_FORMAT_FLOAT = 3;
+static const uint16_t WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Source reads with room to push back the bytes used to sniff the format
+class byte_stream {
+public:
+    explicit byte_stream(const audio_read_fn& read) : read_(read) {}
+
+    // Up to `size` bytes, pushed-back bytes first; 0 at the end, negative on error
+    int64_t read_some(void* buffer, size_t size) {
+        if (pending_ < pushed_back_.size()) {
+            const size_t n = std::min(size, pushed_back_.size() - pending_);
+            memcpy(buffer, pushed_back_.data() + pending_, n);
+            pending_ += n;
+            return (int64_t) n;
+        }
+        if (size == 0 || failed_) {
+            return failed_ ? -1 : 0;
+        }
+        const int64_t n = read_(buffer, size);
+        failed_ = n < 0;
+        return n;
+    }
+
+    // Exactly `size` bytes, or false at an early end or error
+    bool read_exact(void* buffer, size_t size) {
+        unsigned char* out = static_cast<unsigned char*>(buffer);
+        while (size > 0) {
+            const int64_t n = read_some(out, size);
+            if (n <= 0) {
+                return false;
+            }
+            out += n;
+            size -= (size_t) n;
+        }
+        return true;
+    }
+
+    // Skip `size` bytes by reading them, the stream cannot seek
+    bool skip(uint64_t size) {
+        unsigned char scratch[4096];
+        while (size > 0) {
+            const int64_t n = read_some(scratch, (size_t) std::min<uint64_t>(size, sizeof(scratch)));
+            if (n <= 0) {
+                return false;
+            }
+            size -= (uint64_t) n;
+        }
+        return true;
+    }
+
+    void unread(const unsigned char* data, size_t size) {
+        pushed_back_.assign(data, data + size);
+        pending_ = 0;
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    const audio_read_fn& read_;
+    std::vector<unsigned char> pushed_back_;
+    size_t pending_ = 0;
+    bool failed_ = false;
+};
+
+static uint16_t get_le16(const unsigned char* p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const unsigned char* p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// Mono samples of whole frames in `data`, averaging the channels
+void append_wav_frames(const unsigned char* data, size_t n_frames, uint16_t format, uint16_t channels,
+                       std::vector<float>& pcm) {
+    const size_t sample_bytes = format == WAV_FORMAT_FLOAT ? 4 : 2;
+    const float scale = 1.0f / channels;
+    // Geometric growth: an exact reserve per chunk would reallocate on every read
+    if (pcm.capacity() < pcm.size() + n_frames) {
+        pcm.reserve(std::max(pcm.size() + n_frames, pcm.capacity() * 2));
+    }
+    for (size_t f = 0; f < n_frames; ++f) {
+        float sum = 0.0f;
+        for (uint16_t c = 0; c < channels; ++c) {
+            const unsigned char* p = data + (f * channels + c) * sample_bytes;
+            if (format == WAV_FORMAT_FLOAT) {
+                const uint32_t bits = get_le32(p);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                sum += value;
+            } else {
+                sum += (int16_t) get_le16(p) / 32768.0f;
+            }
+        }
+        pcm.push_back(sum * scale);
+    }
+}
+
+bool read_wav_header(const std::function<bool(void* buffer, size_t size)>& read,
+                     const std::function<bool(uint64_t size)>& skip, const std::string& label, wav_header& header) {
+    header = wav_header();
+    unsigned char riff[12];
+    if (!read(riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        std::cerr << "❌ Invalid WAVE header: " << label << std::endl;
+        return false;
+    }
+    const uint32_t riff_size = get_le32(riff + 4);
+    const bool riff_unknown = riff_size == 0 || riff_size == WAV_SIZE_UNKNOWN;
+    bool fmt_found = false;
+
+    for (;;) {
+        unsigned char chunk[8];
+        if (!read(chunk, sizeof(chunk))) {
+            std::cerr << "❌ No data chunk in WAV: " << label << std::endl;
+            return false;
+        }
+        const std::string chunk_name(reinterpret_cast<const char*>(chunk), 4);
+        const uint32_t chunk_size = get_le32(chunk + 4);
+        // Chunks are padded to an even length
+        const uint64_t padded_size = (uint64_t) chunk_size + (chunk_size & 1);
+
+        if (chunk_name == "fmt ") {
+            unsigned char fmt[40] = {};
+            const size_t kept = std::min<size_t>(chunk_size, sizeof(fmt));
+            if (chunk_size < 16 || !read(fmt, kept) || !skip(padded_size - kept)) {
+                std::cerr << "❌ Invalid fmt chunk in WAV: " << label << std::endl;
+                return false;
+            }
+            header.format = get_le16(fmt);
+            header.channels = get_le16(fmt + 2);
+            header.sample_rate = get_le32(fmt + 4);
+            header.bits_per_sample = get_le16(fmt + 14);
+            if (header.format == WAV_FORMAT_EXTENSIBLE && kept >= 26) {
+                header.format = get_le16(fmt + 24); // First two bytes of the sub-format GUID
+            }
+            fmt_found = true;
+        } else if (chunk_name == "data") {
+            if (!fmt_found) {
+                std::cerr << "❌ Found data chunk before fmt chunk: " << label << std::endl;
+                return false;
+            }
+            const bool pcm16 = header.format == WAV_FORMAT_PCM && header.bits_per_sample == 16;
+            const bool float32 = header.format == WAV_FORMAT_FLOAT && header.bits_per_sample == 32;
+            if ((!pcm16 && !float32) || header.channels == 0) {
+                std::cerr << "❌ Unsupported WAV: format " << header.format << ", " << header.bits_per_sample
+                          << " bits, " << header.channels << " channels (16-bit PCM or 32-bit float supported)"
+                          << std::endl;
+                return false;
+            }
+            if (header.sample_rate != 16000) {
+                std::cout << "⚠️ Sample rate is " << header.sample_rate << "Hz, Whisper expects 16kHz. Audio may not transcribe optimally." << std::endl;
+            }
+            header.data_size = chunk_size;
+            // Streaming encoders cannot patch the sizes in afterwards
+            header.until_end = chunk_size == WAV_SIZE_UNKNOWN || (chunk_size == 0 && riff_unknown);
+            return true;
+        } else if (!skip(padded_size)) {
+            std::cerr << "❌ WAV ended inside chunk '" << chunk_name << "': " << label << std::endl;
+            return false;
+        }
+    }
+}
+
+bool read_wav_file(const std::string& path, size_t begin, size_t end, std::vector<float>& pcm) {
+    std::error_code error;
+    const uint64_t file_size = std::filesystem::file_size(path, error);
+    FILE* file = error ? nullptr : fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "❌ Could not open file: " << path << std::endl;
+        return false;
+    }
+
+    wav_header header;
+    const bool header_ok = read_wav_header(
+        [file](void* buffer, size_t size) { return fread(buffer, 1, size, file) == size; },
+        [file](uint64_t size) { return fseek(file, (long) size, SEEK_CUR) == 0; }, path, header);
+    const long data_offset = header_ok ? ftell(file) : -1;
+    if (data_offset < 0) {
+        fclose(file);
+        return false;
+    }
+
+    // A size the header overstates is cut to the bytes really in the file
+    const uint64_t available = file_size - std::min<uint64_t>(file_size, (uint64_t) data_offset);
+    const uint64_t data_size = header.until_end ? available : std::min<uint64_t>(header.data_size, available);
+    const size_t frame_bytes = header.frame_bytes();
+    end = std::min(end, (size_t) (data_size / frame_bytes));
+    std::cout << "💾 WAV data: " << header.channels << " ch, " << header.sample_rate << " Hz, " << data_size
+              << " bytes" << std::endl;
+    if (begin >= end) {
+        fclose(file);
+        return true;
+    }
+    if (fseek(file, (long) ((uint64_t) data_offset + (uint64_t) begin * frame_bytes), SEEK_SET) != 0) {
+        std::cerr << "❌ Could not seek in WAV file: " << path << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    std::vector<unsigned char> buffer(std::max(STREAM_CHUNK_BYTES / frame_bytes, (size_t) 1) * frame_bytes);
+    pcm.reserve(pcm.size() + (end - begin));
+    for (size_t frame = begin; frame < end;) {
+        const size_t want = std::min(buffer.size() / frame_bytes, end - frame);
+        const size_t got = fread(buffer.data(), frame_bytes, want, file);
+        append_wav_frames(buffer.data(), got, header.format, header.channels, pcm);
+        if (got < want) {
+            break;
+        }
+        frame += got;
+    }
+    fclose(file);
+    return true;
+}
+
+static bool decode_wav_stream(byte_stream& in, const std::string& label, std::vector<float>& pcm) {
+    wav_header header;
+    if (!read_wav_header([&in](void* buffer, size_t size) { return in.read_exact(buffer, size); },
+                         [&in](uint64_t size) { return in.skip(size); }, label, header)) {
+        return false;
+    }
+
+    uint64_t remaining = header.until_end ? UINT64_MAX : header.data_size;
+    std::cout << "💾 Streaming WAV data: " << header.channels << " ch, " << header.sample_rate << " Hz, "
+              << (header.until_end ? std::string("size unknown") : std::to_string(header.data_size) + " bytes")
+              << std::endl;
+
+    const size_t frame_bytes = header.frame_bytes();
+    std::vector<unsigned char> buffer(std::max(STREAM_CHUNK_BYTES, frame_bytes));
+    size_t filled = 0;
+    while (remaining > 0) {
+        const size_t want = (size_t) std::min<uint64_t>(buffer.size() - filled, remaining);
+        const int64_t n = in.read_some(buffer.data() + filled, want);
+        if (n <= 0) {
+            break;
+        }
+        filled += (size_t) n;
+        remaining -= (uint64_t) n;
+
+        const size_t n_frames = filled / frame_bytes;
+        append_wav_frames(buffer.data(), n_frames, header.format, header.channels, pcm);
+        // Keep a partial frame for the next read
+        memmove(buffer.data(), buffer.data() + n_frames * frame_bytes, filled - n_frames * frame_bytes);
+        filled -= n_frames * frame_bytes;
+    }
+    if (in.failed()) {
+        std::cerr << "❌ Read error in WAV stream: " << label << std::endl;
+        return false;
+    }
+    if (!header.until_end && remaining > 0) {
+        std::cout << "⚠️ WAV stream ended " << remaining << " bytes before the declared data size" << std::endl;
+    }
+    return true;
+}
+
+#ifdef WHISPER_FFI_WITH_FLAC
+
+struct flac_stream {
+    byte_stream* in;
+    std::vector<float> pcm;
+};
+
+static FLAC__StreamDecoderReadStatus flac_read(const FLAC__StreamDecoder*, FLAC__byte buffer[], size_t* bytes,
+                                               void* client_data) {
+    flac_stream* stream = static_cast<flac_stream*>(client_data);
+    const int64_t n = *bytes > 0 ? stream->in->read_some(buffer, *bytes) : -1;
+    *bytes = n > 0 ? (size_t) n : 0;
+    if (n < 0) {
+        return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+    }
+    return n == 0 ? FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM : FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+}
+
+static FLAC__StreamDecoderWriteStatus flac_write(const FLAC__StreamDecoder*, const FLAC__Frame* frame,
+                                                 const FLAC__int32* const buffer[], void* client_data) {
+    flac_stream* stream = static_cast<flac_stream*>(client_data);
+    const unsigned channels = frame->header.channels;
+    const float scale = 1.0f / ((float) (1u << (frame->header.bits_per_sample - 1)) * channels);
+    for (unsigned i = 0; i < frame->header.blocksize; ++i) {
+        int64_t sum = 0;
+        for (unsigned c = 0; c < channels; ++c) {
+            sum += buffer[c][i];
+        }
+        stream->pcm.push_back(sum * scale);
+    }
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void flac_metadata(const FLAC__StreamDecoder*, const FLAC__StreamMetadata* metadata, void*) {
+    if (metadata->type == FLAC__METADATA_TYPE_STREAMINFO && metadata->data.stream_info.sample_rate != 16000) {
+        std::cout << "⚠️ Sample rate is " << metadata->data.stream_info.sample_rate
+                  << "Hz, Whisper expects 16kHz. Audio may not transcribe optimally." << std::endl;
+    }
+}
+
+static void flac_error(const FLAC__StreamDecoder*, FLAC__StreamDecoderErrorStatus status, void*) {
+    std::cerr << "⚠️ FLAC decode error: " << FLAC__StreamDecoderErrorStatusString[status] << std::endl;
+}
+
+static std::vector<float> decode_flac_stream(byte_stream& in, const std::string& label) {
+    FLAC__StreamDecoder* decoder = FLAC__stream_decoder_new();
+    if (!decoder) {
+        return {};
+    }
+    flac_stream stream{&in, {}};
+    // No seek, tell or length callbacks: the decoder only reads forward
+    bool ok = FLAC__stream_decoder_init_stream(decoder, flac_read, nullptr, nullptr, nullptr, nullptr, flac_write,
+                                               flac_metadata, flac_error, &stream) == FLAC__STREAM_DECODER_INIT_STATUS_OK;
+    ok = ok && FLAC__stream_decoder_process_until_end_of_stream(decoder);
+    ok = ok && FLAC__stream_decoder_get_state(decoder) == FLAC__STREAM_DECODER_END_OF_STREAM;
+    FLAC__stream_decoder_delete(decoder);
+    if (!ok) {
+        std::cerr << "❌ Failed to decode FLAC stream: " << label << std::endl;
+        return {};
+    }
+    return std::move(stream.pcm);
+}
+
+#else
+
+static std::vector<float> decode_flac_stream(byte_stream& in, const std::string& label) {
+    (void) in;
+    std::cerr << "❌ FLAC support not built in, cannot read " << label << std::endl;
+    return {};
+}
+
+#endif
+
+bool decode_audio_stream(const audio_read_fn& read, const std::string& label, std::vector<float>& pcm) {
+    pcm.clear();
+    byte_stream in(read);
+    unsigned char magic[4];
+    if (!in.read_exact(magic, sizeof(magic))) {
+        std::cerr << "❌ Audio stream too short or unreadable: " << label << std::endl;
+        return false;
+    }
+    in.unread(magic, sizeof(magic));
+
+    if (memcmp(magic, "RIFF", 4) == 0) {
+        if (!decode_wav_stream(in, label, pcm)) {
+            pcm.clear();
+        }
+    } else if (memcmp(magic, "OggS", 4) == 0) {
+        pcm = decode_ogg_opus([&in](void* buffer, size_t size) { return in.read_some(buffer, size); }, label);
+    } else if (memcmp(magic, "fLaC", 4) == 0) {
+        pcm = decode_flac_stream(in, label);
+    } else {
+        std::cerr << "❌ Unrecognized audio stream (WAV, Ogg Opus and FLAC supported): " << label << std::endl;
+        return false;
+    }
+
+    if (!pcm.empty()) {
+        std::cout << "✅ Decoded " << pcm.size() << " samples from " << label << std::endl;
+    }
+    return !pcm.empty();
+}
+
+std::vector<float> decode_audio_stream(const audio_read_fn& read, const std::string& label) {
+    std::vector<float> pcm;
+    decode_audio_stream(read, label, pcm);
+    return pcm;
+}
+
+audio_read_fn fd_reader(int fd) {
+    return [fd](void* buffer, size_t size) -> int64_t {
+#ifdef _WIN32
+        return _read(fd, buffer, (unsigned) std::min<size_t>(size, INT_MAX));
+#else
+        for (;;) {
+            const ssize_t n = ::read(fd, buffer, size);
+            if (n >= 0 || errno != EINTR) {
+                return n;
+            }
+        }
+#endif
+    };
+}
@@ -0,0 +1,70 @@
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+// Forward-only audio decoding from pipes, sockets and callbacks.
+//
+// read_audio_file needs a seekable path with an extension. Here the
+// container is recognized from its first bytes and parsed strictly front to
+// back, so audio can come straight from another process or a decompressor
+// without being spooled to a temporary file:
+//   - WAV: 16-bit PCM or 32-bit float, any channel count (downmixed). A RIFF
+//     or data size of 0 or 0xFFFFFFFF, as written by encoders that cannot
+//     seek back to patch the header, means "until the end of the stream".
+//   - Ogg Opus: needs WHISPER_FFI_WITH_OPUS
+//   - FLAC: needs WHISPER_FFI_WITH_FLAC (libFLAC)
+// Samples are converted as the bytes arrive; nothing is buffered but the
+// decoded PCM.
+//
+// WAV headers are parsed by read_wav_header alone, whether they come from a
+// stream here or from a file read_audio_file or read_audio_range seeks in.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Fills up to `size` bytes of `buffer`; returns the bytes read, 0 at the end
+// of the stream, negative on error. Short reads are fine.
+using audio_read_fn = std::function<int64_t(void* buffer, size_t size)>;
+
+// Decode a WAV, Ogg Opus or FLAC stream to mono float samples (empty on failure).
+// `label` names the stream in logs.
+std::vector<float> decode_audio_stream(const audio_read_fn& read, const std::string& label);
+
+// Same into `pcm` (cleared first, capacity kept); false when nothing was decoded
+bool decode_audio_stream(const audio_read_fn& read, const std::string& label, std::vector<float>& pcm);
+
+// Append the mono mix of n_frames interleaved WAV frames: 16-bit PCM
+// (format 1) or 32-bit float (format 3)
+void append_wav_frames(const unsigned char* data, size_t n_frames, uint16_t format, uint16_t channels,
+                       std::vector<float>& pcm);
+
+// WAV layout as declared by the RIFF header and the fmt and data chunks
+struct wav_header {
+    uint16_t format = 0; // 1 = PCM, 3 = float; an extensible file's sub-format
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t bits_per_sample = 0;
+    uint32_t data_size = 0;
+    // The writer never patched the sizes in: the data runs to the end
+    bool until_end = false;
+
+    size_t frame_bytes() const { return (size_t) channels * (bits_per_sample / 8); }
+};
+
+// Walk a WAV header front to back through `read` (exactly `size` bytes or
+// false) and `skip`, up to the start of the data chunk. False, logged, for
+// a malformed header or anything but 16-bit PCM or 32-bit float.
+bool read_wav_header(const std::function<bool(void* buffer, size_t size)>& read,
+                     const std::function<bool(uint64_t size)>& skip, const std::string& label, wav_header& header);
+
+// Frames [begin, end) of a WAV file, mono, appended to `pcm` after seeking to
+// the first one; end is clamped to the data in the file. False when the file
+// cannot be read or is not a supported WAV.
+bool read_wav_file(const std::string& path, size_t begin, size_t end, std::vector<float>& pcm);
+
+// Reader over a file descriptor (pipe, socket, regular file); the caller keeps ownership
+audio_read_fn fd_reader(int fd);
+
+#endif // AUDIO_STREAM_H
@@ -0,0 +1,180 @@
+// CPU backend benchmark
+//
+// Times the encoder alone (mel + encode on a fresh state, where the matrix
+// backend does nearly all of the work) and a full sequential transcription
+// of the same clip with the same thread count, over several iterations after
+// one warm-up pass. The thread count defaults to the CPUs the process may use
+// (affinity and cgroup quota applied). The last line is machine readable;
+// build_whisper.sh --compare-blas collects it from one build per backend.
+//
+// Usage: bench_backend <model.bin> <audio.wav> [iterations] [n_threads]
+//
+// The clip must be 16 kHz mono 16-bit PCM WAV, the encoder input format.
+//
+//   RESULT backend=<name> threads=<n> encode_ms=<median> transcribe_ms=<median>
+
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+// "blas: <name> | ..." as reported by whisper_ffi_system_info
+static std::string backend_name(const char* info) {
+    const std::string text(info);
+    const std::string prefix = "blas: ";
+    if (text.compare(0, prefix.size(), prefix) != 0) {
+        return "unknown";
+    }
+    const size_t end = text.find(' ', prefix.size());
+    return text.substr(prefix.size(), end == std::string::npos ? std::string::npos : end - prefix.size());
+}
+
+static uint32_t read_le(const unsigned char* bytes, int n) {
+    uint32_t value = 0;
+    for (int i = n - 1; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Samples of a 16 kHz mono 16-bit PCM WAV; empty for anything else
+static std::vector<float> read_wav_16k_mono(const char* path) {
+    std::vector<float> pcm;
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return pcm;
+    }
+    unsigned char header[12];
+    bool format_ok = false;
+    if (fread(header, 1, sizeof(header), file) == sizeof(header) && memcmp(header, "RIFF", 4) == 0 &&
+        memcmp(header + 8, "WAVE", 4) == 0) {
+        unsigned char chunk[8];
+        while (fread(chunk, 1, sizeof(chunk), file) == sizeof(chunk)) {
+            const uint32_t size = read_le(chunk + 4, 4);
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+                unsigned char fmt[16];
+                if (fread(fmt, 1, sizeof(fmt), file) != sizeof(fmt)) {
+                    break;
+                }
+                format_ok = read_le(fmt, 2) == 1 && read_le(fmt + 2, 2) == 1 &&
+                            read_le(fmt + 4, 4) == WHISPER_SAMPLE_RATE && read_le(fmt + 14, 2) == 16;
+                fseek(file, (long) (size - 16 + (size & 1)), SEEK_CUR);
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                if (format_ok) {
+                    std::vector<int16_t> samples(size / 2);
+                    samples.resize(fread(samples.data(), 2, samples.size(), file));
+                    pcm.reserve(samples.size());
+                    for (int16_t sample : samples) {
+                        pcm.push_back(sample / 32768.0f);
+                    }
+                }
+                break;
+            } else {
+                fseek(file, (long) (size + (size & 1)), SEEK_CUR);
+            }
+        }
+    }
+    fclose(file);
+    return pcm;
+}
+
+// Mel + encoder over the first 30 s window of the clip
+static bool time_encode(whisper_context* ctx, const std::vector<float>& pcm, int n_threads, double& ms) {
+    whisper_state* state = whisper_init_state(ctx);
+    if (!state) {
+        return false;
+    }
+    const int n_samples = (int) std::min<size_t>(pcm.size(), (size_t) WHISPER_SAMPLE_RATE * WHISPER_CHUNK_SIZE);
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = whisper_pcm_to_mel_with_state(ctx, state, pcm.data(), n_samples, n_threads) == 0 &&
+                    whisper_encode_with_state(ctx, state, 0, n_threads) == 0;
+    ms = elapsed_ms(start);
+    whisper_free_state(state);
+    return ok;
+}
+
+// One sequential decode on n_threads, as in time_encode
+static bool time_transcribe(whisper_context* ctx, const char* audio_path, int n_threads, double& ms) {
+    whisper_ffi_transcribe_params params = whisper_ffi_transcribe_default_params();
+    params.encoder_batch = 1;
+    params.n_threads = n_threads;
+    const auto start = std::chrono::steady_clock::now();
+    char* result = whisper_ffi_transcribe_with_params(ctx, audio_path, &params);
+    ms = elapsed_ms(start);
+    if (!result) {
+        return false;
+    }
+    whisper_ffi_free_string(result);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <model.bin> <audio.wav> [iterations] [n_threads]\n", argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+    const char* audio_path = argv[2];
+    const int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 5;
+    // The budget starts out at the available CPUs
+    const int n_threads = argc > 4 ? std::max(1, atoi(argv[4])) : whisper_ffi_thread_budget();
+
+    const char* info = whisper_ffi_system_info();
+    printf("system: %s\n", info);
+    printf("threads: %d\n", n_threads);
+
+    const std::vector<float> pcm = read_wav_16k_mono(audio_path);
+    if (pcm.empty()) {
+        fprintf(stderr, "failed to read %s (16 kHz mono 16-bit PCM WAV expected)\n", audio_path);
+        return 1;
+    }
+
+    whisper_context* ctx = whisper_ffi_init(model_path);
+    if (!ctx) {
+        fprintf(stderr, "failed to load %s\n", model_path);
+        return 1;
+    }
+
+    std::vector<double> encode_ms;
+    std::vector<double> transcribe_ms;
+    bool ok = true;
+    // Iteration 0 warms caches and thread pools and is not recorded
+    for (int i = 0; i <= iterations && ok; ++i) {
+        double encode = 0.0;
+        double transcribe = 0.0;
+        ok = time_encode(ctx, pcm, n_threads, encode) && time_transcribe(ctx, audio_path, n_threads, transcribe);
+        if (ok && i > 0) {
+            encode_ms.push_back(encode);
+            transcribe_ms.push_back(transcribe);
+            printf("run %d: encode %.1f ms, transcribe %.1f ms\n", i, encode, transcribe);
+        }
+    }
+    whisper_ffi_free(ctx);
+
+    if (!ok) {
+        fprintf(stderr, "benchmark run failed\n");
+        return 1;
+    }
+
+    printf("RESULT backend=%s threads=%d encode_ms=%.1f transcribe_ms=%.1f\n", backend_name(info).c_str(), n_threads,
+           median(encode_ms), median(transcribe_ms));
+    return 0;
+}
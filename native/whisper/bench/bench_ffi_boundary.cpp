@@ -0,0 +1,183 @@
+// Native baselines for the FFI boundary benchmark
+//
+// Does in C++ what benchmark/ffi_boundary_benchmark.dart does across the
+// Dart<->native boundary: the same probe calls, path copies, file checks,
+// result copies, sample buffers, callbacks and cross-thread messages, with
+// the same row names, so the difference between the two tables is the cost
+// of the boundary itself.
+//
+// Usage: bench_ffi_boundary [audio file] [iterations]
+
+#include "whisper_wrapper.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int ROUNDS = 7;
+static const int64_t CALLBACKS_PER_OP = 1000;
+static const size_t SAMPLES_30S = 30 * 16000;
+
+// Keeps results alive so the optimizer cannot drop the measured work
+static volatile int64_t sink;
+
+// Median over ROUNDS of the time per call of `body`, in ns
+static void measure(const char* name, int64_t iterations, int64_t ops_per_call, const std::function<void()>& body) {
+    for (int64_t i = 0; i < iterations / 10 + 1; ++i) {
+        body();
+    }
+    std::vector<double> rounds;
+    for (int r = 0; r < ROUNDS; ++r) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int64_t i = 0; i < iterations; ++i) {
+            body();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        rounds.push_back(std::chrono::duration<double, std::nano>(end - start).count() / (iterations * ops_per_call));
+    }
+    std::sort(rounds.begin(), rounds.end());
+    printf("%-36s %12.1f ns/op\n", name, rounds[ROUNDS / 2]);
+}
+
+static void count_callback(int64_t value) {
+    sink = value;
+}
+
+// Single-consumer queue standing in for a Dart isolate's port
+class message_port {
+public:
+    message_port() : consumer([this] { run(); }) {}
+
+    ~message_port() {
+        post(-1);
+        consumer.join();
+    }
+
+    void post(int64_t value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(value);
+        }
+        ready.notify_one();
+    }
+
+    // Block until `count` messages have been handled since the last call
+    void wait_for(int64_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [&] { return handled >= count; });
+        handled = 0;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            ready.wait(lock, [&] { return !queue.empty(); });
+            while (!queue.empty()) {
+                const int64_t value = queue.front();
+                queue.pop_front();
+                if (value < 0) {
+                    return;
+                }
+                ++handled;
+            }
+            drained.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable drained;
+    std::deque<int64_t> queue;
+    int64_t handled = 0;
+    std::thread consumer;
+};
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : argv[0];
+    const int64_t iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 100000;
+
+    printf("iterations: %lld, file: %s\n\n", (long long) iterations, path.c_str());
+
+    measure("call noop", iterations, 1, [] { whisper_ffi_probe_noop(); });
+
+    // toNativeUtf8 + malloc.free
+    measure("path copy+free", iterations, 1, [&] {
+        char* copy = (char*) malloc(path.size() + 1);
+        memcpy(copy, path.c_str(), path.size() + 1);
+        sink = copy[0];
+        free(copy);
+    });
+    measure("call with path", iterations, 1, [&] {
+        char* copy = (char*) malloc(path.size() + 1);
+        memcpy(copy, path.c_str(), path.size() + 1);
+        sink = whisper_ffi_probe_string(copy);
+        free(copy);
+    });
+
+    // File.exists + File.length in transcribeAudio are one stat each
+    measure("file exists+length", iterations / 10, 1, [&] {
+        struct stat info;
+        sink = stat(path.c_str(), &info) == 0;
+        sink = stat(path.c_str(), &info) == 0 ? (int64_t) info.st_size : -1;
+    });
+    measure("file stat", iterations / 10, 1, [&] {
+        struct stat info;
+        sink = stat(path.c_str(), &info) == 0 ? (int64_t) info.st_size : -1;
+    });
+
+    // toDartString decodes into a new string
+    for (int n_segments : {20, 500}) {
+        char* result = whisper_ffi_probe_result(n_segments);
+        const std::string label = "result copy (" + std::to_string(n_segments) + " segs, " +
+                                  std::to_string(strlen(result)) + " B)";
+        measure(label.c_str(), std::max<int64_t>(1, iterations / n_segments), 1, [&] {
+            std::string copy(result);
+            sink = (int64_t) copy.size();
+        });
+        whisper_ffi_free_string(result);
+    }
+    measure("result alloc+free (20 segs)", iterations / 20, 1, [] {
+        whisper_ffi_free_string(whisper_ffi_probe_result(20));
+    });
+
+    // 30 s of 16 kHz audio copied into a malloc'd buffer vs read in place
+    const std::vector<float> samples(SAMPLES_30S, 0.25f);
+    measure("samples copy+sum (30 s)", iterations / 1000 + 1, 1, [&] {
+        float* buffer = (float*) malloc(sizeof(float) * samples.size());
+        memcpy(buffer, samples.data(), sizeof(float) * samples.size());
+        sink = (int64_t) whisper_ffi_probe_sum(buffer, (int64_t) samples.size());
+        free(buffer);
+    });
+    measure("samples view sum (30 s)", iterations / 1000 + 1, 1, [&] {
+        sink = (int64_t) whisper_ffi_probe_sum(samples.data(), (int64_t) samples.size());
+    });
+
+    measure("callback (per call)", iterations / CALLBACKS_PER_OP + 1, CALLBACKS_PER_OP, [] {
+        whisper_ffi_probe_call(count_callback, CALLBACKS_PER_OP);
+    });
+
+    // NativeCallable.listener posts each call to the isolate's port
+    message_port port;
+    measure("post to port (per message)", iterations / CALLBACKS_PER_OP + 1, CALLBACKS_PER_OP, [&] {
+        std::thread poster([&] {
+            for (int64_t i = 0; i < CALLBACKS_PER_OP; ++i) {
+                port.post(i);
+            }
+        });
+        poster.join();
+        port.wait_for(CALLBACKS_PER_OP);
+    });
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Word timestamp overhead benchmark
+//
+// Transcribes the same file with a plain context and with a context that
+// tracks DTW alignment heads, alternating runs so both see the same thermal
+// and cache conditions, and reports the cost of producing word timings.
+//
+// Usage: bench_word_timestamps <model.bin> <audio.wav> [iterations] [n_threads]
+
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double run_once(whisper_context* ctx, const char* audio_path, const whisper_ffi_transcribe_params& params,
+                       size_t& result_bytes) {
+    const auto start = std::chrono::steady_clock::now();
+    char* result = whisper_ffi_transcribe_json(ctx, audio_path, &params);
+    const auto end = std::chrono::steady_clock::now();
+    if (!result) {
+        fprintf(stderr, "transcription failed\n");
+        exit(1);
+    }
+    result_bytes = std::string(result).size();
+    whisper_ffi_free_string(result);
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <model.bin> <audio.wav> [iterations] [n_threads]\n", argv[0]);
+        return 1;
+    }
+    const char* model_path = argv[1];
+    const char* audio_path = argv[2];
+    const int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 5;
+
+    whisper_ffi_init_params plain_init = whisper_ffi_init_default_params();
+    whisper_ffi_init_params dtw_init = whisper_ffi_init_default_params();
+    dtw_init.word_timestamps = true;
+
+    whisper_context* plain_ctx = whisper_ffi_init_with_params(model_path, &plain_init);
+    whisper_context* dtw_ctx = whisper_ffi_init_with_params(model_path, &dtw_init);
+    if (!plain_ctx || !dtw_ctx) {
+        fprintf(stderr, "failed to load model: %s\n", model_path);
+        return 1;
+    }
+
+    whisper_ffi_transcribe_params plain = whisper_ffi_transcribe_default_params();
+    whisper_ffi_transcribe_params words = whisper_ffi_transcribe_default_params();
+    words.word_timestamps = true;
+    if (argc > 4) {
+        plain.n_threads = words.n_threads = atoi(argv[4]);
+    }
+
+    // Warm-up: allocate states and fault in model weights for both contexts
+    size_t plain_bytes = 0;
+    size_t words_bytes = 0;
+    run_once(plain_ctx, audio_path, plain, plain_bytes);
+    run_once(dtw_ctx, audio_path, words, words_bytes);
+
+    std::vector<double> plain_ms;
+    std::vector<double> words_ms;
+    for (int i = 0; i < iterations; ++i) {
+        plain_ms.push_back(run_once(plain_ctx, audio_path, plain, plain_bytes));
+        words_ms.push_back(run_once(dtw_ctx, audio_path, words, words_bytes));
+    }
+
+    const double plain_median = median(plain_ms);
+    const double words_median = median(words_ms);
+    printf("iterations:          %d\n", iterations);
+    printf("segments only:       %8.1f ms (median), %zu bytes of JSON\n", plain_median, plain_bytes);
+    printf("with word timings:   %8.1f ms (median), %zu bytes of JSON\n", words_median, words_bytes);
+    printf("overhead:            %+8.1f ms (%+.1f%%)\n", words_median - plain_median,
+           100.0 * (words_median - plain_median) / plain_median);
+
+    whisper_ffi_free(plain_ctx);
+    whisper_ffi_free(dtw_ctx);
+    return 0;
+}
@@ -0,0 +1,388 @@
+// Concurrent soak benchmark for the C API
+//
+// Drives whisper_ffi_init / whisper_ffi_transcribe / whisper_ffi_free from
+// many threads for a fixed duration, picking clips from the given mix at
+// random. Every interval it prints throughput, latency percentiles from an
+// HDR-style histogram and resident memory; at the end it compares the last
+// intervals against the first ones after warm-up and exits non-zero when
+// throughput, tail latency or RSS drifted past the limits.
+//
+// Usage: soak_bench <model.bin> <clip>... [--threads N] [--duration S]
+//                   [--interval S] [--warmup S] [--churn N]
+//                   [--max-drift PCT] [--max-rss-growth MB]
+//
+//   --churn N   each worker frees and re-creates its context every N clips
+//               (0 = keep one context per worker for the whole run)
+
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+// Log-linear histogram with the HdrHistogram bucket layout: values below
+// 2^SUB_BITS are counted exactly, every power-of-two range above is split
+// into 2^(SUB_BITS - 1) linear buckets (under 1% relative error). Recording
+// is a couple of shifts, so workers can record every call.
+struct hdr_histogram {
+    static constexpr int SUB_BITS = 7;
+    static constexpr uint64_t SUB_COUNT = 1ull << SUB_BITS;
+    static constexpr uint64_t HALF_COUNT = SUB_COUNT / 2;
+    static constexpr int MAX_SHIFT = 40;
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+
+    hdr_histogram() : counts(SUB_COUNT + MAX_SHIFT * HALF_COUNT, 0) {}
+
+    static size_t index_of(uint64_t value) {
+        if (value < SUB_COUNT) {
+            return (size_t) value;
+        }
+        int msb = 0;
+        while ((value >> (msb + 1)) != 0) {
+            ++msb;
+        }
+        const int shift = std::min(msb - (SUB_BITS - 1), MAX_SHIFT);
+        const uint64_t sub = std::min(value >> shift, SUB_COUNT - 1);
+        return (size_t) (SUB_COUNT + (uint64_t) (shift - 1) * HALF_COUNT + (sub - HALF_COUNT));
+    }
+
+    // Highest value that lands in bucket `index`
+    static uint64_t value_at(size_t index) {
+        if (index < SUB_COUNT) {
+            return index;
+        }
+        const uint64_t k = index - SUB_COUNT;
+        const int shift = (int) (k / HALF_COUNT) + 1;
+        const uint64_t sub = k % HALF_COUNT + HALF_COUNT;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t value) {
+        ++counts[index_of(value)];
+        ++total;
+        max_value = std::max(max_value, value);
+    }
+
+    void add(const hdr_histogram& other) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        max_value = std::max(max_value, other.max_value);
+    }
+
+    void reset() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        max_value = 0;
+    }
+
+    uint64_t percentile(double p) const {
+        if (total == 0) {
+            return 0;
+        }
+        const uint64_t target = std::max<uint64_t>(1, (uint64_t) (p / 100.0 * total + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return std::min(value_at(i), max_value);
+            }
+        }
+        return max_value;
+    }
+};
+
+struct soak_options {
+    std::string model_path;
+    std::vector<std::string> clips;
+    int threads = 4;
+    int duration_s = 600;
+    int interval_s = 10;
+    int warmup_s = 30;
+    int churn = 20;
+    double max_drift_pct = 15.0;
+    double max_rss_growth_mb = 64.0;
+};
+
+// Per-worker counters, swapped out by the reporter each interval
+struct worker_stats {
+    std::mutex mutex;
+    hdr_histogram latency_us;
+    uint64_t clips = 0;
+    uint64_t audio_ms = 0;
+    uint64_t errors = 0;
+    uint64_t inits = 0;
+};
+
+struct interval_report {
+    double t_s;
+    double clips_per_s;
+    double audio_x;          // Seconds of audio per wall-clock second
+    uint64_t p50_us;
+    uint64_t p99_us;
+    double rss_mb;
+};
+
+static double resident_mb() {
+#if defined(__linux__)
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0.0;
+    }
+    long pages = 0;
+    long resident = 0;
+    const int n = fscanf(statm, "%ld %ld", &pages, &resident);
+    fclose(statm);
+    return n == 2 ? resident * (double) sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0) : 0.0;
+#else
+    return 0.0;
+#endif
+}
+
+// Clip length from a canonical 16 kHz mono 16-bit WAV header size; other
+// formats count as zero audio and only show up in clips/s
+static uint64_t clip_audio_ms(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fclose(file);
+    const size_t ext = path.find_last_of('.');
+    if (ext == std::string::npos || path.compare(ext, 4, ".wav") != 0 || size <= 44) {
+        return 0;
+    }
+    return (uint64_t) (size - 44) / 32;
+}
+
+static bool parse_options(int argc, char** argv, soak_options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (strcmp(arg, "--threads") == 0 && has_value) {
+            options.threads = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--duration") == 0 && has_value) {
+            options.duration_s = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--interval") == 0 && has_value) {
+            options.interval_s = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+            options.warmup_s = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(arg, "--churn") == 0 && has_value) {
+            options.churn = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(arg, "--max-drift") == 0 && has_value) {
+            options.max_drift_pct = atof(argv[++i]);
+        } else if (strcmp(arg, "--max-rss-growth") == 0 && has_value) {
+            options.max_rss_growth_mb = atof(argv[++i]);
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+        } else if (options.model_path.empty()) {
+            options.model_path = arg;
+        } else {
+            options.clips.push_back(arg);
+        }
+    }
+    return !options.model_path.empty() && !options.clips.empty();
+}
+
+static void worker(const soak_options& options, const std::vector<uint64_t>& clip_ms, unsigned seed,
+                   std::atomic<bool>& running, worker_stats& stats) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, options.clips.size() - 1);
+    whisper_context* ctx = nullptr;
+    int clips_on_ctx = 0;
+
+    while (running) {
+        if (!ctx || (options.churn > 0 && clips_on_ctx >= options.churn)) {
+            if (ctx) {
+                whisper_ffi_free(ctx);
+            }
+            ctx = whisper_ffi_init(options.model_path.c_str());
+            clips_on_ctx = 0;
+            std::lock_guard<std::mutex> lock(stats.mutex);
+            ++stats.inits;
+            if (!ctx) {
+                ++stats.errors;
+                return;
+            }
+        }
+
+        const size_t clip = pick(rng);
+        const auto start = std::chrono::steady_clock::now();
+        char* result = whisper_ffi_transcribe(ctx, options.clips[clip].c_str());
+        const auto end = std::chrono::steady_clock::now();
+        whisper_ffi_free_string(result);
+        ++clips_on_ctx;
+
+        std::lock_guard<std::mutex> lock(stats.mutex);
+        if (!result) {
+            ++stats.errors;
+            continue;
+        }
+        stats.latency_us.record((uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        ++stats.clips;
+        stats.audio_ms += clip_ms[clip];
+    }
+
+    if (ctx) {
+        whisper_ffi_free(ctx);
+    }
+}
+
+static double mean_of(const std::vector<interval_report>& reports, size_t begin, size_t end,
+                      double interval_report::*field) {
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) {
+        sum += reports[i].*field;
+    }
+    return end > begin ? sum / (end - begin) : 0.0;
+}
+
+int main(int argc, char** argv) {
+    soak_options options;
+    if (!parse_options(argc, argv, options)) {
+        fprintf(stderr,
+                "usage: %s <model.bin> <clip>... [--threads N] [--duration S] [--interval S] [--warmup S]\n"
+                "       [--churn N] [--max-drift PCT] [--max-rss-growth MB]\n",
+                argv[0]);
+        return 1;
+    }
+
+    std::vector<uint64_t> clip_ms;
+    for (const std::string& clip : options.clips) {
+        clip_ms.push_back(clip_audio_ms(clip));
+    }
+
+    printf("soak: %d threads, %d s (%d s warm-up), %zu clips, churn every %d clips\n", options.threads,
+           options.duration_s, options.warmup_s, options.clips.size(), options.churn);
+    printf("%8s %9s %8s %10s %10s %10s %10s %9s\n", "t(s)", "clips/s", "audio x", "p50(ms)", "p90(ms)", "p99(ms)",
+           "max(ms)", "rss(MB)");
+
+    std::atomic<bool> running(true);
+    std::vector<std::unique_ptr<worker_stats>> stats;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.threads; ++i) {
+        stats.emplace_back(new worker_stats());
+        workers.emplace_back(worker, std::cref(options), std::cref(clip_ms), 1234u + i, std::ref(running),
+                             std::ref(*stats.back()));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    hdr_histogram total_latency;
+    hdr_histogram interval_latency;
+    std::vector<interval_report> reports;
+    uint64_t total_clips = 0;
+    uint64_t total_errors = 0;
+    uint64_t total_inits = 0;
+
+    for (int elapsed = 0; elapsed < options.duration_s;) {
+        const int step = std::min(options.interval_s, options.duration_s - elapsed);
+        std::this_thread::sleep_for(std::chrono::seconds(step));
+        elapsed += step;
+
+        interval_latency.reset();
+        uint64_t clips = 0;
+        uint64_t audio_ms = 0;
+        for (std::unique_ptr<worker_stats>& s : stats) {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            interval_latency.add(s->latency_us);
+            s->latency_us.reset();
+            clips += s->clips;
+            audio_ms += s->audio_ms;
+            total_errors += s->errors;
+            total_inits += s->inits;
+            s->clips = s->audio_ms = s->errors = s->inits = 0;
+        }
+        total_latency.add(interval_latency);
+        total_clips += clips;
+
+        const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        interval_report report = {t, clips / (double) step, audio_ms / 1000.0 / step, interval_latency.percentile(50),
+                                  interval_latency.percentile(99), resident_mb()};
+        reports.push_back(report);
+        printf("%8.0f %9.2f %8.2f %10.1f %10.1f %10.1f %10.1f %9.1f\n", t, report.clips_per_s, report.audio_x,
+               report.p50_us / 1000.0, interval_latency.percentile(90) / 1000.0, report.p99_us / 1000.0,
+               interval_latency.max_value / 1000.0, report.rss_mb);
+        fflush(stdout);
+    }
+
+    running = false;
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    printf("\ntotal: %llu clips, %llu context inits, %llu errors\n", (unsigned long long) total_clips,
+           (unsigned long long) total_inits, (unsigned long long) total_errors);
+    printf("latency (ms): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", total_latency.percentile(50) / 1000.0,
+           total_latency.percentile(90) / 1000.0, total_latency.percentile(99) / 1000.0,
+           total_latency.percentile(99.9) / 1000.0, total_latency.max_value / 1000.0);
+
+    // Drift: first quarter after warm-up against the last quarter of the run
+    bool failed = total_errors > 0;
+    if (total_errors > 0) {
+        printf("FAIL: %llu errors\n", (unsigned long long) total_errors);
+    }
+
+    size_t first = 0;
+    while (first < reports.size() && reports[first].t_s <= options.warmup_s) {
+        ++first;
+    }
+    const size_t span = (reports.size() - first) / 4;
+    if (span == 0) {
+        printf("note: run too short after warm-up for drift checks\n");
+        return failed ? 1 : 0;
+    }
+    const size_t last = reports.size() - span;
+
+    const double base_rate = mean_of(reports, first, first + span, &interval_report::clips_per_s);
+    const double end_rate = mean_of(reports, last, reports.size(), &interval_report::clips_per_s);
+    const double rate_drift = base_rate > 0.0 ? (base_rate - end_rate) / base_rate * 100.0 : 0.0;
+
+    double base_p99 = 0.0;
+    double end_p99 = 0.0;
+    for (size_t i = first; i < first + span; ++i) {
+        base_p99 += (double) reports[i].p99_us / span;
+    }
+    for (size_t i = last; i < reports.size(); ++i) {
+        end_p99 += (double) reports[i].p99_us / span;
+    }
+    const double p99_drift = base_p99 > 0.0 ? (end_p99 - base_p99) / base_p99 * 100.0 : 0.0;
+
+    const double rss_growth = reports.back().rss_mb - reports[first].rss_mb;
+
+    printf("drift: throughput %+.1f%%, p99 %+.1f%%, rss %+.1f MB\n", -rate_drift, p99_drift, rss_growth);
+    if (rate_drift > options.max_drift_pct) {
+        printf("FAIL: throughput dropped %.1f%% (limit %.1f%%)\n", rate_drift, options.max_drift_pct);
+        failed = true;
+    }
+    if (p99_drift > options.max_drift_pct) {
+        printf("FAIL: p99 latency grew %.1f%% (limit %.1f%%)\n", p99_drift, options.max_drift_pct);
+        failed = true;
+    }
+    if (rss_growth > options.max_rss_growth_mb) {
+        printf("FAIL: RSS grew %.1f MB after warm-up (limit %.1f MB)\n", rss_growth, options.max_rss_growth_mb);
+        failed = true;
+    }
+    if (!failed) {
+        printf("PASS\n");
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+#include "whisper_wrapper.h"
+#include "whisper_ffi_internal.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// Only exported from benchmark builds (WHISPER_FFI_WITH_PROBES)
+#ifdef WHISPER_FFI_WITH_PROBES
+
+// Typical segment of a voice memo
+static const char PROBE_SEGMENT_TEXT[] = " So the plan for tomorrow is to finish the draft and send it over by noon.";
+static const int64_t PROBE_SEGMENT_MS = 4200;
+
+extern "C" {
+
+void whisper_ffi_probe_noop(void) {}
+
+int64_t whisper_ffi_probe_string(const char* str) {
+    return str ? (int64_t) strlen(str) : -1;
+}
+
+char* whisper_ffi_probe_result(int n_segments) {
+    try {
+        std::vector<ffi_segment> segments(std::max(0, n_segments));
+        for (size_t i = 0; i < segments.size(); ++i) {
+            segments[i].t0_ms = (int64_t) i * PROBE_SEGMENT_MS;
+            segments[i].t1_ms = (int64_t) (i + 1) * PROBE_SEGMENT_MS;
+            segments[i].text = PROBE_SEGMENT_TEXT;
+            segments[i].p = 0.9f;
+        }
+        return result_to_c_string(segments);
+    } catch (...) {
+        std::cerr << "💥 Exception building probe result" << std::endl;
+        return nullptr;
+    }
+}
+
+double whisper_ffi_probe_sum(const float* samples, int64_t n) {
+    double sum = 0.0;
+    for (int64_t i = 0; samples && i < n; ++i) {
+        sum += samples[i];
+    }
+    return sum;
+}
+
+void whisper_ffi_probe_call(whisper_ffi_probe_callback callback, int64_t n) {
+    for (int64_t i = 0; callback && i < n; ++i) {
+        callback(i);
+    }
+}
+
+void whisper_ffi_probe_post(whisper_ffi_probe_callback callback, int64_t n) {
+    if (!callback) {
+        return;
+    }
+    try {
+        std::thread poster([callback, n] {
+            for (int64_t i = 0; i < n; ++i) {
+                callback(i);
+            }
+        });
+        poster.join();
+    } catch (...) {
+        std::cerr << "💥 Exception starting probe thread" << std::endl;
+    }
+}
+
+}
+
+#endif // WHISPER_FFI_WITH_PROBES
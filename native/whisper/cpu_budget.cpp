@@ -0,0 +1,215 @@
+#include "cpu_budget.h"
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// Path of the cgroup for `controller` ("" = the v2 unified hierarchy) in a
+// /proc/<pid>/cgroup file
+static std::string cgroup_path(const std::string& proc_cgroup, const std::string& controller) {
+    std::ifstream file(proc_cgroup);
+    std::string line;
+    while (std::getline(file, line)) {
+        // hierarchy-id:controller-list:path
+        const size_t first = line.find(':');
+        const size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        std::stringstream controllers(line.substr(first + 1, second - first - 1));
+        std::string name;
+        bool match = controller.empty() && second == first + 1;
+        while (!match && std::getline(controllers, name, ',')) {
+            match = name == controller;
+        }
+        if (match) {
+            return line.substr(second + 1);
+        }
+    }
+    return "/";
+}
+
+// First readable file among the process's own cgroup and the mount root
+// (inside a container's cgroup namespace both point to the same place)
+static std::ifstream open_cgroup_file(const std::string& proc_cgroup, const std::string& mount,
+                                      const std::string& controller, const std::string& name) {
+    std::ifstream file(mount + cgroup_path(proc_cgroup, controller) + "/" + name);
+    if (!file) {
+        file.open(mount + "/" + name);
+    }
+    return file;
+}
+
+double cgroup_quota_cpus(const std::string& proc_cgroup, const std::string& cgroup_root) {
+    // v2: "max 100000" or "<quota> <period>"
+    std::ifstream v2 = open_cgroup_file(proc_cgroup, cgroup_root, "", "cpu.max");
+    std::string quota;
+    double period = 0.0;
+    if (v2 >> quota >> period) {
+        return quota == "max" || period <= 0.0 ? 0.0 : std::strtod(quota.c_str(), nullptr) / period;
+    }
+
+    // v1: cfs_quota_us is -1 when unlimited
+    for (const char* controllers : {"/cpu", "/cpu,cpuacct"}) {
+        const std::string mount = cgroup_root + controllers;
+        std::ifstream quota_file = open_cgroup_file(proc_cgroup, mount, "cpu", "cpu.cfs_quota_us");
+        std::ifstream period_file = open_cgroup_file(proc_cgroup, mount, "cpu", "cpu.cfs_period_us");
+        double quota_us = 0.0;
+        double period_us = 0.0;
+        if (quota_file >> quota_us && period_file >> period_us) {
+            return quota_us <= 0.0 || period_us <= 0.0 ? 0.0 : quota_us / period_us;
+        }
+    }
+    return 0.0;
+}
+
+// Hardware threads, narrowed to the cpuset we may run on and the CFS quota
+// of our cgroup. A 4 CPU pod on a 64 core node gets 4: more threads would
+// only burn the quota early in each period and sit throttled for the rest.
+static int detect_available_cpus() {
+    const int hardware = (int) std::max(1u, std::thread::hardware_concurrency());
+    int cpus = hardware;
+#if defined(__linux__)
+    cpu_set_t set;
+    int cpuset = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        cpuset = CPU_COUNT(&set);
+        cpus = std::min(cpus, std::max(1, cpuset));
+    }
+    const double quota = cgroup_quota_cpus("/proc/self/cgroup", "/sys/fs/cgroup");
+    if (quota > 0.0) {
+        // A fractional quota still leaves room for the thread that rounds it up
+        cpus = std::min(cpus, std::max(1, (int) std::ceil(quota)));
+    }
+    std::cerr << "🧮 Compute threads: " << cpus << " (hardware " << hardware << ", cpuset " << cpuset
+              << ", cgroup quota ";
+    if (quota > 0.0) {
+        std::cerr << quota << " CPUs)" << std::endl;
+    } else {
+        std::cerr << "none)" << std::endl;
+    }
+#endif
+    return cpus;
+}
+
+int available_cpus() {
+    static const int cpus = detect_available_cpus();
+    return cpus;
+}
+
+int default_decode_threads() {
+    // whisper.cpp's own default, applied to the CPUs we actually have
+    return std::min(4, available_cpus());
+}
+
+struct budget_state {
+    std::mutex mutex;
+    std::condition_variable freed;
+    int total = 0; // Resolved to available_cpus() on first use
+    int leased = 0;
+    int holders = 0;
+    // Ticket queues per lease_priority: callers are served in arrival order,
+    // normal ones only while no high-priority caller is waiting
+    uint64_t next_ticket[2] = {0, 0};
+    uint64_t serving[2] = {0, 0};
+};
+
+static budget_state g_budget;
+
+// Caller holds g_budget.mutex
+static void resolve_budget_locked() {
+    if (g_budget.total == 0) {
+        g_budget.total = available_cpus();
+    }
+}
+
+static void release_threads(int threads) {
+    {
+        std::lock_guard<std::mutex> lock(g_budget.mutex);
+        g_budget.leased -= threads;
+        --g_budget.holders;
+    }
+    g_budget.freed.notify_all();
+}
+
+thread_lease::~thread_lease() {
+    if (threads_ > 0) {
+        release_threads(threads_);
+    }
+}
+
+thread_lease& thread_lease::operator=(thread_lease&& other) noexcept {
+    if (this != &other) {
+        if (threads_ > 0) {
+            release_threads(threads_);
+        }
+        threads_ = std::exchange(other.threads_, 0);
+    }
+    return *this;
+}
+
+static int queued(lease_priority priority) {
+    const int queue = (int) priority;
+    return (int) (g_budget.next_ticket[queue] - g_budget.serving[queue]);
+}
+
+thread_lease lease_threads(int wanted, lease_priority priority) {
+    std::unique_lock<std::mutex> lock(g_budget.mutex);
+    resolve_budget_locked();
+    const int queue = (int) priority;
+    const uint64_t ticket = g_budget.next_ticket[queue]++;
+    g_budget.freed.wait(lock, [ticket, queue, priority] {
+        return g_budget.serving[queue] == ticket && g_budget.leased < g_budget.total &&
+               (priority == lease_priority::high || queued(lease_priority::high) == 0);
+    });
+
+    // Share the budget between current holders and everyone still queued
+    const int waiting = queued(lease_priority::high) + queued(lease_priority::normal);
+    const int fair_share = std::max(1, g_budget.total / (g_budget.holders + waiting));
+    const int granted = std::max(1, std::min({wanted, fair_share, g_budget.total - g_budget.leased}));
+
+    g_budget.leased += granted;
+    ++g_budget.holders;
+    ++g_budget.serving[queue];
+    lock.unlock();
+    g_budget.freed.notify_all(); // Next ticket may fit in what is left
+    return thread_lease(granted);
+}
+
+void set_thread_budget(int n_threads) {
+    {
+        std::lock_guard<std::mutex> lock(g_budget.mutex);
+        g_budget.total = n_threads > 0 ? n_threads : available_cpus();
+    }
+    g_budget.freed.notify_all();
+}
+
+int thread_budget() {
+    std::lock_guard<std::mutex> lock(g_budget.mutex);
+    resolve_budget_locked();
+    return g_budget.total;
+}
+
+extern "C" {
+
+void whisper_ffi_set_thread_budget(int n_threads) {
+    set_thread_budget(n_threads);
+}
+
+int whisper_ffi_thread_budget(void) {
+    return thread_budget();
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef CPU_BUDGET_H
+#define CPU_BUDGET_H
+
+// Process-wide budget of compute threads.
+//
+// ggml starts n_threads workers for every graph it computes, so each
+// concurrent whisper_full on its own state would bring a full set of threads
+// and oversubscribe the cores. Decodes lease their threads from one budget
+// sized to the machine instead. A lease gets at most a fair share of the
+// budget for the current demand (leases held plus callers waiting) and
+// blocks while no thread is free; waiters are served in arrival order, so
+// under overload jobs queue at full speed instead of time-slicing the cores.
+
+#include <string>
+#include <utility>
+
+// High-priority callers are served before any queued normal caller
+// (running leases are never taken back)
+enum class lease_priority { normal = 0, high = 1 };
+
+class thread_lease {
+public:
+    thread_lease() = default;
+    ~thread_lease();
+
+    thread_lease(thread_lease&& other) noexcept : threads_(std::exchange(other.threads_, 0)) {}
+    thread_lease& operator=(thread_lease&& other) noexcept;
+    thread_lease(const thread_lease&) = delete;
+    thread_lease& operator=(const thread_lease&) = delete;
+
+    // Threads this holder may run (at least 1 once leased)
+    int threads() const { return threads_; }
+
+private:
+    friend thread_lease lease_threads(int wanted, lease_priority priority);
+    explicit thread_lease(int threads) : threads_(threads) {}
+
+    int threads_ = 0;
+};
+
+// CPUs this process can really use: hardware threads narrowed by the
+// affinity cpuset and the cgroup v1/v2 CFS quota (detected once, logged)
+int available_cpus();
+
+// CPUs granted by the cgroup v2 cpu.max or v1 CFS quota, 0 when unlimited.
+// proc_cgroup is a /proc/<pid>/cgroup file naming the process's cgroups,
+// cgroup_root the mount they are under ("/sys/fs/cgroup").
+double cgroup_quota_cpus(const std::string& proc_cgroup, const std::string& cgroup_root);
+
+// Threads for one decode when the caller did not ask for a number
+int default_decode_threads();
+
+// Lease up to `wanted` threads, waiting until at least one is free
+thread_lease lease_threads(int wanted, lease_priority priority = lease_priority::normal);
+
+// Resize the budget (0 = available_cpus()); running leases keep theirs
+void set_thread_budget(int n_threads);
+int thread_budget();
+
+#endif // CPU_BUDGET_H
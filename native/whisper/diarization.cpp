@@ -0,0 +1,286 @@
+#include "diarization.h"
+#include "audio_features.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+static const int DIARIZATION_N_MFCC = 20;           // c0 (loudness) is dropped from embeddings
+static const int EMBEDDING_DIM = 2 * (DIARIZATION_N_MFCC - 1);
+static const size_t CHUNK_SAMPLES = 24000;          // 1.5 s of speech per embedding
+static const size_t MIN_CHUNK_SAMPLES = 4800;       // 0.3 s, shorter chunks are too noisy
+static const float SPEAKER_SIMILARITY = 0.55f;      // Cosine similarity to join/merge speakers
+static const int DEFAULT_MAX_SPEAKERS = 8;
+static const size_t MIN_SPEAKER_SAMPLES = 16000;    // Speakers with < 1 s of speech fold into neighbours
+
+struct speech_chunk {
+    audio_region region;
+    std::vector<float> embedding;
+    int cluster;
+};
+
+struct speaker_cluster {
+    std::vector<float> sum;
+    std::vector<float> centroid; // Normalized sum
+    size_t samples;
+    bool alive;
+};
+
+static float dot(const float* a, const float* b, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static void normalize(std::vector<float>& v) {
+    const float norm = sqrtf(dot(v.data(), v.data(), (int) v.size()));
+    if (norm > 0.0f) {
+        for (float& x : v) {
+            x /= norm;
+        }
+    }
+}
+
+static void update_centroid(speaker_cluster& cluster) {
+    cluster.centroid = cluster.sum;
+    normalize(cluster.centroid);
+}
+
+static void merge_clusters(std::vector<speaker_cluster>& clusters, std::vector<speech_chunk>& chunks, int into, int from) {
+    speaker_cluster& target = clusters[into];
+    speaker_cluster& source = clusters[from];
+    for (int i = 0; i < EMBEDDING_DIM; ++i) {
+        target.sum[i] += source.sum[i];
+    }
+    target.samples += source.samples;
+    source.alive = false;
+    update_centroid(target);
+    for (speech_chunk& chunk : chunks) {
+        if (chunk.cluster == from) {
+            chunk.cluster = into;
+        }
+    }
+}
+
+// Most similar pair of live clusters; returns false when fewer than two remain
+static bool closest_pair(const std::vector<speaker_cluster>& clusters, int& a, int& b, float& similarity) {
+    similarity = -2.0f;
+    for (size_t i = 0; i < clusters.size(); ++i) {
+        for (size_t j = i + 1; j < clusters.size(); ++j) {
+            if (!clusters[i].alive || !clusters[j].alive) {
+                continue;
+            }
+            const float s = dot(clusters[i].centroid.data(), clusters[j].centroid.data(), EMBEDDING_DIM);
+            if (s > similarity) {
+                similarity = s;
+                a = (int) i;
+                b = (int) j;
+            }
+        }
+    }
+    return similarity > -2.0f;
+}
+
+// Cut speech regions into roughly equal chunks of at most CHUNK_SAMPLES
+static std::vector<speech_chunk> make_chunks(const std::vector<audio_region>& regions) {
+    std::vector<speech_chunk> chunks;
+    for (const audio_region& region : regions) {
+        const size_t length = region.end - region.begin;
+        const size_t n_parts = std::max<size_t>(1, (length + CHUNK_SAMPLES - 1) / CHUNK_SAMPLES);
+        const size_t part = length / n_parts;
+        if (part < MIN_CHUNK_SAMPLES) {
+            continue;
+        }
+        for (size_t p = 0; p < n_parts; ++p) {
+            speech_chunk chunk;
+            chunk.region.begin = region.begin + p * part;
+            chunk.region.end = p + 1 == n_parts ? region.end : chunk.region.begin + part;
+            chunk.cluster = -1;
+            chunks.push_back(std::move(chunk));
+        }
+    }
+    return chunks;
+}
+
+// Embeddings: per-chunk mean and standard deviation of MFCCs c1..c19, after
+// normalizing every coefficient over all speech in the recording so that
+// channel characteristics cancel and each dimension carries similar weight
+static void compute_embeddings(const std::vector<float>& pcm, std::vector<speech_chunk>& chunks) {
+    const int n_dims = DIARIZATION_N_MFCC - 1;
+
+    std::vector<std::vector<float>> chunk_mfcc(chunks.size());
+    std::vector<double> mean(n_dims, 0.0);
+    std::vector<double> sq(n_dims, 0.0);
+    size_t total_frames = 0;
+
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const audio_region& region = chunks[c].region;
+        compute_mfcc(pcm.data() + region.begin, region.end - region.begin, DIARIZATION_N_MFCC, chunk_mfcc[c]);
+        const size_t n_frames = chunk_mfcc[c].size() / DIARIZATION_N_MFCC;
+        for (size_t f = 0; f < n_frames; ++f) {
+            const float* frame = chunk_mfcc[c].data() + f * DIARIZATION_N_MFCC + 1;
+            for (int d = 0; d < n_dims; ++d) {
+                mean[d] += frame[d];
+                sq[d] += (double) frame[d] * frame[d];
+            }
+        }
+        total_frames += n_frames;
+    }
+    if (total_frames == 0) {
+        return;
+    }
+
+    std::vector<float> global_mean(n_dims);
+    std::vector<float> global_inv_std(n_dims);
+    for (int d = 0; d < n_dims; ++d) {
+        global_mean[d] = (float) (mean[d] / total_frames);
+        const double variance = sq[d] / total_frames - (double) global_mean[d] * global_mean[d];
+        global_inv_std[d] = 1.0f / (float) std::sqrt(std::max(variance, 1e-6));
+    }
+
+    std::vector<float> frame_mean(n_dims);
+    std::vector<float> frame_sq(n_dims);
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        const size_t n_frames = chunk_mfcc[c].size() / DIARIZATION_N_MFCC;
+        std::fill(frame_mean.begin(), frame_mean.end(), 0.0f);
+        std::fill(frame_sq.begin(), frame_sq.end(), 0.0f);
+        for (size_t f = 0; f < n_frames; ++f) {
+            const float* frame = chunk_mfcc[c].data() + f * DIARIZATION_N_MFCC + 1;
+            for (int d = 0; d < n_dims; ++d) {
+                const float x = (frame[d] - global_mean[d]) * global_inv_std[d];
+                frame_mean[d] += x;
+                frame_sq[d] += x * x;
+            }
+        }
+
+        std::vector<float>& embedding = chunks[c].embedding;
+        embedding.resize(EMBEDDING_DIM);
+        const float inv_n = 1.0f / std::max<size_t>(1, n_frames);
+        for (int d = 0; d < n_dims; ++d) {
+            const float m = frame_mean[d] * inv_n;
+            embedding[d] = m;
+            embedding[n_dims + d] = sqrtf(std::max(0.0f, frame_sq[d] * inv_n - m * m)) - 1.0f;
+        }
+        normalize(embedding);
+    }
+}
+
+int diarize_segments(const std::vector<float>& pcm, std::vector<ffi_segment>& segments, int max_speakers) {
+    if (max_speakers <= 0) {
+        max_speakers = DEFAULT_MAX_SPEAKERS;
+    }
+
+    std::vector<speech_chunk> chunks = make_chunks(detect_speech_regions(pcm));
+    compute_embeddings(pcm, chunks);
+    if (chunks.empty() || chunks[0].embedding.empty()) {
+        std::cerr << "🗣️ Diarization: no speech found" << std::endl;
+        return 0;
+    }
+
+    // Online pass in time order
+    std::vector<speaker_cluster> clusters;
+    int n_alive = 0;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        speech_chunk& chunk = chunks[c];
+
+        int best = -1;
+        float best_similarity = -2.0f;
+        for (size_t k = 0; k < clusters.size(); ++k) {
+            if (!clusters[k].alive) {
+                continue;
+            }
+            const float s = dot(chunk.embedding.data(), clusters[k].centroid.data(), EMBEDDING_DIM);
+            if (s > best_similarity) {
+                best_similarity = s;
+                best = (int) k;
+            }
+        }
+
+        if (best < 0 || (best_similarity < SPEAKER_SIMILARITY && n_alive < max_speakers)) {
+            speaker_cluster cluster;
+            cluster.sum = chunk.embedding;
+            cluster.samples = chunk.region.end - chunk.region.begin;
+            cluster.alive = true;
+            update_centroid(cluster);
+            clusters.push_back(std::move(cluster));
+            chunk.cluster = (int) clusters.size() - 1;
+            ++n_alive;
+            continue;
+        }
+
+        speaker_cluster& cluster = clusters[best];
+        for (int i = 0; i < EMBEDDING_DIM; ++i) {
+            cluster.sum[i] += chunk.embedding[i];
+        }
+        cluster.samples += chunk.region.end - chunk.region.begin;
+        update_centroid(cluster);
+        chunk.cluster = best;
+
+        // The updated centroid may now sit on top of another speaker
+        for (size_t k = 0; k < clusters.size(); ++k) {
+            if ((int) k != best && clusters[k].alive &&
+                dot(cluster.centroid.data(), clusters[k].centroid.data(), EMBEDDING_DIM) >= SPEAKER_SIMILARITY) {
+                merge_clusters(clusters, chunks, best, (int) k);
+                --n_alive;
+            }
+        }
+    }
+
+    // Agglomerative clean-up: merge while speakers are similar, then fold
+    // speakers with too little speech into their nearest neighbour
+    int a = 0;
+    int b = 0;
+    float similarity = 0.0f;
+    while (closest_pair(clusters, a, b, similarity) && similarity >= SPEAKER_SIMILARITY) {
+        merge_clusters(clusters, chunks, a, b);
+    }
+    for (size_t k = 0; k < clusters.size(); ++k) {
+        if (!clusters[k].alive || clusters[k].samples >= MIN_SPEAKER_SAMPLES) {
+            continue;
+        }
+        int nearest = -1;
+        float nearest_similarity = -2.0f;
+        for (size_t o = 0; o < clusters.size(); ++o) {
+            if (o == k || !clusters[o].alive) {
+                continue;
+            }
+            const float s = dot(clusters[k].centroid.data(), clusters[o].centroid.data(), EMBEDDING_DIM);
+            if (s > nearest_similarity) {
+                nearest_similarity = s;
+                nearest = (int) o;
+            }
+        }
+        if (nearest >= 0) {
+            merge_clusters(clusters, chunks, nearest, (int) k);
+        }
+    }
+
+    // Speaker numbers in order of first appearance
+    std::vector<int> label(clusters.size(), -1);
+    int n_speakers = 0;
+    for (const speech_chunk& chunk : chunks) {
+        if (label[chunk.cluster] < 0) {
+            label[chunk.cluster] = n_speakers++;
+        }
+    }
+
+    std::vector<int64_t> overlap(n_speakers);
+    for (ffi_segment& segment : segments) {
+        std::fill(overlap.begin(), overlap.end(), 0);
+        const int64_t seg_begin = segment.t0_ms * (WHISPER_SAMPLE_RATE / 1000);
+        const int64_t seg_end = segment.t1_ms * (WHISPER_SAMPLE_RATE / 1000);
+        for (const speech_chunk& chunk : chunks) {
+            const int64_t begin = std::max<int64_t>(seg_begin, (int64_t) chunk.region.begin);
+            const int64_t end = std::min<int64_t>(seg_end, (int64_t) chunk.region.end);
+            if (end > begin) {
+                overlap[label[chunk.cluster]] += end - begin;
+            }
+        }
+        const auto best = std::max_element(overlap.begin(), overlap.end());
+        segment.speaker = best != overlap.end() && *best > 0 ? (int) (best - overlap.begin()) : -1;
+    }
+
+    std::cerr << "🗣️ Diarization: " << chunks.size() << " speech chunks, " << n_speakers << " speakers" << std::endl;
+    return n_speakers;
+}
@@ -0,0 +1,20 @@
+#ifndef DIARIZATION_H
+#define DIARIZATION_H
+
+// Lightweight speaker diarization on already-decoded PCM.
+//
+// Speech regions from the energy VAD are cut into short chunks, each chunk
+// gets a compact speaker embedding (mean and spread of normalized MFCCs),
+// and chunks are clustered online: a chunk joins the closest speaker when
+// the cosine similarity clears a threshold, otherwise it opens a new one,
+// and speakers whose centroids drift together are merged agglomeratively.
+// Segment labels are taken from the speaker with the most overlapping speech.
+
+#include "whisper_ffi_internal.h"
+#include <vector>
+
+// Label every segment with a speaker index (segments without overlapping
+// speech keep -1). Returns the number of speakers found.
+int diarize_segments(const std::vector<float>& pcm, std::vector<ffi_segment>& segments, int max_speakers);
+
+#endif // DIARIZATION_H
@@ -0,0 +1,184 @@
+#include "language_router.h"
+#include "cpu_budget.h"
+#include "scratch_arena.h"
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const size_t ROUTER_CACHE_SIZE = 4096;
+// Weaker detections (short or mixed-language audio) are redone on the next job
+static const float ROUTER_CACHE_MIN_PROBABILITY = 0.8f;
+static const size_t LANGUAGE_ID_SAMPLES = WHISPER_CHUNK_SIZE * WHISPER_SAMPLE_RATE;
+
+language_router::language_router(whisper_context* english_ctx, whisper_context* multilingual_ctx)
+    : english_ctx(english_ctx), multilingual_ctx(multilingual_ctx) {}
+
+bool language_router::cached_language(const std::string& source, language_choice& choice) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto found = by_source.find(source);
+    if (found == by_source.end()) {
+        return false;
+    }
+    recent.splice(recent.begin(), recent, found->second);
+    choice = found->second->second;
+    choice.cached = true;
+    return true;
+}
+
+void language_router::remember_language(const std::string& source, const language_choice& choice) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto found = by_source.find(source);
+    if (found != by_source.end()) {
+        recent.erase(found->second);
+    }
+    recent.emplace_front(source, choice);
+    by_source[source] = recent.begin();
+    if (recent.size() > ROUTER_CACHE_SIZE) {
+        by_source.erase(recent.back().first);
+        recent.pop_back();
+    }
+}
+
+// Language of the first window: one mel and encoder pass on `state`
+static bool detect_language(whisper_context* ctx, whisper_state* state, const std::vector<float>& pcm,
+                            language_choice& choice) {
+    const thread_lease lease = lease_threads(default_decode_threads());
+    const int n_samples = (int) std::min(pcm.size(), LANGUAGE_ID_SAMPLES);
+    if (whisper_pcm_to_mel_with_state(ctx, state, pcm.data(), n_samples, lease.threads()) != 0) {
+        std::cerr << "❌ Failed to compute mel for language ID" << std::endl;
+        return false;
+    }
+    std::vector<float> probs(whisper_lang_max_id() + 1, 0.0f);
+    const int lang_id = whisper_lang_auto_detect_with_state(ctx, state, 0, lease.threads(), probs.data());
+    if (lang_id < 0) {
+        std::cerr << "❌ Language ID failed" << std::endl;
+        return false;
+    }
+    choice.lang_id = lang_id;
+    choice.probability = probs[lang_id];
+    return true;
+}
+
+bool language_router::transcribe(const std::vector<float>& pcm, const std::string& source,
+                                 const whisper_ffi_transcribe_params& params, const segment_callback& on_segment,
+                                 language_choice& choice) {
+    const int english_id = whisper_lang_id("en");
+    std::vector<whisper_state*> pooled; // Multilingual state that ran language ID
+
+    if (params.language && strcmp(params.language, "auto") != 0) {
+        choice.lang_id = whisper_lang_id(params.language);
+        choice.probability = 1.0f;
+        if (choice.lang_id < 0) {
+            std::cerr << "❌ Unknown language: " << params.language << std::endl;
+            return false;
+        }
+    } else if (!multilingual_ctx) {
+        choice.lang_id = english_id; // Nothing to detect with
+        choice.probability = 1.0f;
+    } else if (!cached_language(source, choice)) {
+        pooled = acquire_states(multilingual_ctx, 1);
+        if (pooled.empty()) {
+            return false;
+        }
+        if (!detect_language(multilingual_ctx, pooled[0], pcm, choice)) {
+            release_states(multilingual_ctx, pooled);
+            return false;
+        }
+        if (choice.probability >= ROUTER_CACHE_MIN_PROBABILITY) {
+            remember_language(source, choice);
+        }
+    }
+
+    const bool english = choice.lang_id == english_id;
+    whisper_context* ctx = (english && english_ctx) || !multilingual_ctx ? english_ctx : multilingual_ctx;
+    if (ctx != multilingual_ctx && !pooled.empty()) {
+        release_states(multilingual_ctx, pooled);
+        pooled.clear();
+    }
+    if (!english && ctx == english_ctx) {
+        std::cerr << "⚠️ No multilingual model for " << whisper_lang_str(choice.lang_id)
+                  << ", decoding with the English model" << std::endl;
+    }
+    std::cerr << "🌐 Language " << whisper_lang_str(choice.lang_id) << " (p=" << choice.probability
+              << (choice.cached ? ", cached" : "") << ") → " << (ctx == english_ctx ? "English" : "multilingual")
+              << " model" << std::endl;
+
+    whisper_ffi_transcribe_params routed = params;
+    routed.language = ctx == english_ctx ? "en" : whisper_lang_str(choice.lang_id);
+    const bool ok = transcribe_pcm(ctx, pooled.empty() ? nullptr : pooled[0], pcm, routed, on_segment);
+    if (!pooled.empty()) {
+        release_states(multilingual_ctx, pooled);
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+// ---------------------------------------------------------------------------
+
+struct whisper_ffi_router {
+    language_router impl;
+};
+
+extern "C" {
+
+whisper_ffi_router* whisper_ffi_router_create(whisper_context* english_ctx, whisper_context* multilingual_ctx) {
+    if (!english_ctx && !multilingual_ctx) {
+        std::cerr << "❌ Language router needs at least one model" << std::endl;
+        return nullptr;
+    }
+    if (multilingual_ctx && !whisper_is_multilingual(multilingual_ctx)) {
+        std::cerr << "❌ Multilingual slot holds an English-only model" << std::endl;
+        return nullptr;
+    }
+    try {
+        return new whisper_ffi_router{language_router(english_ctx, multilingual_ctx)};
+    } catch (...) {
+        std::cerr << "💥 Exception creating language router" << std::endl;
+        return nullptr;
+    }
+}
+
+char* whisper_ffi_router_transcribe_json(whisper_ffi_router* router, const char* audio_path, const char* source,
+                                         const struct whisper_ffi_transcribe_params* params) {
+    if (!router || !audio_path) {
+        std::cerr << "❌ Invalid parameters for routed transcription" << std::endl;
+        return nullptr;
+    }
+
+    try {
+        std::cerr << "🎵 Starting transcription for: " << audio_path << std::endl;
+        scratch_pcm pcm(scratch_slot::pcm);
+        if (!read_audio_file(audio_path, *pcm)) {
+            std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+            return nullptr;
+        }
+
+        std::vector<ffi_segment> segments;
+        language_choice choice;
+        const bool ok = router->impl.transcribe(*pcm, source ? source : audio_path,
+                                                params ? *params : whisper_ffi_transcribe_default_params(),
+                                                [&segments](ffi_segment&& segment) {
+            segments.push_back(std::move(segment));
+            return true;
+        }, choice);
+        if (!ok) {
+            return nullptr;
+        }
+        std::cerr << "✅ Transcription completed successfully (" << segments.size() << " segments)" << std::endl;
+
+        scratch_text json(scratch_slot::text);
+        append_result_json(*json, segments, whisper_lang_str(choice.lang_id));
+        return copy_to_c_string(*json);
+    } catch (...) {
+        std::cerr << "💥 Exception during routed transcription" << std::endl;
+        return nullptr;
+    }
+}
+
+void whisper_ffi_router_free(whisper_ffi_router* router) {
+    delete router;
+}
+
+}
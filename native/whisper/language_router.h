@@ -0,0 +1,55 @@
+#ifndef LANGUAGE_ROUTER_H
+#define LANGUAGE_ROUTER_H
+
+// Per-job model choice by spoken language.
+//
+// English-only (.en) models are faster and more accurate on English than a
+// multilingual model of the same size, but cannot transcribe anything else.
+// The router holds one of each. Before a job it runs language ID on the
+// first 30 s with the multilingual model (one encoder pass, on the state the
+// job will use if it stays there), then decodes English on the .en model and
+// every other language on the multilingual one with the language fixed, so
+// whisper_full does not detect it again. Each context keeps its own state
+// pool.
+//
+// Sources (a caller-chosen id such as a speaker or device, else the file
+// path) usually keep their language, so a confident detection is cached
+// per source and later jobs from it skip language ID.
+
+#include "whisper_ffi_internal.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct language_choice {
+    int lang_id = -1;
+    float probability = 0.0f;
+    bool cached = false;
+};
+
+class language_router {
+public:
+    // Contexts are not owned; either may be null (all jobs go to the other)
+    language_router(whisper_context* english_ctx, whisper_context* multilingual_ctx);
+
+    // Decode pcm on the model for its language, reporting the choice
+    bool transcribe(const std::vector<float>& pcm, const std::string& source,
+                    const whisper_ffi_transcribe_params& params, const segment_callback& on_segment,
+                    language_choice& choice);
+
+private:
+    bool cached_language(const std::string& source, language_choice& choice);
+    void remember_language(const std::string& source, const language_choice& choice);
+
+    whisper_context* english_ctx;
+    whisper_context* multilingual_ctx;
+
+    // LRU of confident detections: most recent at the front
+    std::mutex cache_mutex;
+    std::list<std::pair<std::string, language_choice>> recent;
+    std::unordered_map<std::string, std::list<std::pair<std::string, language_choice>>::iterator> by_source;
+};
+
+#endif // LANGUAGE_ROUTER_H
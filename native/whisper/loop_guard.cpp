@@ -0,0 +1,90 @@
+#include "loop_guard.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+static const int MAX_LOOP_NGRAM = 16;     // Longest repeated phrase looked for, in tokens
+static const int MIN_LOOP_REPEATS = 3;    // Back-to-back occurrences that make a loop...
+static const int MIN_LOOP_TOKENS = 16;    // ...and tokens they must cover ("no, no, no" is speech)
+static const double MAX_TOKENS_PER_SECOND = 10.0; // Fast speech stays around 5
+
+// Length of the loop the tokens end in, or 0: the last n tokens repeated
+// back to back often enough, for the n that covers the longest tail
+static int loop_tail_length(const std::vector<whisper_token>& tokens) {
+    const int n_tokens = (int) tokens.size();
+    int longest = 0;
+    for (int n = 1; n <= MAX_LOOP_NGRAM && n * MIN_LOOP_REPEATS <= n_tokens; ++n) {
+        const whisper_token* tail = tokens.data() + n_tokens - n;
+        int repeats = 1;
+        while ((repeats + 1) * n <= n_tokens &&
+               std::equal(tail, tail + n, tail - repeats * n)) {
+            ++repeats;
+        }
+        if (repeats >= std::max(MIN_LOOP_REPEATS, (MIN_LOOP_TOKENS + n - 1) / n)) {
+            longest = std::max(longest, repeats * n);
+        }
+    }
+    return longest;
+}
+
+// Text tokens only: timestamps differ between repetitions of a looping segment
+static void text_tokens(whisper_context* ctx, const whisper_token_data* tokens, int n_tokens,
+                        std::vector<whisper_token>& out) {
+    const whisper_token eot = whisper_token_eot(ctx);
+    out.clear();
+    for (int i = 0; i < n_tokens; ++i) {
+        if (tokens[i].id < eot) {
+            out.push_back(tokens[i].id);
+        }
+    }
+}
+
+int end_text_on_loop(const std::vector<whisper_token>& text, whisper_token eot, float* logits, int n_vocab) {
+    const int loop = loop_tail_length(text);
+    if (loop > 0) {
+        std::fill(logits, logits + n_vocab, -INFINITY);
+        logits[eot] = 0.0f;
+    }
+    return loop;
+}
+
+static void force_end_of_text_on_loop(whisper_context* ctx, whisper_state* state, const whisper_token_data* tokens,
+                                      int n_tokens, float* logits, void* user_data) {
+    (void) state;
+    thread_local std::vector<whisper_token> text;
+    text_tokens(ctx, tokens, n_tokens, text);
+    const int loop = end_text_on_loop(text, whisper_token_eot(ctx), logits, whisper_n_vocab(ctx));
+    if (loop == 0) {
+        return;
+    }
+
+    loop_guard* guard = static_cast<loop_guard*>(user_data);
+    if (!guard->cut.exchange(true)) {
+        std::cerr << "🔁 Repetition loop of " << loop << " tokens, ending the window early" << std::endl;
+    }
+}
+
+void install_loop_guard(whisper_full_params& wparams, loop_guard& guard) {
+    wparams.logits_filter_callback = force_end_of_text_on_loop;
+    wparams.logits_filter_callback_user_data = &guard;
+}
+
+bool segment_is_suspect(whisper_context* ctx, whisper_state* state, int i_segment) {
+    std::vector<whisper_token_data> tokens;
+    const int n_tokens = whisper_full_n_tokens_from_state(state, i_segment);
+    for (int j = 0; j < n_tokens; ++j) {
+        tokens.push_back(whisper_full_get_token_data_from_state(state, i_segment, j));
+    }
+    std::vector<whisper_token> text;
+    text_tokens(ctx, tokens.data(), n_tokens, text);
+    if (loop_tail_length(text) > 0) {
+        return true;
+    }
+
+    // Timestamps are in 10 ms units; very short segments count as one second
+    const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i_segment);
+    const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i_segment);
+    const double seconds = std::max(1.0, (t1 - t0) / 100.0);
+    return text.size() > MAX_TOKENS_PER_SECOND * seconds;
+}
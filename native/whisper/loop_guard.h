@@ -0,0 +1,35 @@
+#ifndef LOOP_GUARD_H
+#define LOOP_GUARD_H
+
+// Repetition loop guard.
+//
+// On silence and noise Whisper can fall into a loop, emitting the same
+// phrase until the window's token budget runs out. The guard watches the
+// text tokens of every decoding step and forces end-of-text as soon as they
+// end in a phrase repeated back to back, which ends that window instead of
+// decoding the rest of the loop. Segments are separately flagged as suspect
+// when they end in such a loop or carry more tokens than speech of their
+// length can hold.
+
+#include "whisper_ffi_internal.h"
+#include <atomic>
+#include <vector>
+
+struct loop_guard {
+    // A loop was cut since the last take_cut() (decoders run in parallel)
+    std::atomic<bool> cut{false};
+
+    bool take_cut() { return cut.exchange(false); }
+};
+
+// Length of the repetition loop the text tokens end in, 0 if none. On a
+// loop every logit but end-of-text is masked, so the decoder stops there.
+int end_text_on_loop(const std::vector<whisper_token>& text, whisper_token eot, float* logits, int n_vocab);
+
+// Hook the guard into a decode through logits_filter_callback
+void install_loop_guard(whisper_full_params& wparams, loop_guard& guard);
+
+// Heuristic hallucination check on a decoded segment
+bool segment_is_suspect(whisper_context* ctx, whisper_state* state, int i_segment);
+
+#endif // LOOP_GUARD_H
@@ -0,0 +1,240 @@
+// Background model preload.
+//
+// The desktop runner starts loading the model before the Flutter engine has
+// even booted; Dart later adopts the ready context instead of paying for a
+// cold load on the first transcription. One preload can be in flight per
+// process, keyed by the model file's canonical path. If Dart asks for a
+// different model, the preloaded one is freed (once loaded) and the slot is
+// free for another preload.
+
+#include "whisper_wrapper.h"
+#include "whisper_ffi_internal.h"
+#include "cpu_budget.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Shared by the API and the worker, so a dropped preload's worker can
+// still finish with it
+struct preload_slot {
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    std::string path;                 // Canonical model path
+    whisper_context* ctx = nullptr;
+    bool done = false;
+    bool abandoned = false;           // Nobody will adopt it: the worker frees ctx
+};
+
+// The pending preload, null when idle
+static std::mutex g_preload_mutex;
+static std::shared_ptr<preload_slot> g_preload;
+
+// Workers still running. The worker uses the context registry, the thread
+// budget and whisper.cpp, which exit tears down, so exit waits for it (and
+// makes it skip the warm-up). Created on the first preload, after those
+// statics, so it is destroyed before them.
+struct preload_workers {
+    std::mutex mutex;
+    std::condition_variable idle;
+    int running = 0;
+    bool exiting = false;
+
+    ~preload_workers() {
+        std::unique_lock<std::mutex> lock(mutex);
+        exiting = true;
+        if (running > 0) {
+            std::cerr << "⏳ Waiting for model preload before exit..." << std::endl;
+            idle.wait(lock, [this] { return running == 0; });
+        }
+    }
+};
+
+static preload_workers& workers() {
+    static preload_workers instance;
+    return instance;
+}
+
+static bool exiting() {
+    std::lock_guard<std::mutex> lock(workers().mutex);
+    return workers().exiting;
+}
+
+static void worker_finished() {
+    std::lock_guard<std::mutex> lock(workers().mutex);
+    --workers().running;
+    workers().idle.notify_all();
+}
+
+static std::string canonical_path(const char* path) {
+#ifdef _WIN32
+    char resolved[_MAX_PATH];
+    return _fullpath(resolved, path, _MAX_PATH) ? std::string(resolved) : std::string(path);
+#else
+    char* resolved = realpath(path, nullptr);
+    if (!resolved) {
+        return path;
+    }
+    std::string result(resolved);
+    free(resolved);
+    return result;
+#endif
+}
+
+// Pull the model file into the page cache ahead of the loader's reads
+static void read_ahead(const std::string& path) {
+#if defined(__linux__)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+#else
+    (void) path;
+#endif
+}
+
+// One encoder pass over a second of silence: allocates the compute buffers
+// of a pooled state and touches every encoder weight, so the first real
+// transcription starts hot
+static void warm_up(whisper_context* ctx) {
+    std::vector<whisper_state*> states = acquire_states(ctx, 1);
+    if (states.empty()) {
+        return;
+    }
+    const thread_lease lease = lease_threads(thread_budget());
+    const int n_threads = lease.threads();
+    const std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+    if (whisper_pcm_to_mel_with_state(ctx, states[0], silence.data(), (int) silence.size(), n_threads) != 0 ||
+        whisper_encode_with_state(ctx, states[0], 0, n_threads) != 0) {
+        std::cerr << "⚠️ Model warm-up failed, first transcription will start cold" << std::endl;
+    }
+    release_states(ctx, states);
+}
+
+static void preload_worker(std::shared_ptr<preload_slot> slot) {
+    const auto start = std::chrono::steady_clock::now();
+
+    whisper_context* ctx = nullptr;
+    try {
+        read_ahead(slot->path);
+        ctx = load_model(slot->path.c_str(), whisper_ffi_init_default_params());
+        if (ctx && !exiting()) {
+            warm_up(ctx);
+        }
+    } catch (...) {
+        std::cerr << "💥 Exception during model preload" << std::endl;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cerr << (ctx ? "✅ Model preloaded in " : "❌ Model preload failed after ") << elapsed.count() << " ms" << std::endl;
+
+    bool adoptable = false;
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        slot->done = true;
+        adoptable = !slot->abandoned;
+        if (adoptable) {
+            slot->ctx = ctx;
+            slot->done_cv.notify_all();
+        }
+    }
+    if (!adoptable && ctx) {
+        std::cerr << "🧹 Freeing preloaded model nobody adopted: " << slot->path << std::endl;
+        free_model(ctx);
+    }
+    worker_finished();
+}
+
+extern "C" {
+
+bool whisper_ffi_preload(const char* model_path) {
+    if (!model_path) {
+        std::cerr << "❌ Invalid parameters: model_path=null" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_preload_mutex);
+    if (g_preload) {
+        std::cerr << "⚠️ A model preload is already pending: " << g_preload->path << std::endl;
+        return false;
+    }
+
+    try {
+        std::shared_ptr<preload_slot> slot = std::make_shared<preload_slot>();
+        slot->path = canonical_path(model_path);
+        std::cerr << "🚀 Preloading model in background: " << slot->path << std::endl;
+        {
+            std::lock_guard<std::mutex> workers_lock(workers().mutex);
+            ++workers().running;
+        }
+        try {
+            std::thread(preload_worker, slot).detach();
+        } catch (...) {
+            worker_finished();
+            throw;
+        }
+        g_preload = std::move(slot);
+        return true;
+    } catch (...) {
+        std::cerr << "💥 Failed to start model preload" << std::endl;
+        return false;
+    }
+}
+
+whisper_context* whisper_ffi_adopt_preloaded(const char* model_path) {
+    if (!model_path) {
+        return nullptr;
+    }
+
+    std::shared_ptr<preload_slot> slot;
+    {
+        std::lock_guard<std::mutex> lock(g_preload_mutex);
+        slot = std::move(g_preload);
+    }
+    if (!slot) {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(slot->mutex);
+    if (slot->path != canonical_path(model_path)) {
+        // Dart settled on another model: drop this one instead of keeping
+        // it (and the slot) for the life of the process
+        std::cerr << "⚠️ Preloaded " << slot->path << " but " << model_path << " was requested, dropping it"
+                  << std::endl;
+        slot->abandoned = true;
+        whisper_context* stale = std::exchange(slot->ctx, nullptr);
+        lock.unlock();
+        if (stale) {
+            free_model(stale);
+        }
+        return nullptr;
+    }
+
+    if (!slot->done) {
+        std::cerr << "⏳ Waiting for model preload to finish..." << std::endl;
+        slot->done_cv.wait(lock, [&slot] { return slot->done; });
+    }
+
+    whisper_context* ctx = std::exchange(slot->ctx, nullptr);
+    if (ctx) {
+        std::cerr << "🤝 Adopted preloaded model context" << std::endl;
+    }
+    return ctx;
+}
+
+}
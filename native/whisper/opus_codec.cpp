@@ -0,0 +1,585 @@
+#include "opus_codec.h"
+#include "whisper_wrapper.h"
+#include "whisper_ffi_internal.h"
+#include "scratch_arena.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef WHISPER_FFI_WITH_OPUS
+#include <ogg/ogg.h>
+#include <opus/opus.h>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#endif
+
+#ifdef WHISPER_FFI_WITH_OPUS
+
+static const int OPUS_SAMPLE_RATE = 16000;
+static const int OPUS_FRAME_SAMPLES = 320;     // 20 ms at 16 kHz
+static const int OPUS_GRANULE_SCALE = 3;       // Ogg Opus granule positions count 48 kHz samples
+static const int OPUS_MAX_PACKET = 1500;
+static const int OPUS_MAX_FRAME_SAMPLES = 1920; // 120 ms at 16 kHz, the largest Opus frame
+static const int64_t OPUS_PREROLL_SAMPLES = 1280; // 80 ms for the decoder to converge after a seek (RFC 7845)
+static const size_t OPUS_READ_BYTES = 64 * 1024;
+static const size_t SEEK_TABLE_CACHE_SIZE = 16;
+
+static void put_le16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char) (v & 0xff);
+    p[1] = (unsigned char) (v >> 8);
+}
+
+static void put_le32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (unsigned char) (v >> (8 * i));
+    }
+}
+
+static bool write_pages(ogg_stream_state& stream, FILE* file, bool flush) {
+    ogg_page page;
+    while (flush ? ogg_stream_flush(&stream, &page) : ogg_stream_pageout(&stream, &page)) {
+        if (fwrite(page.header, 1, page.header_len, file) != (size_t) page.header_len ||
+            fwrite(page.body, 1, page.body_len, file) != (size_t) page.body_len) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool write_opus_headers(ogg_stream_state& stream, FILE* file, int pre_skip) {
+    // OpusHead (RFC 7845 section 5.1), mono, channel mapping family 0
+    unsigned char head[19];
+    memcpy(head, "OpusHead", 8);
+    head[8] = 1;
+    head[9] = 1;
+    put_le16(head + 10, (uint16_t) pre_skip);
+    put_le32(head + 12, OPUS_SAMPLE_RATE);
+    put_le16(head + 16, 0);
+    head[18] = 0;
+
+    ogg_packet packet = {};
+    packet.packet = head;
+    packet.bytes = sizeof(head);
+    packet.b_o_s = 1;
+    ogg_stream_packetin(&stream, &packet);
+    if (!write_pages(stream, file, true)) {
+        return false;
+    }
+
+    // OpusTags with the encoder as vendor and no user comments
+    const char* vendor = opus_get_version_string();
+    const size_t vendor_len = strlen(vendor);
+    std::vector<unsigned char> tags(8 + 4 + vendor_len + 4);
+    memcpy(tags.data(), "OpusTags", 8);
+    put_le32(tags.data() + 8, (uint32_t) vendor_len);
+    memcpy(tags.data() + 12, vendor, vendor_len);
+    put_le32(tags.data() + 12 + vendor_len, 0);
+
+    packet = {};
+    packet.packet = tags.data();
+    packet.bytes = (long) tags.size();
+    packet.packetno = 1;
+    ogg_stream_packetin(&stream, &packet);
+    return write_pages(stream, file, true);
+}
+
+bool encode_ogg_opus(const std::vector<float>& pcm, const std::string& path, int bitrate) {
+    if (bitrate <= 0) {
+        bitrate = OPUS_SPEECH_BITRATE;
+    }
+
+    int error = OPUS_OK;
+    OpusEncoder* encoder = opus_encoder_create(OPUS_SAMPLE_RATE, 1, OPUS_APPLICATION_VOIP, &error);
+    if (error != OPUS_OK || !encoder) {
+        std::cerr << "❌ Opus encoder init failed: " << opus_strerror(error) << std::endl;
+        return false;
+    }
+    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_encoder_ctl(encoder, OPUS_SET_VBR(1));
+    opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(10));
+
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(encoder, OPUS_GET_LOOKAHEAD(&lookahead));
+    const int pre_skip = lookahead * OPUS_GRANULE_SCALE;
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "❌ Cannot create Opus file: " << path << std::endl;
+        opus_encoder_destroy(encoder);
+        return false;
+    }
+
+    ogg_stream_state stream;
+    ogg_stream_init(&stream, (int) std::random_device{}());
+
+    bool ok = write_opus_headers(stream, file, pre_skip);
+
+    // Feed the lookahead worth of trailing silence so the last real samples
+    // come out of the encoder; the final granule position trims it again
+    const size_t total = pcm.size() + (size_t) lookahead;
+    const size_t n_frames = (total + OPUS_FRAME_SAMPLES - 1) / OPUS_FRAME_SAMPLES;
+    const ogg_int64_t end_granule = (ogg_int64_t) pre_skip + (ogg_int64_t) pcm.size() * OPUS_GRANULE_SCALE;
+
+    std::vector<float> frame(OPUS_FRAME_SAMPLES);
+    unsigned char data[OPUS_MAX_PACKET];
+    for (size_t f = 0; ok && f < std::max<size_t>(n_frames, 1); ++f) {
+        const size_t begin = f * OPUS_FRAME_SAMPLES;
+        const size_t available = begin < pcm.size() ? std::min<size_t>(OPUS_FRAME_SAMPLES, pcm.size() - begin) : 0;
+        std::copy(pcm.begin() + begin, pcm.begin() + begin + available, frame.begin());
+        std::fill(frame.begin() + available, frame.end(), 0.0f);
+
+        const opus_int32 bytes = opus_encode_float(encoder, frame.data(), OPUS_FRAME_SAMPLES, data, OPUS_MAX_PACKET);
+        if (bytes < 0) {
+            std::cerr << "❌ Opus encode failed: " << opus_strerror(bytes) << std::endl;
+            ok = false;
+            break;
+        }
+
+        const bool last = f + 1 >= n_frames;
+        ogg_packet packet = {};
+        packet.packet = data;
+        packet.bytes = bytes;
+        packet.e_o_s = last ? 1 : 0;
+        packet.granulepos = last ? end_granule
+                                 : (ogg_int64_t) (f + 1) * OPUS_FRAME_SAMPLES * OPUS_GRANULE_SCALE;
+        packet.packetno = (ogg_int64_t) f + 2;
+        ogg_stream_packetin(&stream, &packet);
+        ok = write_pages(stream, file, last);
+    }
+
+    ogg_stream_clear(&stream);
+    opus_encoder_destroy(encoder);
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok) {
+        std::cerr << "❌ Failed to write Opus file: " << path << std::endl;
+        remove(path.c_str());
+        return false;
+    }
+    std::cout << "🗜️ Encoded " << pcm.size() / (float) OPUS_SAMPLE_RATE << " s to Opus at "
+              << bitrate / 1000 << " kbps: " << path << std::endl;
+    return true;
+}
+
+// Channel count and pre-skip (in 16 kHz samples) from the OpusHead packet
+static bool parse_opus_head(const ogg_packet& packet, const std::string& label, int& channels, int& pre_skip) {
+    if (packet.bytes < 19 || memcmp(packet.packet, "OpusHead", 8) != 0) {
+        std::cerr << "❌ Not an Ogg Opus stream: " << label << std::endl;
+        return false;
+    }
+    channels = packet.packet[9];
+    pre_skip = (packet.packet[10] | (packet.packet[11] << 8)) / OPUS_GRANULE_SCALE;
+    if (packet.packet[18] != 0 || channels < 1 || channels > 2) {
+        std::cerr << "❌ Unsupported Opus channel mapping (" << channels << " channels)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static OpusDecoder* create_decoder(int channels) {
+    int error = OPUS_OK;
+    // libopus resamples internally, so it can hand out 16 kHz directly
+    OpusDecoder* decoder = opus_decoder_create(OPUS_SAMPLE_RATE, channels, &error);
+    if (error != OPUS_OK || !decoder) {
+        std::cerr << "❌ Opus decoder init failed: " << opus_strerror(error) << std::endl;
+        return nullptr;
+    }
+    return decoder;
+}
+
+// Decode one audio packet and append it as mono
+static void decode_packet(OpusDecoder* decoder, const ogg_packet& packet, int channels, std::vector<float>& decoded,
+                          std::vector<float>& pcm) {
+    const int samples = opus_decode_float(decoder, packet.packet, (opus_int32) packet.bytes,
+                                          decoded.data(), OPUS_MAX_FRAME_SAMPLES, 0);
+    if (samples < 0) {
+        std::cerr << "⚠️ Skipping corrupt Opus packet: " << opus_strerror(samples) << std::endl;
+    } else if (channels == 1) {
+        pcm.insert(pcm.end(), decoded.begin(), decoded.begin() + samples);
+    } else {
+        for (int i = 0; i < samples; ++i) {
+            pcm.push_back((decoded[2 * i] + decoded[2 * i + 1]) * 0.5f);
+        }
+    }
+}
+
+std::vector<float> decode_ogg_opus(const audio_read_fn& read, const std::string& label) {
+    ogg_sync_state sync;
+    ogg_sync_init(&sync);
+    ogg_stream_state stream;
+    bool have_stream = false;
+
+    OpusDecoder* decoder = nullptr;
+    int channels = 0;
+    int pre_skip = 0;       // In 16 kHz samples
+    int64_t packets = 0;
+    int64_t last_granule = -1;
+    bool failed = false;
+
+    std::vector<float> pcm;
+    std::vector<float> decoded(OPUS_MAX_FRAME_SAMPLES * 2);
+
+    while (!failed) {
+        char* buffer = ogg_sync_buffer(&sync, 64 * 1024);
+        const int64_t n = read(buffer, 64 * 1024);
+        if (n < 0) {
+            std::cerr << "❌ Read error in Ogg stream: " << label << std::endl;
+            failed = true;
+            break;
+        }
+        ogg_sync_wrote(&sync, (long) n);
+
+        ogg_page page;
+        while (!failed && ogg_sync_pageout(&sync, &page) == 1) {
+            if (!have_stream) {
+                ogg_stream_init(&stream, ogg_page_serialno(&page));
+                have_stream = true;
+            }
+            // Only the first logical stream is decoded
+            if (ogg_page_serialno(&page) != stream.serialno || ogg_stream_pagein(&stream, &page) != 0) {
+                continue;
+            }
+
+            ogg_packet packet;
+            while (ogg_stream_packetout(&stream, &packet) == 1) {
+                if (packets == 0) {
+                    if (!parse_opus_head(packet, label, channels, pre_skip) ||
+                        !(decoder = create_decoder(channels))) {
+                        failed = true;
+                        break;
+                    }
+                } else if (packets > 1) {
+                    decode_packet(decoder, packet, channels, decoded, pcm);
+                }
+                if (packet.granulepos >= 0) {
+                    last_granule = packet.granulepos;
+                }
+                ++packets;
+            }
+        }
+
+        if (n == 0) {
+            break;
+        }
+    }
+
+    if (decoder) {
+        opus_decoder_destroy(decoder);
+    }
+    if (have_stream) {
+        ogg_stream_clear(&stream);
+    }
+    ogg_sync_clear(&sync);
+
+    if (failed || packets < 2) {
+        if (!failed) {
+            std::cerr << "❌ Truncated Ogg Opus stream: " << label << std::endl;
+        }
+        return {};
+    }
+
+    // Drop the encoder delay and the padding after the final granule position
+    if (last_granule >= 0) {
+        const int64_t length = last_granule / OPUS_GRANULE_SCALE;
+        if (length < (int64_t) pcm.size()) {
+            pcm.resize((size_t) std::max<int64_t>(length, pre_skip));
+        }
+    }
+    pcm.erase(pcm.begin(), pcm.begin() + std::min<size_t>(pcm.size(), (size_t) pre_skip));
+
+    std::cout << "✅ Decoded Opus: " << pcm.size() << " samples (" << pcm.size() / (float) OPUS_SAMPLE_RATE
+              << " s)" << std::endl;
+    return pcm;
+}
+
+// Where decoding can start in an Ogg Opus file
+struct opus_seek_table {
+    struct page {
+        int64_t granule;     // Granule position at the end of the page
+        int64_t next_offset; // File offset of the page after it
+    };
+
+    int64_t file_size = 0;
+    std::filesystem::file_time_type modified;
+    int serialno = 0;
+    int channels = 0;
+    int pre_skip = 0;          // In 16 kHz samples
+    int64_t audio_offset = 0;  // First page after the headers
+    std::vector<page> pages;   // Pages that end a packet, in file order
+    uint64_t last_used = 0;
+};
+
+static std::mutex g_seek_tables_mutex;
+static std::map<std::string, std::shared_ptr<opus_seek_table>> g_seek_tables;
+static uint64_t g_seek_table_clock = 0;
+
+// One pass over the page headers; packets are only assembled for the two header packets
+static std::shared_ptr<opus_seek_table> build_seek_table(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "❌ Could not open file: " << path << std::endl;
+        return nullptr;
+    }
+
+    auto table = std::make_shared<opus_seek_table>();
+    ogg_sync_state sync;
+    ogg_sync_init(&sync);
+    ogg_stream_state stream;
+    bool have_stream = false;
+    int header_packets = 0;
+    int64_t offset = 0;
+    bool at_end = false;
+    bool failed = false;
+
+    while (!failed) {
+        ogg_page page;
+        const long result = ogg_sync_pageseek(&sync, &page);
+        if (result < 0) {
+            offset -= result; // Skipped bytes that are not a page
+            continue;
+        }
+        if (result == 0) {
+            if (at_end) {
+                break;
+            }
+            char* buffer = ogg_sync_buffer(&sync, OPUS_READ_BYTES);
+            const size_t n = fread(buffer, 1, OPUS_READ_BYTES, file);
+            failed = n == 0 && ferror(file);
+            at_end = n == 0;
+            ogg_sync_wrote(&sync, (long) n);
+            continue;
+        }
+
+        const int64_t page_offset = offset;
+        offset += result;
+        if (!have_stream) {
+            table->serialno = ogg_page_serialno(&page);
+            ogg_stream_init(&stream, table->serialno);
+            have_stream = true;
+        }
+        if (ogg_page_serialno(&page) != table->serialno) {
+            continue;
+        }
+        if (header_packets < 2) {
+            ogg_stream_pagein(&stream, &page);
+            ogg_packet packet;
+            while (!failed && header_packets < 2 && ogg_stream_packetout(&stream, &packet) == 1) {
+                failed = header_packets == 0 && !parse_opus_head(packet, path, table->channels, table->pre_skip);
+                ++header_packets;
+            }
+            table->audio_offset = offset;
+            continue;
+        }
+        if (ogg_page_granulepos(&page) >= 0) {
+            table->pages.push_back({ogg_page_granulepos(&page), page_offset + result});
+        }
+    }
+
+    if (have_stream) {
+        ogg_stream_clear(&stream);
+    }
+    ogg_sync_clear(&sync);
+    fclose(file);
+
+    if (failed || header_packets < 2 || table->pages.empty()) {
+        if (!failed) {
+            std::cerr << "❌ Truncated Ogg Opus stream: " << path << std::endl;
+        }
+        return nullptr;
+    }
+    std::cerr << "🧭 Built Opus seek table: " << table->pages.size() << " pages, " << path << std::endl;
+    return table;
+}
+
+// Seek table of the file as it is now, built on first use
+static std::shared_ptr<const opus_seek_table> seek_table(const std::string& path) {
+    std::error_code error;
+    const int64_t file_size = (int64_t) std::filesystem::file_size(path, error);
+    const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+    if (error) {
+        std::cerr << "❌ Could not open file: " << path << std::endl;
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_seek_tables_mutex);
+        auto found = g_seek_tables.find(path);
+        if (found != g_seek_tables.end() && found->second->file_size == file_size &&
+            found->second->modified == modified) {
+            found->second->last_used = ++g_seek_table_clock;
+            return found->second;
+        }
+    }
+
+    std::shared_ptr<opus_seek_table> table = build_seek_table(path);
+    if (!table) {
+        return nullptr;
+    }
+    table->file_size = file_size;
+    table->modified = modified;
+
+    std::lock_guard<std::mutex> lock(g_seek_tables_mutex);
+    table->last_used = ++g_seek_table_clock;
+    g_seek_tables[path] = table;
+    if (g_seek_tables.size() > SEEK_TABLE_CACHE_SIZE) {
+        auto oldest = std::min_element(g_seek_tables.begin(), g_seek_tables.end(), [](const auto& a, const auto& b) {
+            return a.second->last_used < b.second->last_used;
+        });
+        g_seek_tables.erase(oldest);
+    }
+    return table;
+}
+
+std::vector<float> decode_ogg_opus_range(const std::string& path, size_t begin, size_t end) {
+    const std::shared_ptr<const opus_seek_table> table = seek_table(path);
+    if (!table || begin >= end) {
+        return {};
+    }
+
+    // Start right after the last page that ends before the pre-roll; output
+    // sample s sits at granule position (s + pre_skip) * 3
+    const int64_t start_granule = ((int64_t) begin - OPUS_PREROLL_SAMPLES + table->pre_skip) * OPUS_GRANULE_SCALE;
+    auto after = std::upper_bound(table->pages.begin(), table->pages.end(), start_granule,
+                                  [](int64_t granule, const opus_seek_table::page& page) { return granule < page.granule; });
+    const int64_t start_offset = after == table->pages.begin() ? table->audio_offset : std::prev(after)->next_offset;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "❌ Could not open file: " << path << std::endl;
+        return {};
+    }
+    OpusDecoder* decoder = create_decoder(table->channels);
+    if (!decoder || fseek(file, (long) start_offset, SEEK_SET) != 0) {
+        if (decoder) {
+            opus_decoder_destroy(decoder);
+        }
+        fclose(file);
+        return {};
+    }
+
+    ogg_sync_state sync;
+    ogg_sync_init(&sync);
+    ogg_stream_state stream;
+    ogg_stream_init(&stream, table->serialno);
+
+    std::vector<float> pcm;
+    std::vector<float> page_pcm; // Decoded from the current page, position known once its granule is read
+    std::vector<float> decoded(OPUS_MAX_FRAME_SAMPLES * 2);
+    int64_t position = -1;       // Output sample of the next decoded sample, unknown until the first granule
+    bool done = false;
+
+    while (!done) {
+        char* buffer = ogg_sync_buffer(&sync, OPUS_READ_BYTES);
+        const size_t n = fread(buffer, 1, OPUS_READ_BYTES, file);
+        if (n == 0) {
+            break;
+        }
+        ogg_sync_wrote(&sync, (long) n);
+
+        ogg_page page;
+        while (!done && ogg_sync_pageout(&sync, &page) == 1) {
+            if (ogg_page_serialno(&page) != table->serialno || ogg_stream_pagein(&stream, &page) != 0) {
+                continue;
+            }
+            ogg_packet packet;
+            int result;
+            // -1 is the packet that began before the seek point
+            while ((result = ogg_stream_packetout(&stream, &packet)) != 0) {
+                if (result == 1) {
+                    decode_packet(decoder, packet, table->channels, decoded, page_pcm);
+                }
+            }
+            if (ogg_page_granulepos(&page) < 0) {
+                continue;
+            }
+
+            const int64_t page_end = ogg_page_granulepos(&page) / OPUS_GRANULE_SCALE - table->pre_skip;
+            const int64_t page_start = position >= 0 ? position : page_end - (int64_t) page_pcm.size();
+            // The final granule position trims the encoder padding
+            const int64_t usable = std::clamp<int64_t>(page_end - page_start, 0, (int64_t) page_pcm.size());
+            const int64_t from = std::clamp<int64_t>((int64_t) begin - page_start, 0, usable);
+            const int64_t to = std::clamp<int64_t>((int64_t) end - page_start, from, usable);
+            pcm.insert(pcm.end(), page_pcm.begin() + from, page_pcm.begin() + to);
+            page_pcm.clear();
+
+            position = page_start + usable;
+            done = position >= (int64_t) end || ogg_page_eos(&page);
+        }
+    }
+
+    ogg_stream_clear(&stream);
+    ogg_sync_clear(&sync);
+    opus_decoder_destroy(decoder);
+    fclose(file);
+
+    std::cout << "✅ Decoded Opus range: " << pcm.size() << " samples from " << begin / (float) OPUS_SAMPLE_RATE
+              << " s" << std::endl;
+    return pcm;
+}
+
+#else
+
+bool encode_ogg_opus(const std::vector<float>& pcm, const std::string& path, int bitrate) {
+    (void) pcm;
+    (void) bitrate;
+    std::cerr << "❌ Opus support not built in, cannot write " << path << std::endl;
+    return false;
+}
+
+std::vector<float> decode_ogg_opus(const audio_read_fn& read, const std::string& label) {
+    (void) read;
+    std::cerr << "❌ Opus support not built in, cannot read " << label << std::endl;
+    return {};
+}
+
+std::vector<float> decode_ogg_opus_range(const std::string& path, size_t begin, size_t end) {
+    (void) begin;
+    (void) end;
+    std::cerr << "❌ Opus support not built in, cannot read " << path << std::endl;
+    return {};
+}
+
+#endif
+
+std::vector<float> decode_ogg_opus(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "❌ Could not open file: " << path << std::endl;
+        return {};
+    }
+    std::vector<float> pcm = decode_ogg_opus([file](void* buffer, size_t size) -> int64_t {
+        const size_t n = fread(buffer, 1, size, file);
+        return n == 0 && ferror(file) ? -1 : (int64_t) n;
+    }, path);
+    fclose(file);
+    return pcm;
+}
+
+extern "C" {
+
+bool whisper_ffi_encode_opus(const char* audio_path, const char* opus_path, int bitrate) {
+    if (!audio_path || !opus_path) {
+        std::cerr << "❌ Invalid parameters for Opus encode" << std::endl;
+        return false;
+    }
+
+    try {
+        scratch_pcm pcm(scratch_slot::pcm);
+        if (!read_audio_file(audio_path, *pcm)) {
+            std::cerr << "❌ No audio to encode: " << audio_path << std::endl;
+            return false;
+        }
+        return encode_ogg_opus(*pcm, opus_path, bitrate);
+    } catch (...) {
+        std::cerr << "💥 Exception during Opus encode" << std::endl;
+        return false;
+    }
+}
+
+}
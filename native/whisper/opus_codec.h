@@ -0,0 +1,35 @@
+#ifndef OPUS_CODEC_H
+#define OPUS_CODEC_H
+
+// Ogg Opus storage for recordings.
+//
+// Recordings are encoded at Whisper's 16 kHz with libopus tuned for speech,
+// and decoded by libopus straight back to 16 kHz float, so no WAV or
+// resampling step sits between a stored memo and inference.
+// Requires a build with WHISPER_FFI_WITH_OPUS (libopus + libogg); without
+// it they log and fail.
+
+#include "audio_stream.h"
+#include <string>
+#include <vector>
+
+// Default bitrate for speech memos, in bits per second
+static const int OPUS_SPEECH_BITRATE = 24000;
+
+// Encode 16 kHz mono samples to an Ogg Opus file
+bool encode_ogg_opus(const std::vector<float>& pcm, const std::string& path, int bitrate);
+
+// Decode an Ogg Opus file to 16 kHz mono samples (empty on failure)
+std::vector<float> decode_ogg_opus(const std::string& path);
+
+// Same for an Ogg Opus byte stream read front to back; `label` names it in logs
+std::vector<float> decode_ogg_opus(const audio_read_fn& read, const std::string& label);
+
+// Samples [begin, end) of an Ogg Opus file, decoding only from the page
+// before `begin` (less the 80 ms decoder pre-roll). Pages are found in a
+// seek table of page granule positions and byte offsets, built by one pass
+// over the page headers and cached per file until it changes. Empty on
+// failure or past the end.
+std::vector<float> decode_ogg_opus_range(const std::string& path, size_t begin, size_t end);
+
+#endif // OPUS_CODEC_H
@@ -0,0 +1,181 @@
+#include "preview_job.h"
+#include "audio_features.h"
+#include "diarization.h"
+#include <algorithm>
+#include <iostream>
+
+static const int64_t PREVIEW_DEFAULT_MS = 60 * 1000;
+static const int64_t SAMPLES_PER_MS = WHISPER_SAMPLE_RATE / 1000;
+// A speech region running this far past the preview length is cut mid-region
+static const size_t PREVIEW_MAX_OVERRUN = 15 * WHISPER_SAMPLE_RATE;
+// A shorter rest is decoded together with the preview
+static const size_t PREVIEW_MIN_REST = 5 * WHISPER_SAMPLE_RATE;
+
+// First sample after the preview: once `preview_ms` of speech has been
+// seen, the middle of the pause that ends the current speech region
+static size_t preview_cut(const std::vector<float>& pcm, int64_t preview_ms) {
+    const std::vector<audio_region> regions = detect_speech_regions(pcm);
+    const size_t wanted = (size_t) (preview_ms * SAMPLES_PER_MS);
+    size_t speech = 0;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        const audio_region& region = regions[i];
+        if (speech + (region.end - region.begin) < wanted) {
+            speech += region.end - region.begin;
+            continue;
+        }
+        const size_t reached = region.begin + (wanted - speech);
+        if (region.end - reached > PREVIEW_MAX_OVERRUN) {
+            return reached;
+        }
+        return i + 1 < regions.size() ? (region.end + regions[i + 1].begin) / 2 : pcm.size();
+    }
+    return pcm.size();
+}
+
+whisper_ffi_preview_job::whisper_ffi_preview_job(whisper_context* ctx, const whisper_ffi_transcribe_params& params)
+    : ctx(ctx), params(params), language(params.language ? params.language : "") {
+    this->params.language = params.language ? language.c_str() : nullptr;
+}
+
+whisper_ffi_preview_job::~whisper_ffi_preview_job() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool whisper_ffi_preview_job::start(std::vector<float> audio, int64_t preview_ms) {
+    pcm = std::move(audio);
+    cut = preview_cut(pcm, preview_ms > 0 ? preview_ms : PREVIEW_DEFAULT_MS);
+    if (pcm.size() - cut < PREVIEW_MIN_REST) {
+        cut = pcm.size();
+    }
+    std::cerr << "👀 Preview: first " << cut / SAMPLES_PER_MS << " ms of " << pcm.size() / SAMPLES_PER_MS
+              << " ms at high priority" << std::endl;
+
+    const std::vector<float> head(pcm.begin(), pcm.begin() + cut);
+    const bool preview_ok = transcribe_pcm(ctx, nullptr, head, params, [this](ffi_segment&& segment) {
+        preview.push_back(std::move(segment));
+        return true;
+    }, lease_priority::high);
+    if (!preview_ok) {
+        return false;
+    }
+
+    if (cut == pcm.size()) {
+        segments = preview;
+        ok = true;
+        done = true;
+    } else {
+        worker = std::thread(&whisper_ffi_preview_job::decode_rest, this);
+    }
+    return true;
+}
+
+void whisper_ffi_preview_job::decode_rest() {
+    try {
+        // Speakers are labelled over the whole recording below
+        whisper_ffi_transcribe_params rest_params = params;
+        rest_params.diarize = false;
+
+        const std::vector<float> rest(pcm.begin() + cut, pcm.end());
+        const int64_t offset_ms = (int64_t) cut / SAMPLES_PER_MS;
+        std::vector<ffi_segment> all = preview;
+        ok = transcribe_pcm(ctx, nullptr, rest, rest_params, [this, &all, offset_ms](ffi_segment&& segment) {
+            shift_segment(segment, offset_ms);
+            all.push_back(std::move(segment));
+            return !cancelled;
+        });
+
+        if (ok && params.diarize) {
+            for (ffi_segment& segment : all) {
+                segment.speaker = -1;
+            }
+            diarize_segments(pcm, all, params.max_speakers);
+        }
+        segments = std::move(all);
+    } catch (...) {
+        std::cerr << "💥 Exception during preview transcription" << std::endl;
+        ok = false;
+    }
+    done = true;
+}
+
+bool whisper_ffi_preview_job::wait() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+    return ok;
+}
+
+extern "C" {
+
+whisper_ffi_preview_job* whisper_ffi_preview_start(whisper_context* ctx, const char* audio_path,
+                                                   const struct whisper_ffi_transcribe_params* params,
+                                                   int preview_ms) {
+    if (!ctx || !audio_path) {
+        std::cerr << "❌ Invalid parameters: ctx=" << (ctx ? "valid" : "null")
+                  << ", audio_path=" << (audio_path ? audio_path : "null") << std::endl;
+        return nullptr;
+    }
+
+    whisper_ffi_preview_job* job = nullptr;
+    try {
+        std::cerr << "🎵 Starting preview transcription for: " << audio_path << std::endl;
+        std::vector<float> pcm = read_audio_file(audio_path);
+        if (pcm.empty()) {
+            std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+            return nullptr;
+        }
+        job = new whisper_ffi_preview_job(ctx, params ? *params : whisper_ffi_transcribe_default_params());
+        if (!job->start(std::move(pcm), preview_ms)) {
+            delete job;
+            return nullptr;
+        }
+        return job;
+    } catch (...) {
+        std::cerr << "💥 Exception during preview transcription" << std::endl;
+        delete job;
+        return nullptr;
+    }
+}
+
+char* whisper_ffi_preview_json(whisper_ffi_preview_job* job) {
+    if (!job) {
+        return nullptr;
+    }
+    try {
+        return result_to_c_string(job->preview);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+bool whisper_ffi_preview_done(whisper_ffi_preview_job* job) {
+    return job && job->done;
+}
+
+void whisper_ffi_preview_cancel(whisper_ffi_preview_job* job) {
+    if (job && !job->done) {
+        std::cerr << "⏹️ Cancelling preview transcription" << std::endl;
+        job->cancelled = true;
+    }
+}
+
+char* whisper_ffi_preview_finish(whisper_ffi_preview_job* job) {
+    if (!job) {
+        return nullptr;
+    }
+    char* result = nullptr;
+    try {
+        if (job->wait()) {
+            std::cerr << "✅ Transcription completed successfully (" << job->segments.size() << " segments)" << std::endl;
+            result = result_to_c_string(job->segments);
+        }
+    } catch (...) {
+        std::cerr << "💥 Exception finishing preview transcription" << std::endl;
+    }
+    delete job;
+    return result;
+}
+
+}
@@ -0,0 +1,46 @@
+#ifndef PREVIEW_JOB_H
+#define PREVIEW_JOB_H
+
+// Preview-first transcription of long recordings.
+//
+// Users mostly glance at the start of a memo, so the opening stretch of
+// speech is decoded first, on the caller's thread and with a high-priority
+// thread lease that is served before queued normal decodes. The preview is
+// cut at a pause once enough speech has been seen (energy VAD). The rest of
+// the recording is decoded on a background thread at normal priority and
+// joined with the preview into the full result.
+
+#include "whisper_ffi_internal.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct whisper_ffi_preview_job {
+    whisper_ffi_preview_job(whisper_context* ctx, const whisper_ffi_transcribe_params& params);
+    ~whisper_ffi_preview_job();
+
+    // Decode the preview of `pcm` and start the rest; false if the preview failed
+    bool start(std::vector<float> pcm, int64_t preview_ms);
+
+    // Wait for the rest; false if it failed
+    bool wait();
+
+    std::vector<ffi_segment> preview;
+    std::vector<ffi_segment> segments; // Full result once wait() returned true
+    std::atomic<bool> done{false};
+    std::atomic<bool> cancelled{false}; // Stops the rest at its next segment; wait() then fails
+
+private:
+    void decode_rest();
+
+    whisper_context* ctx;
+    whisper_ffi_transcribe_params params;
+    std::string language; // Owns params.language, which the rest is decoded with after the call returns
+    std::vector<float> pcm;
+    size_t cut = 0; // First sample after the preview
+    bool ok = false;
+    std::thread worker;
+};
+
+#endif // PREVIEW_JOB_H
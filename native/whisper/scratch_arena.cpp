@@ -0,0 +1,159 @@
+#include "scratch_arena.h"
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+static const size_t SCRATCH_TRIM_WINDOW = 8;             // Jobs whose use sets the high-water mark
+static const size_t SCRATCH_TRIM_RATIO = 2;              // Shrink when holding more than this times the mark
+static const size_t SCRATCH_TRIM_MIN_BYTES = 4u << 20;   // Smaller buffers are always kept
+
+template <typename Buffer>
+struct scratch_state {
+    Buffer buffer;
+    bool lent = false;
+    size_t recent[SCRATCH_TRIM_WINDOW] = {}; // Elements used by the last jobs
+    size_t jobs = 0;
+    size_t counted_bytes = 0;                // This buffer's share of g_retained_bytes
+};
+
+static std::atomic<uint64_t> g_borrows(0);
+static std::atomic<uint64_t> g_reuses(0);
+static std::atomic<uint64_t> g_grows(0);
+static std::atomic<uint64_t> g_fallbacks(0);
+static std::atomic<uint64_t> g_trims(0);
+static std::atomic<uint64_t> g_retained_bytes(0);
+static std::atomic<uint64_t> g_peak_retained_bytes(0);
+
+template <typename Buffer>
+static size_t capacity_bytes(const Buffer& buffer) {
+    return buffer.capacity() * sizeof(typename Buffer::value_type);
+}
+
+template <typename Buffer>
+static void recount(scratch_state<Buffer>& state) {
+    const size_t bytes = capacity_bytes(state.buffer);
+    const uint64_t retained = g_retained_bytes.fetch_add(bytes - state.counted_bytes) + (bytes - state.counted_bytes);
+    state.counted_bytes = bytes;
+    uint64_t peak = g_peak_retained_bytes.load();
+    while (retained > peak && !g_peak_retained_bytes.compare_exchange_weak(peak, retained)) {
+    }
+}
+
+template <typename Buffer>
+static void free_buffer(scratch_state<Buffer>& state) {
+    if (!state.lent) {
+        Buffer().swap(state.buffer);
+        recount(state);
+    }
+}
+
+struct scratch_arena {
+    scratch_state<std::vector<float>> pcm;
+    scratch_state<std::vector<float>> speech;
+    scratch_state<std::string> text;
+
+    void free_idle() {
+        free_buffer(pcm);
+        free_buffer(speech);
+        free_buffer(text);
+    }
+
+    ~scratch_arena() {
+        free_idle();
+    }
+};
+
+static thread_local scratch_arena t_arena;
+
+template <typename Buffer>
+static scratch_state<Buffer>& state_of(scratch_slot slot);
+
+template <>
+scratch_state<std::vector<float>>& state_of(scratch_slot slot) {
+    return slot == scratch_slot::pcm ? t_arena.pcm : t_arena.speech;
+}
+
+template <>
+scratch_state<std::string>& state_of(scratch_slot) {
+    return t_arena.text;
+}
+
+static const char* slot_name(scratch_slot slot) {
+    switch (slot) {
+        case scratch_slot::pcm: return "pcm";
+        case scratch_slot::speech: return "speech";
+        case scratch_slot::text: return "text";
+    }
+    return "?";
+}
+
+template <typename Buffer>
+scratch<Buffer>::scratch(scratch_slot slot) : slot_(slot), buffer_(&own_) {
+    scratch_state<Buffer>& state = state_of<Buffer>(slot);
+    if (state.lent) {
+        ++g_fallbacks;
+        return;
+    }
+    state.lent = true;
+    lent_ = true;
+    buffer_ = &state.buffer;
+    buffer_->clear();
+    borrowed_capacity_ = buffer_->capacity();
+}
+
+template <typename Buffer>
+scratch<Buffer>::~scratch() {
+    if (!lent_) {
+        return;
+    }
+    scratch_state<Buffer>& state = state_of<Buffer>(slot_);
+    const size_t used = buffer_->size();
+    // Borrows the job left empty (e.g. no music to cut) are not counted
+    if (buffer_->capacity() > borrowed_capacity_) {
+        ++g_borrows;
+        ++g_grows;
+    } else if (used > 0) {
+        ++g_borrows;
+        ++g_reuses;
+    }
+
+    state.recent[state.jobs++ % SCRATCH_TRIM_WINDOW] = used;
+    const size_t high_water = *std::max_element(std::begin(state.recent), std::end(state.recent));
+    const size_t held_bytes = capacity_bytes(*buffer_);
+    buffer_->clear();
+    if (held_bytes > SCRATCH_TRIM_MIN_BYTES && buffer_->capacity() > SCRATCH_TRIM_RATIO * high_water) {
+        Buffer().swap(*buffer_);
+        buffer_->reserve(high_water);
+        ++g_trims;
+        std::cerr << "🧽 Trimmed " << slot_name(slot_) << " scratch buffer from " << (held_bytes >> 20) << " to "
+                  << (capacity_bytes(*buffer_) >> 20) << " MB" << std::endl;
+    }
+    recount(state);
+    state.lent = false;
+}
+
+template class scratch<std::vector<float>>;
+template class scratch<std::string>;
+
+extern "C" {
+
+void whisper_ffi_get_scratch_stats(struct whisper_ffi_scratch_stats* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->borrows = g_borrows.load();
+    stats->reuses = g_reuses.load();
+    stats->grows = g_grows.load();
+    stats->fallbacks = g_fallbacks.load();
+    stats->trims = g_trims.load();
+    stats->retained_bytes = g_retained_bytes.load();
+    stats->peak_retained_bytes = g_peak_retained_bytes.load();
+}
+
+void whisper_ffi_scratch_trim(void) {
+    t_arena.free_idle();
+}
+
+}
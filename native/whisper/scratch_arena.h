@@ -0,0 +1,51 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+// Scratch buffers owned by each native worker thread.
+//
+// A transcription needs a few large buffers for as long as it runs: the
+// decoded PCM, the speech-only copy made when music and noise are skipped,
+// and the JSON text of the result. Allocating them per job and freeing them
+// afterwards leaves the allocator with fragmented blocks of every size the
+// process has seen, and under many calls of mixed lengths RSS creeps up.
+//
+// Instead each thread keeps one buffer per slot and lends it to its next
+// job, cleared but with its capacity. After a job a buffer is shrunk to the
+// largest use among its last few jobs when it holds far more than that, so
+// one two-hour recording does not pin hundreds of megabytes on a thread
+// that otherwise sees voice notes. A slot that is already lent on the
+// thread (a nested call) hands out a private buffer instead.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class scratch_slot { pcm = 0, speech = 1, text = 2 };
+
+// A buffer borrowed from the calling thread's arena; empty when borrowed and
+// returned (cleared, capacity kept or trimmed) when this goes out of scope.
+// Must be released on the thread that borrowed it.
+template <typename Buffer>
+class scratch {
+public:
+    explicit scratch(scratch_slot slot);
+    ~scratch();
+
+    scratch(const scratch&) = delete;
+    scratch& operator=(const scratch&) = delete;
+
+    Buffer& operator*() { return *buffer_; }
+    Buffer* operator->() { return buffer_; }
+
+private:
+    scratch_slot slot_;
+    Buffer* buffer_;
+    Buffer own_;                 // Used when the slot is already lent
+    size_t borrowed_capacity_ = 0;
+    bool lent_ = false;
+};
+
+using scratch_pcm = scratch<std::vector<float>>;
+using scratch_text = scratch<std::string>;
+
+#endif // SCRATCH_ARENA_H
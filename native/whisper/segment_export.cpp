@@ -0,0 +1,354 @@
+#include "segment_export.h"
+#include "whisper_wrapper.h"
+#include "scratch_arena.h"
+#include <iostream>
+
+#ifdef WHISPER_FFI_WITH_ARROW
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/dictionary.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/util/compression.h>
+#ifdef WHISPER_FFI_WITH_PARQUET
+#include <parquet/arrow/writer.h>
+#endif
+#endif
+
+static const int EXPORT_DEFAULT_ROWS_PER_BATCH = 64 * 1024;
+
+#ifdef WHISPER_FFI_WITH_ARROW
+
+template <typename Builder, typename... Columns>
+static arrow::Result<std::shared_ptr<arrow::Array>> build_column(const Columns&... columns) {
+    Builder builder;
+    ARROW_RETURN_NOT_OK(builder.AppendValues(columns...));
+    std::shared_ptr<arrow::Array> array;
+    ARROW_RETURN_NOT_OK(builder.Finish(&array));
+    return array;
+}
+
+struct segment_exporter::arrow_sink {
+    std::shared_ptr<arrow::Schema> schema;
+    std::shared_ptr<arrow::io::FileOutputStream> out;
+    // IPC goes through the payload writer so new file names can be written
+    // as explicit dictionary deltas; RecordBatchWriter would need the whole
+    // dictionary in every batch and diff it against the previous one
+    std::unique_ptr<arrow::ipc::internal::IpcPayloadWriter> ipc;
+    arrow::ipc::IpcWriteOptions ipc_options = arrow::ipc::IpcWriteOptions::Defaults();
+    int64_t file_dictionary_id = 0;
+    size_t written_files = 0;                  // IPC: files already in a dictionary message
+    std::shared_ptr<arrow::Array> dictionary;  // Parquet: every file, rebuilt when one is added
+#ifdef WHISPER_FFI_WITH_PARQUET
+    std::unique_ptr<parquet::arrow::FileWriter> parquet;
+#endif
+
+    arrow::Status open(const std::string& path, segment_export_format format, size_t rows_per_batch) {
+        schema = arrow::schema({
+            arrow::field("file", arrow::dictionary(arrow::int32(), arrow::utf8()), false),
+            arrow::field("segment", arrow::int32(), false),
+            arrow::field("t0_ms", arrow::int64(), false),
+            arrow::field("t1_ms", arrow::int64(), false),
+            arrow::field("text", arrow::utf8(), false),
+            arrow::field("confidence", arrow::float32(), false),
+            arrow::field("speaker", arrow::int32(), true),
+            arrow::field("suspect", arrow::boolean(), false),
+        });
+        ARROW_ASSIGN_OR_RAISE(out, arrow::io::FileOutputStream::Open(path));
+
+        if (format == SEGMENT_EXPORT_ARROW) {
+            ipc_options.emit_dictionary_deltas = true;
+            ARROW_ASSIGN_OR_RAISE(ipc, arrow::ipc::internal::MakePayloadFileWriter(out.get(), schema, ipc_options));
+            ARROW_RETURN_NOT_OK(ipc->Start());
+            // The payload writer leaves the schema message to its caller
+            const arrow::ipc::DictionaryFieldMapper mapper(*schema);
+            ARROW_ASSIGN_OR_RAISE(file_dictionary_id, mapper.GetFieldId({0}));
+            arrow::ipc::IpcPayload payload;
+            ARROW_RETURN_NOT_OK(arrow::ipc::GetSchemaPayload(*schema, ipc_options, mapper, &payload));
+            return ipc->WritePayload(payload);
+        }
+
+#ifdef WHISPER_FFI_WITH_PARQUET
+        parquet::WriterProperties::Builder properties;
+        properties.max_row_group_length((int64_t) rows_per_batch);
+        if (arrow::util::Codec::IsAvailable(arrow::Compression::ZSTD)) {
+            properties.compression(parquet::Compression::ZSTD);
+        }
+        // Keep the Arrow schema so readers get the file column back as a dictionary
+        std::shared_ptr<parquet::ArrowWriterProperties> arrow_properties =
+            parquet::ArrowWriterProperties::Builder().store_schema()->build();
+        ARROW_ASSIGN_OR_RAISE(parquet, parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(), out,
+                                                                        properties.build(), arrow_properties));
+        return arrow::Status::OK();
+#else
+        (void) rows_per_batch;
+        return arrow::Status::NotImplemented("library built without Parquet");
+#endif
+    }
+
+    // File column of a batch. IPC first writes the files added since the
+    // last batch as a dictionary delta and leaves the array's dictionary
+    // empty: the array only goes into a batch message, which carries just
+    // the indices. Parquet stores each row
+    // group self-contained and needs the full dictionary.
+    arrow::Result<std::shared_ptr<arrow::Array>> file_column(const std::vector<std::string>& files,
+                                                             const std::shared_ptr<arrow::Array>& indices) {
+        const std::shared_ptr<arrow::DataType>& type = schema->field(0)->type();
+        if (ipc) {
+            arrow::StringBuilder tail;
+            for (size_t i = written_files; i < files.size(); ++i) {
+                ARROW_RETURN_NOT_OK(tail.Append(files[i]));
+            }
+            std::shared_ptr<arrow::Array> new_files;
+            ARROW_RETURN_NOT_OK(tail.Finish(&new_files));
+            if (new_files->length() > 0) {
+                arrow::ipc::IpcPayload payload;
+                ARROW_RETURN_NOT_OK(arrow::ipc::GetDictionaryPayload(file_dictionary_id, written_files > 0, new_files,
+                                                                     ipc_options, &payload));
+                ARROW_RETURN_NOT_OK(ipc->WritePayload(payload));
+                written_files = files.size();
+                ARROW_ASSIGN_OR_RAISE(new_files, arrow::MakeEmptyArray(arrow::utf8()));
+            }
+            return std::make_shared<arrow::DictionaryArray>(type, indices, new_files);
+        }
+
+        if (!dictionary || dictionary->length() != (int64_t) files.size()) {
+            ARROW_ASSIGN_OR_RAISE(dictionary, build_column<arrow::StringBuilder>(files));
+        }
+        return arrow::DictionaryArray::FromArrays(type, indices, dictionary);
+    }
+
+    arrow::Status write(const std::shared_ptr<arrow::RecordBatch>& batch) {
+        if (ipc) {
+            arrow::ipc::IpcPayload payload;
+            ARROW_RETURN_NOT_OK(arrow::ipc::GetRecordBatchPayload(*batch, ipc_options, &payload));
+            return ipc->WritePayload(payload);
+        }
+#ifdef WHISPER_FFI_WITH_PARQUET
+        // One row group per batch
+        ARROW_ASSIGN_OR_RAISE(std::shared_ptr<arrow::Table> table, arrow::Table::FromRecordBatches({batch}));
+        return parquet->WriteTable(*table, batch->num_rows());
+#else
+        return arrow::Status::Invalid("no open writer");
+#endif
+    }
+
+    arrow::Status close() {
+        if (ipc) {
+            ARROW_RETURN_NOT_OK(ipc->Close());
+        }
+#ifdef WHISPER_FFI_WITH_PARQUET
+        if (parquet) {
+            ARROW_RETURN_NOT_OK(parquet->Close());
+        }
+#endif
+        return out->Close();
+    }
+};
+
+#else
+
+struct segment_exporter::arrow_sink {};
+
+#endif
+
+segment_exporter::segment_exporter() = default;
+
+segment_exporter::~segment_exporter() {
+    if (sink) {
+        finish();
+    }
+}
+
+bool segment_exporter::open(const std::string& path, segment_export_format format, int rows) {
+#ifdef WHISPER_FFI_WITH_ARROW
+    rows_per_batch = rows > 0 ? (size_t) rows : EXPORT_DEFAULT_ROWS_PER_BATCH;
+    std::unique_ptr<arrow_sink> opened(new arrow_sink());
+    const arrow::Status status = opened->open(path, format, rows_per_batch);
+    if (!status.ok()) {
+        std::cerr << "❌ Failed to create segment export " << path << ": " << status.ToString() << std::endl;
+        return false;
+    }
+    sink = std::move(opened);
+    std::cerr << "📊 Exporting segments to " << path << " ("
+              << (format == SEGMENT_EXPORT_PARQUET ? "Parquet" : "Arrow IPC") << ", " << rows_per_batch
+              << " rows per batch)" << std::endl;
+    return true;
+#else
+    (void) path;
+    (void) format;
+    (void) rows;
+    std::cerr << "❌ Segment export needs Arrow; this library was built without it" << std::endl;
+    return false;
+#endif
+}
+
+int32_t segment_exporter::file_id(const std::string& source) {
+    auto it = file_ids.find(source);
+    if (it != file_ids.end()) {
+        return it->second;
+    }
+    const int32_t id = (int32_t) files.size();
+    files.push_back(source);
+    file_ids.emplace(source, id);
+    next_segment.push_back(0);
+    return id;
+}
+
+bool segment_exporter::add(int32_t file, const ffi_segment& segment) {
+    if (!sink || failed || file < 0 || file >= (int32_t) files.size()) {
+        return false;
+    }
+    file_column.push_back(file);
+    segment_column.push_back(next_segment[file]++);
+    t0_column.push_back(segment.t0_ms);
+    t1_column.push_back(segment.t1_ms);
+    text_column.push_back(segment.text);
+    confidence_column.push_back(segment.p);
+    speaker_column.push_back(segment.speaker >= 0 ? segment.speaker : 0);
+    speaker_valid.push_back(segment.speaker >= 0);
+    suspect_column.push_back(segment.suspect);
+
+    return file_column.size() < rows_per_batch || flush_batch();
+}
+
+bool segment_exporter::flush_batch() {
+    if (file_column.empty()) {
+        return !failed;
+    }
+#ifdef WHISPER_FFI_WITH_ARROW
+    auto write = [this]() -> arrow::Status {
+        ARROW_ASSIGN_OR_RAISE(auto indices, build_column<arrow::Int32Builder>(file_column));
+        ARROW_ASSIGN_OR_RAISE(auto file, sink->file_column(files, indices));
+        ARROW_ASSIGN_OR_RAISE(auto segment, build_column<arrow::Int32Builder>(segment_column));
+        ARROW_ASSIGN_OR_RAISE(auto t0, build_column<arrow::Int64Builder>(t0_column));
+        ARROW_ASSIGN_OR_RAISE(auto t1, build_column<arrow::Int64Builder>(t1_column));
+        ARROW_ASSIGN_OR_RAISE(auto text, build_column<arrow::StringBuilder>(text_column));
+        ARROW_ASSIGN_OR_RAISE(auto confidence, build_column<arrow::FloatBuilder>(confidence_column));
+        ARROW_ASSIGN_OR_RAISE(auto speaker, build_column<arrow::Int32Builder>(speaker_column, speaker_valid));
+        ARROW_ASSIGN_OR_RAISE(auto suspect, build_column<arrow::BooleanBuilder>(suspect_column));
+        return sink->write(arrow::RecordBatch::Make(sink->schema, (int64_t) file_column.size(),
+                                                    {file, segment, t0, t1, text, confidence, speaker, suspect}));
+    };
+    const arrow::Status status = write();
+    if (!status.ok()) {
+        std::cerr << "❌ Failed to write segment batch: " << status.ToString() << std::endl;
+        failed = true;
+    }
+#endif
+
+    file_column.clear();
+    segment_column.clear();
+    t0_column.clear();
+    t1_column.clear();
+    text_column.clear();
+    confidence_column.clear();
+    speaker_column.clear();
+    speaker_valid.clear();
+    suspect_column.clear();
+    return !failed;
+}
+
+bool segment_exporter::finish() {
+    if (!sink) {
+        return false;
+    }
+    bool ok = flush_batch();
+#ifdef WHISPER_FFI_WITH_ARROW
+    const arrow::Status status = sink->close();
+    if (!status.ok()) {
+        std::cerr << "❌ Failed to close segment export: " << status.ToString() << std::endl;
+        ok = false;
+    }
+#endif
+    sink.reset();
+    if (ok) {
+        std::cerr << "✅ Segment export complete (" << files.size() << " files)" << std::endl;
+    }
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+// ---------------------------------------------------------------------------
+
+struct whisper_ffi_export_writer {
+    segment_exporter impl;
+};
+
+extern "C" {
+
+whisper_ffi_export_writer* whisper_ffi_export_create(const char* path, int format, int rows_per_batch) {
+    if (!path || (format != WHISPER_FFI_EXPORT_ARROW && format != WHISPER_FFI_EXPORT_PARQUET)) {
+        return nullptr;
+    }
+    try {
+        whisper_ffi_export_writer* writer = new whisper_ffi_export_writer();
+        if (!writer->impl.open(path, (segment_export_format) format, rows_per_batch)) {
+            delete writer;
+            return nullptr;
+        }
+        return writer;
+    } catch (...) {
+        std::cerr << "💥 Exception creating segment export: " << path << std::endl;
+        return nullptr;
+    }
+}
+
+bool whisper_ffi_export_add_segment(whisper_ffi_export_writer* writer, const char* source_file,
+                                    int64_t t0_ms, int64_t t1_ms, const char* text, float confidence) {
+    if (!writer || !source_file) {
+        return false;
+    }
+    try {
+        ffi_segment segment;
+        segment.t0_ms = t0_ms;
+        segment.t1_ms = t1_ms;
+        segment.text = text ? text : "";
+        segment.p = confidence;
+        std::lock_guard<std::mutex> lock(writer->impl.mutex);
+        return writer->impl.add(writer->impl.file_id(source_file), segment);
+    } catch (...) {
+        std::cerr << "💥 Exception exporting segment for: " << source_file << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_export_add_transcription(whisper_ffi_export_writer* writer, whisper_context* ctx,
+                                          const char* audio_path, const struct whisper_ffi_transcribe_params* params) {
+    if (!writer || !ctx || !audio_path) {
+        return false;
+    }
+
+    try {
+        scratch_pcm pcm(scratch_slot::pcm);
+        if (!read_audio_file(audio_path, *pcm)) {
+            std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+            return false;
+        }
+        // Rows go out as each window finishes; other transcriptions
+        // exporting into the same writer interleave per segment
+        return transcribe_pcm(ctx, nullptr, *pcm, params ? *params : whisper_ffi_transcribe_default_params(),
+                              [writer, audio_path](ffi_segment&& segment) {
+                                  std::lock_guard<std::mutex> lock(writer->impl.mutex);
+                                  return writer->impl.add(writer->impl.file_id(audio_path), segment);
+                              });
+    } catch (...) {
+        std::cerr << "💥 Exception exporting transcription for: " << audio_path << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_export_finish(whisper_ffi_export_writer* writer) {
+    if (!writer) {
+        return false;
+    }
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(writer->impl.mutex);
+        ok = writer->impl.finish();
+    }
+    delete writer;
+    return ok;
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef SEGMENT_EXPORT_H
+#define SEGMENT_EXPORT_H
+
+// Columnar export of transcription results for bulk analytics.
+//
+// Segments from any number of source files are buffered column by column
+// and written as one record batch (Arrow IPC) or row group (Parquet) every
+// rows_per_batch rows. One row per segment:
+//
+//   file        dictionary<int32, utf8>  source file, each path stored once
+//   segment     int32                    index of the segment in its file
+//   t0_ms       int64
+//   t1_ms       int64
+//   text        utf8
+//   confidence  float32                  mean text token probability
+//   speaker     int32 (null = none)      diarization label
+//   suspect     bool                     loop guard flag
+//
+// The file dictionary only grows: in Arrow IPC each batch is preceded by a
+// delta with just the files it adds, in Parquet every row group holds it all.
+// Needs Arrow (and Parquet for the Parquet format) at build time; without
+// them open() fails with a log message.
+
+#include "whisper_ffi_internal.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum segment_export_format {
+    SEGMENT_EXPORT_ARROW   = 0,
+    SEGMENT_EXPORT_PARQUET = 1,
+};
+
+struct segment_exporter {
+    segment_exporter();
+    ~segment_exporter();
+
+    bool open(const std::string& path, segment_export_format format, int rows_per_batch);
+
+    // Dictionary id of a source file, added on first use
+    int32_t file_id(const std::string& source);
+    bool add(int32_t file, const ffi_segment& segment);
+    bool finish();
+
+    // Serializes adds from concurrent transcriptions
+    std::mutex mutex;
+
+private:
+    struct arrow_sink;
+
+    bool flush_batch();
+
+    std::unique_ptr<arrow_sink> sink;
+    size_t rows_per_batch = 0;
+    bool failed = false;
+
+    std::vector<std::string> files;
+    std::unordered_map<std::string, int32_t> file_ids;
+    std::vector<int32_t> next_segment; // Per file
+
+    // Buffered columns of the current batch
+    std::vector<int32_t> file_column;
+    std::vector<int32_t> segment_column;
+    std::vector<int64_t> t0_column;
+    std::vector<int64_t> t1_column;
+    std::vector<std::string> text_column;
+    std::vector<float> confidence_column;
+    std::vector<int32_t> speaker_column;
+    std::vector<bool> speaker_valid;
+    std::vector<bool> suspect_column;
+};
+
+#endif // SEGMENT_EXPORT_H
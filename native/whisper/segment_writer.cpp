@@ -0,0 +1,199 @@
+#include "segment_writer.h"
+#include "scratch_arena.h"
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+static const int WRITER_DEFAULT_FLUSH_MS = 1000;
+static const size_t WRITER_FLUSH_BYTES = 64 * 1024;
+
+segment_writer::segment_writer(segment_write_fn write, segment_writer_format format, int flush_ms)
+    : write(std::move(write)),
+      format(format),
+      flush_interval(flush_ms > 0 ? flush_ms : WRITER_DEFAULT_FLUSH_MS),
+      last_flush(std::chrono::steady_clock::now()) {
+    if (format == SEGMENT_WRITER_VTT) {
+        pending = "WEBVTT\n\n";
+    }
+}
+
+// HH:MM:SS,mmm (SRT) or HH:MM:SS.mmm (WebVTT)
+static void append_cue_time(std::string& out, int64_t ms, char separator) {
+    ms = std::max<int64_t>(ms, 0);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%02lld:%02lld:%02lld%c%03lld", (long long) (ms / 3600000),
+             (long long) (ms / 60000 % 60), (long long) (ms / 1000 % 60), separator, (long long) (ms % 1000));
+    out += buf;
+}
+
+// Cue text on one line: a blank line would end the cue early
+static void append_cue_text(std::string& out, const std::string& text, bool vtt) {
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    const size_t end = text.find_last_not_of(" \t\r\n");
+    for (size_t i = begin; i != std::string::npos && i <= end; ++i) {
+        const char c = text[i];
+        if (c == '\n' || c == '\r') {
+            out += ' ';
+        } else if (vtt && c == '&') {
+            out += "&amp;";
+        } else if (vtt && c == '<') {
+            out += "&lt;";
+        } else if (vtt && c == '>') {
+            out += "&gt;";
+        } else {
+            out += c;
+        }
+    }
+}
+
+void segment_writer::format_cue(const ffi_segment& segment) {
+    if (format == SEGMENT_WRITER_JSONL) {
+        append_segment_json(pending, segment);
+        pending += '\n';
+        return;
+    }
+    if (segment.text.find_first_not_of(" \t\r\n") == std::string::npos) {
+        return; // An empty cue would end the file for some players
+    }
+
+    const bool vtt = format == SEGMENT_WRITER_VTT;
+    if (!vtt) {
+        pending += std::to_string(++cues);
+        pending += '\n';
+    }
+    append_cue_time(pending, segment.t0_ms, vtt ? '.' : ',');
+    pending += " --> ";
+    append_cue_time(pending, segment.t1_ms, vtt ? '.' : ',');
+    pending += '\n';
+    if (segment.speaker >= 0) {
+        pending += vtt ? "<v Speaker " : "Speaker ";
+        pending += std::to_string(segment.speaker + 1);
+        pending += vtt ? ">" : ": ";
+    }
+    append_cue_text(pending, segment.text, vtt);
+    pending += "\n\n";
+}
+
+bool segment_writer::add(const ffi_segment& segment) {
+    if (failed) {
+        return false;
+    }
+    format_cue(segment);
+    if (pending.size() >= WRITER_FLUSH_BYTES || std::chrono::steady_clock::now() - last_flush >= flush_interval) {
+        return flush();
+    }
+    return true;
+}
+
+bool segment_writer::flush() {
+    if (!failed && !pending.empty()) {
+        failed = !write(pending.data(), pending.size());
+        if (failed) {
+            std::cerr << "❌ Failed to write transcript output" << std::endl;
+        }
+        pending.clear();
+    }
+    last_flush = std::chrono::steady_clock::now();
+    return !failed;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+// ---------------------------------------------------------------------------
+
+struct whisper_ffi_segment_writer {
+    FILE* file = nullptr;
+    std::unique_ptr<segment_writer> impl;
+};
+
+static bool valid_writer_format(int format) {
+    return format == WHISPER_FFI_WRITER_SRT || format == WHISPER_FFI_WRITER_VTT || format == WHISPER_FFI_WRITER_JSONL;
+}
+
+extern "C" {
+
+whisper_ffi_segment_writer* whisper_ffi_writer_create(const char* path, int format, int flush_ms) {
+    if (!path || !valid_writer_format(format)) {
+        return nullptr;
+    }
+    try {
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            std::cerr << "❌ Could not create transcript file: " << path << std::endl;
+            return nullptr;
+        }
+        whisper_ffi_segment_writer* writer = new whisper_ffi_segment_writer();
+        writer->file = file;
+        writer->impl = std::make_unique<segment_writer>([file](const char* data, size_t size) {
+            return fwrite(data, 1, size, file) == size && fflush(file) == 0;
+        }, (segment_writer_format) format, flush_ms);
+        std::cerr << "📝 Writing transcript to " << path << std::endl;
+        return writer;
+    } catch (...) {
+        std::cerr << "💥 Exception creating transcript file: " << path << std::endl;
+        return nullptr;
+    }
+}
+
+whisper_ffi_segment_writer* whisper_ffi_writer_create_callback(whisper_ffi_write_callback write, void* user_data,
+                                                               int format, int flush_ms) {
+    if (!write || !valid_writer_format(format)) {
+        return nullptr;
+    }
+    try {
+        whisper_ffi_segment_writer* writer = new whisper_ffi_segment_writer();
+        writer->impl = std::make_unique<segment_writer>([write, user_data](const char* data, size_t size) {
+            return write(user_data, data, (int64_t) size) == (int64_t) size;
+        }, (segment_writer_format) format, flush_ms);
+        return writer;
+    } catch (...) {
+        std::cerr << "💥 Exception creating transcript writer" << std::endl;
+        return nullptr;
+    }
+}
+
+bool whisper_ffi_writer_add_transcription(whisper_ffi_segment_writer* writer, whisper_context* ctx,
+                                          const char* audio_path, const struct whisper_ffi_transcribe_params* params) {
+    if (!writer || !ctx || !audio_path) {
+        return false;
+    }
+
+    try {
+        scratch_pcm pcm(scratch_slot::pcm);
+        if (!read_audio_file(audio_path, *pcm)) {
+            std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+            return false;
+        }
+        // A failed write stops the decode instead of transcribing into the void
+        const bool ok = transcribe_pcm(ctx, nullptr, *pcm, params ? *params : whisper_ffi_transcribe_default_params(),
+                                       [writer](ffi_segment&& segment) {
+                                           std::lock_guard<std::mutex> lock(writer->impl->mutex);
+                                           return writer->impl->add(segment);
+                                       });
+        std::lock_guard<std::mutex> lock(writer->impl->mutex);
+        return writer->impl->flush() && ok;
+    } catch (...) {
+        std::cerr << "💥 Exception writing transcript for: " << audio_path << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_writer_finish(whisper_ffi_segment_writer* writer) {
+    if (!writer) {
+        return false;
+    }
+    bool ok = false;
+    {
+        std::lock_guard<std::mutex> lock(writer->impl->mutex);
+        ok = writer->impl->flush();
+    }
+    if (writer->file && fclose(writer->file) != 0) {
+        std::cerr << "❌ Failed to close transcript file" << std::endl;
+        ok = false;
+    }
+    delete writer;
+    return ok;
+}
+
+}
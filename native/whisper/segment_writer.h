@@ -0,0 +1,57 @@
+#ifndef SEGMENT_WRITER_H
+#define SEGMENT_WRITER_H
+
+// Subtitle and transcript files written while the recording is decoded.
+//
+// Each segment is formatted as it arrives from transcribe_pcm and appended
+// to a small pending buffer. The buffer goes to the file or write callback
+// once flush_ms has passed since the last write, when it passes 64 KB, and
+// at the end. Output memory stays bounded however long the recording is,
+// and everything written so far is complete cues (or lines) that players
+// and parsers accept before the decode finishes:
+//   - SRT: numbered cues, "HH:MM:SS,mmm --> HH:MM:SS,mmm"
+//   - WebVTT: "WEBVTT" header, "HH:MM:SS.mmm" times, speakers as <v> tags
+//   - JSON Lines: one segment object per line, as in the JSON result block
+// Segments with diarization are only labelled once the whole recording is
+// decoded, so they are all written at the end.
+
+#include "whisper_ffi_internal.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+
+enum segment_writer_format {
+    SEGMENT_WRITER_SRT   = 0,
+    SEGMENT_WRITER_VTT   = 1,
+    SEGMENT_WRITER_JSONL = 2,
+};
+
+// Writes all `size` bytes or returns false
+using segment_write_fn = std::function<bool(const char* data, size_t size)>;
+
+struct segment_writer {
+    segment_writer(segment_write_fn write, segment_writer_format format, int flush_ms);
+
+    bool add(const ffi_segment& segment);
+    // Write what is pending
+    bool flush();
+
+    // Serializes adds from the decoder and the caller
+    std::mutex mutex;
+
+private:
+    void format_cue(const ffi_segment& segment);
+
+    segment_write_fn write;
+    segment_writer_format format;
+    std::chrono::milliseconds flush_interval;
+    std::chrono::steady_clock::time_point last_flush;
+    std::string pending;
+    int64_t cues = 0;
+    bool failed = false;
+};
+
+#endif // SEGMENT_WRITER_H
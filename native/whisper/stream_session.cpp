@@ -0,0 +1,332 @@
+#include "stream_session.h"
+#include "cpu_budget.h"
+#include "loop_guard.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static const int64_t SAMPLES_PER_MS = WHISPER_SAMPLE_RATE / 1000;
+static const size_t MIN_DECODE_SAMPLES = WHISPER_SAMPLE_RATE / 10; // Below 100 ms there is nothing to decode
+static const int DEFAULT_MAX_LAG_MS = 3000;
+static const int ENCODER_FRAME_MS = 20;
+static const int SHORT_CONTEXT_MARGIN = 64; // Encoder frames kept past the end of the window
+static const int SPARSE_STEPS = 3;          // Steps between passes in WHISPER_FFI_STREAM_MODE_SPARSE
+// Passes behind max_lag_ms before stepping down, and passes with headroom
+// (no backlog, decoding within HEADROOM_RATIO of a step) before stepping up
+static const int BEHIND_PASSES = 2;
+static const int HEADROOM_PASSES = 10;
+static const double HEADROOM_RATIO = 0.4;
+static const int SNAPSHOT_ATTEMPTS = 4;
+
+static const char* mode_name(int mode) {
+    switch (mode) {
+        case WHISPER_FFI_STREAM_MODE_FULL: return "full";
+        case WHISPER_FFI_STREAM_MODE_SHORT_CONTEXT: return "short context";
+        case WHISPER_FFI_STREAM_MODE_GREEDY: return "greedy";
+        case WHISPER_FFI_STREAM_MODE_SPARSE: return "sparse";
+        default: return "fallback model";
+    }
+}
+
+// Copy the last `capacity` bytes of text without starting inside a UTF-8 sequence
+static uint32_t copy_tail(char* dst, size_t capacity, const std::string& text) {
+    size_t begin = text.size() > capacity ? text.size() - capacity : 0;
+    while (begin < text.size() && ((unsigned char) text[begin] & 0xC0) == 0x80) {
+        ++begin;
+    }
+    memcpy(dst, text.data() + begin, text.size() - begin);
+    return (uint32_t) (text.size() - begin);
+}
+
+whisper_ffi_stream::whisper_ffi_stream(whisper_context* ctx, whisper_state* state, whisper_state* fallback_state,
+                                       const whisper_ffi_stream_params& params)
+    : ctx(ctx), state(state), fallback_state(fallback_state), params(params) {
+    this->params.step_ms = std::max(100, params.step_ms);
+    this->params.max_lag_ms = params.max_lag_ms > 0 ? params.max_lag_ms : DEFAULT_MAX_LAG_MS;
+    // Whisper decodes at most one 30 s window per pass
+    this->params.max_window_ms = std::clamp(params.max_window_ms, this->params.step_ms, WHISPER_CHUNK_SIZE * 1000);
+    worker = std::thread(&whisper_ffi_stream::run, this);
+}
+
+whisper_ffi_stream::~whisper_ffi_stream() {
+    stop();
+    release_states(ctx, {state});
+    if (fallback_state) {
+        release_states(params.fallback_ctx, {fallback_state});
+    }
+}
+
+bool whisper_ffi_stream::push(const float* samples, int n_samples) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping) {
+        return false;
+    }
+    pending.insert(pending.end(), samples, samples + n_samples);
+    pushed_samples += n_samples;
+    if (pending.size() >= (size_t) (params.step_ms * SAMPLES_PER_MS)) {
+        audio_ready.notify_one();
+    }
+    return true;
+}
+
+void whisper_ffi_stream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        audio_ready.notify_one();
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void whisper_ffi_stream::run() {
+    const size_t step = (size_t) (params.step_ms * SAMPLES_PER_MS);
+    std::vector<float> incoming;
+    for (;;) {
+        bool flush = false;
+        int64_t pass_lag_ms = 0;
+        {
+            // Fewer passes, each over more new audio, once tentative re-decodes are skipped
+            const size_t wanted = mode >= WHISPER_FFI_STREAM_MODE_SPARSE ? SPARSE_STEPS * step : step;
+            std::unique_lock<std::mutex> lock(mutex);
+            audio_ready.wait(lock, [&] { return stopping || pending.size() >= wanted; });
+            incoming.swap(pending);
+            flush = stopping;
+            pass_lag_ms = pushed_samples / SAMPLES_PER_MS - decoded_ms;
+        }
+        window.insert(window.end(), incoming.begin(), incoming.end());
+        incoming.clear();
+
+        lag_ms = pass_lag_ms;
+        const auto start = std::chrono::steady_clock::now();
+        decode_window(flush);
+        if (flush) {
+            return;
+        }
+        adapt(pass_lag_ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+void whisper_ffi_stream::decode_window(bool flush) {
+    const int64_t window_ms = (int64_t) window.size() / SAMPLES_PER_MS;
+    decoded_ms = window_start_ms + window_ms;
+    if (window.size() < MIN_DECODE_SAMPLES) {
+        publish("", flush);
+        return;
+    }
+
+    const bool use_fallback = mode >= WHISPER_FFI_STREAM_MODE_FALLBACK_MODEL;
+    whisper_context* decode_ctx = use_fallback ? params.fallback_ctx : ctx;
+    whisper_state* decode_state = use_fallback ? fallback_state : state;
+
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    if (mode >= WHISPER_FFI_STREAM_MODE_SHORT_CONTEXT) {
+        // The encoder cost scales with its context; a short window needs few frames
+        wparams.audio_ctx = std::min(whisper_n_audio_ctx(decode_ctx),
+                                     (int) (window_ms / ENCODER_FRAME_MS) + SHORT_CONTEXT_MARGIN);
+    }
+    if (mode >= WHISPER_FFI_STREAM_MODE_GREEDY) {
+        wparams.greedy.best_of = 1;
+        wparams.temperature_inc = 0.0f;
+    }
+    wparams.print_progress = false;
+    wparams.print_realtime = false;
+    wparams.print_timestamps = false;
+    wparams.no_context = true;
+    wparams.n_threads = params.n_threads > 0 ? params.n_threads : default_decode_threads();
+    const thread_lease lease = lease_threads(wparams.n_threads);
+    wparams.n_threads = lease.threads();
+    // Silence between phrases is where Whisper loops; captions only need the cut
+    loop_guard guard;
+    install_loop_guard(wparams, guard);
+
+    if (whisper_full_with_state(decode_ctx, decode_state, wparams, window.data(), (int) window.size()) != 0) {
+        std::cerr << "❌ Stream decode failed at " << window_start_ms << " ms" << std::endl;
+        if (flush || window_ms >= params.max_window_ms) {
+            window_start_ms += window_ms;
+            window.clear();
+        }
+        publish("", flush);
+        return;
+    }
+
+    const int n_segments = whisper_full_n_segments_from_state(decode_state);
+    int n_commit = n_segments > 1 ? n_segments - 1 : 0;
+    if (flush || window_ms >= params.max_window_ms) {
+        n_commit = n_segments;
+    }
+
+    for (int i = 0; i < n_commit; ++i) {
+        const char* text = whisper_full_get_segment_text_from_state(decode_state, i);
+        stable_text += text ? text : "";
+    }
+    // Only the tail is ever published
+    if (stable_text.size() > 4 * WHISPER_FFI_CAPTION_STABLE_BYTES) {
+        stable_text.erase(0, stable_text.size() - 2 * WHISPER_FFI_CAPTION_STABLE_BYTES);
+    }
+
+    std::string tentative;
+    for (int i = n_commit; i < n_segments; ++i) {
+        const char* text = whisper_full_get_segment_text_from_state(decode_state, i);
+        tentative += text ? text : "";
+    }
+
+    // Drop committed audio; everything goes once the window is full
+    int64_t cut_ms = 0;
+    if (n_commit == n_segments && (flush || window_ms >= params.max_window_ms)) {
+        cut_ms = window_ms;
+    } else if (n_commit > 0) {
+        cut_ms = std::min(window_ms, whisper_full_get_segment_t1_from_state(decode_state, n_commit - 1) * 10);
+    }
+    if (cut_ms > 0) {
+        window.erase(window.begin(), window.begin() + (size_t) std::min<int64_t>(cut_ms * SAMPLES_PER_MS, window.size()));
+        window_start_ms += cut_ms;
+    }
+
+    publish(tentative, flush);
+}
+
+void whisper_ffi_stream::adapt(int64_t pass_lag_ms, double decode_ms) {
+    const int lowest = fallback_state ? WHISPER_FFI_STREAM_MODE_FALLBACK_MODEL : WHISPER_FFI_STREAM_MODE_SPARSE;
+    const int64_t pass_ms = (int64_t) params.step_ms * (mode >= WHISPER_FFI_STREAM_MODE_SPARSE ? SPARSE_STEPS : 1);
+
+    behind_passes = pass_lag_ms > params.max_lag_ms ? behind_passes + 1 : 0;
+    const bool headroom = pass_lag_ms <= pass_ms + params.step_ms / 2 && decode_ms < HEADROOM_RATIO * params.step_ms;
+    headroom_passes = headroom ? headroom_passes + 1 : 0;
+
+    if (behind_passes >= BEHIND_PASSES && mode < lowest) {
+        ++mode;
+        std::cerr << "🐢 Caption stream " << pass_lag_ms << " ms behind, stepping down to " << mode_name(mode)
+                  << " mode" << std::endl;
+    } else if (headroom_passes >= HEADROOM_PASSES && mode > WHISPER_FFI_STREAM_MODE_FULL) {
+        --mode;
+        std::cerr << "🐇 Caption stream has headroom (" << (int) decode_ms << " ms per pass), stepping up to "
+                  << mode_name(mode) << " mode" << std::endl;
+    } else {
+        return;
+    }
+    behind_passes = 0;
+    headroom_passes = 0;
+}
+
+void whisper_ffi_stream::publish(const std::string& tentative, bool final) {
+    std::atomic_ref<uint32_t> sequence(captions.sequence);
+    const uint32_t begin = sequence.load(std::memory_order_relaxed);
+    sequence.store(begin + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    captions.stable_length = copy_tail(captions.stable, sizeof(captions.stable), stable_text);
+    captions.tentative_length = copy_tail(captions.tentative, sizeof(captions.tentative), tentative);
+    captions.flags = final ? WHISPER_FFI_CAPTION_FINAL : 0u;
+    captions.audio_ms = decoded_ms;
+    captions.mode = (uint32_t) mode;
+    captions.lag_ms = (int32_t) std::min<int64_t>(lag_ms, INT32_MAX);
+
+    sequence.store(begin + 2, std::memory_order_release);
+}
+
+bool whisper_ffi_stream::snapshot(whisper_ffi_caption_buffer& out) {
+    std::atomic_ref<uint32_t> sequence(captions.sequence);
+    for (int attempt = 0; attempt < SNAPSHOT_ATTEMPTS; ++attempt) {
+        const uint32_t begin = sequence.load(std::memory_order_acquire);
+        if (begin & 1u) {
+            std::this_thread::yield(); // Update in progress
+            continue;
+        }
+
+        out.stable_length = std::min<uint32_t>(captions.stable_length, sizeof(out.stable));
+        out.tentative_length = std::min<uint32_t>(captions.tentative_length, sizeof(out.tentative));
+        out.flags = captions.flags;
+        out.audio_ms = captions.audio_ms;
+        out.mode = captions.mode;
+        out.lag_ms = captions.lag_ms;
+        memcpy(out.stable, captions.stable, out.stable_length);
+        memcpy(out.tentative, captions.tentative, out.tentative_length);
+
+        // Keeps the copies above from moving past the second read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == begin) {
+            out.sequence = begin;
+            return true;
+        }
+    }
+    return false;
+}
+
+extern "C" {
+
+struct whisper_ffi_stream_params whisper_ffi_stream_default_params(void) {
+    whisper_ffi_stream_params params;
+    params.step_ms = 1000;
+    params.max_window_ms = 10000;
+    params.n_threads = 0;
+    params.max_lag_ms = DEFAULT_MAX_LAG_MS;
+    params.fallback_ctx = nullptr;
+    return params;
+}
+
+whisper_ffi_stream* whisper_ffi_stream_start(whisper_context* ctx, const struct whisper_ffi_stream_params* params) {
+    if (!ctx) {
+        std::cerr << "❌ Invalid parameters: ctx=null" << std::endl;
+        return nullptr;
+    }
+
+    try {
+        const whisper_ffi_stream_params options = params ? *params : whisper_ffi_stream_default_params();
+        std::vector<whisper_state*> states = acquire_states(ctx, 1);
+        if (states.empty()) {
+            return nullptr;
+        }
+        whisper_state* fallback_state = nullptr;
+        if (options.fallback_ctx) {
+            std::vector<whisper_state*> fallback_states = acquire_states(options.fallback_ctx, 1);
+            if (fallback_states.empty()) {
+                std::cerr << "⚠️ No state for the fallback model, the stream will not switch models" << std::endl;
+            } else {
+                fallback_state = fallback_states[0];
+            }
+        }
+        std::cerr << "🎙️ Starting caption stream" << std::endl;
+        return new whisper_ffi_stream(ctx, states[0], fallback_state, options);
+    } catch (...) {
+        std::cerr << "💥 Exception starting caption stream" << std::endl;
+        return nullptr;
+    }
+}
+
+bool whisper_ffi_stream_push(whisper_ffi_stream* stream, const float* samples, int n_samples) {
+    if (!stream || !samples || n_samples < 0) {
+        return false;
+    }
+    try {
+        return stream->push(samples, n_samples);
+    } catch (...) {
+        std::cerr << "💥 Exception pushing stream audio" << std::endl;
+        return false;
+    }
+}
+
+const struct whisper_ffi_caption_buffer* whisper_ffi_stream_captions(whisper_ffi_stream* stream) {
+    return stream ? &stream->captions : nullptr;
+}
+
+bool whisper_ffi_stream_snapshot(whisper_ffi_stream* stream, struct whisper_ffi_caption_buffer* out) {
+    return stream && out && stream->snapshot(*out);
+}
+
+void whisper_ffi_stream_stop(whisper_ffi_stream* stream) {
+    if (stream) {
+        stream->stop();
+    }
+}
+
+void whisper_ffi_stream_free(whisper_ffi_stream* stream) {
+    if (stream) {
+        std::cerr << "🧹 Freeing caption stream" << std::endl;
+        delete stream;
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#ifndef STREAM_SESSION_H
+#define STREAM_SESSION_H
+
+// Live transcription of pushed audio.
+//
+// Audio since the last commit forms a rolling window that is re-decoded
+// every step. All segments but the last are followed by more speech and are
+// committed as stable text, the audio before them is dropped from the
+// window; the last segment stays tentative until more audio settles it or
+// the window reaches max_window_ms. Each pass publishes the stable tail and
+// the tentative text into the caption buffer under a seqlock, so readers on
+// other threads (Dart's UI isolate) poll it without locks or messages.
+//
+// Each pass measures how far decoding trails the pushed audio. A stream
+// that stays behind max_lag_ms steps down one WHISPER_FFI_STREAM_MODE_* at
+// a time (shorter encoder context, plain greedy, fewer tentative passes,
+// the fallback model), so captions keep up at lower quality; a run of fast
+// passes without backlog steps it back up.
+
+#include "whisper_ffi_internal.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct whisper_ffi_stream {
+    whisper_ffi_stream(whisper_context* ctx, whisper_state* state, whisper_state* fallback_state,
+                       const whisper_ffi_stream_params& params);
+    ~whisper_ffi_stream();
+
+    bool push(const float* samples, int n_samples);
+    void stop();
+    // Seqlock read of captions; false if every attempt raced the writer
+    bool snapshot(whisper_ffi_caption_buffer& out);
+
+    whisper_ffi_caption_buffer captions = {};
+
+private:
+    void run();
+    void decode_window(bool flush);
+    void adapt(int64_t lag_ms, double decode_ms);
+    void publish(const std::string& tentative, bool final);
+
+    whisper_context* ctx;
+    whisper_state* state;
+    whisper_state* fallback_state; // Of params.fallback_ctx, null without one
+    whisper_ffi_stream_params params;
+
+    std::mutex mutex;
+    std::condition_variable audio_ready;
+    std::vector<float> pending; // Pushed, not yet taken by the worker
+    int64_t pushed_samples = 0;
+    bool stopping = false;
+
+    // Worker thread only
+    std::vector<float> window; // Audio since the last commit
+    int64_t window_start_ms = 0;
+    int64_t decoded_ms = 0;
+    std::string stable_text;
+    int mode = WHISPER_FFI_STREAM_MODE_FULL;
+    int64_t lag_ms = 0;
+    int behind_passes = 0;
+    int headroom_passes = 0;
+
+    std::thread worker;
+};
+
+#endif // STREAM_SESSION_H
@@ -0,0 +1,79 @@
+// cgroup CPU quota parsing on fake /proc/self/cgroup files and cgroup
+// mounts: v2 cpu.max and v1 CFS files, looked up in the process's own cgroup
+// first and at the mount root (container namespaces) second.
+
+#include "cpu_budget.h"
+#include "test_common.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+static void write_file(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << content;
+}
+
+// Fresh directory holding a fake proc file and cgroup mount
+static std::filesystem::path fake_root(const std::string& name) {
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / ("whisper_ffi_test_" + name);
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "sys");
+    return root;
+}
+
+static double quota(const std::filesystem::path& root) {
+    return cgroup_quota_cpus((root / "cgroup").string(), (root / "sys").string());
+}
+
+int main() {
+    // v2, the process's own cgroup
+    {
+        const auto root = fake_root("cg_v2");
+        write_file(root / "cgroup", "0::/kubepods/pod1/ctr\n");
+        write_file(root / "sys/kubepods/pod1/ctr/cpu.max", "250000 100000\n");
+        CHECK(quota(root) == 2.5);
+        write_file(root / "sys/kubepods/pod1/ctr/cpu.max", "max 100000\n");
+        CHECK(quota(root) == 0.0);
+    }
+
+    // v2 inside a cgroup namespace: the path does not exist, the root file does
+    {
+        const auto root = fake_root("cg_v2_ns");
+        write_file(root / "cgroup", "0::/kubepods/pod1/ctr\n");
+        write_file(root / "sys/cpu.max", "50000 100000\n");
+        CHECK(quota(root) == 0.5);
+    }
+
+    // v1 with cpu and cpuacct mounted together, among other controllers
+    {
+        const auto root = fake_root("cg_v1");
+        write_file(root / "cgroup",
+                   "12:memory:/docker/abc\n"
+                   "4:cpu,cpuacct:/docker/abc\n"
+                   "1:name=systemd:/docker/abc\n");
+        write_file(root / "sys/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "400000\n");
+        write_file(root / "sys/cpu,cpuacct/docker/abc/cpu.cfs_period_us", "100000\n");
+        CHECK(quota(root) == 4.0);
+        write_file(root / "sys/cpu,cpuacct/docker/abc/cpu.cfs_quota_us", "-1\n");
+        CHECK(quota(root) == 0.0);
+    }
+
+    // v1 with a separate cpu mount
+    {
+        const auto root = fake_root("cg_v1_cpu");
+        write_file(root / "cgroup", "3:cpu:/job\n");
+        write_file(root / "sys/cpu/job/cpu.cfs_quota_us", "150000\n");
+        write_file(root / "sys/cpu/job/cpu.cfs_period_us", "100000\n");
+        CHECK(quota(root) == 1.5);
+    }
+
+    // No cgroup files at all: unlimited
+    {
+        const auto root = fake_root("cg_none");
+        CHECK(quota(root) == 0.0);
+    }
+
+    // The real system only has to parse, whatever it says
+    CHECK(available_cpus() >= 1);
+    return test_result();
+}
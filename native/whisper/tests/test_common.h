@@ -0,0 +1,40 @@
+#ifndef WHISPER_FFI_TEST_COMMON_H
+#define WHISPER_FFI_TEST_COMMON_H
+
+// Minimal checks for the wrapper's CTest targets (build_whisper.sh --test).
+// Each test binary runs its cases in main and returns test_result().
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+// Exit code CTest reports as skipped (SKIP_RETURN_CODE in whisper_ffi.cmake)
+constexpr int TEST_SKIPPED = 77;
+
+inline int g_test_failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++g_test_failures;                                                    \
+        }                                                                         \
+    } while (0)
+
+// Fresh path in the temp directory, removed before it is returned
+inline std::string temp_path(const std::string& name) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("whisper_ffi_test_" + name);
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+inline int test_result() {
+    if (g_test_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", g_test_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
+
+#endif // WHISPER_FFI_TEST_COMMON_H
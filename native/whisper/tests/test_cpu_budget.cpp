@@ -0,0 +1,106 @@
+// Thread budget leases: a lone caller gets what it asks for, a caller that
+// arrives while others hold leases gets a fair share, and waiters are served
+// in arrival order with high priority ahead of normal.
+
+#include "cpu_budget.h"
+#include "test_common.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Long enough for a started thread to be queued on the budget
+static const auto QUEUE_SETTLE = std::chrono::milliseconds(100);
+
+// Leases `wanted` on a thread, records the order it got through and holds
+// the lease until `release` is set
+struct waiter {
+    std::thread thread;
+    std::atomic<int> granted{0};
+
+    void start(int wanted, lease_priority priority, std::mutex& order_mutex, std::vector<int>& order, int id,
+               const std::atomic<bool>& release) {
+        thread = std::thread([this, wanted, priority, &order_mutex, &order, id, &release] {
+            thread_lease lease = lease_threads(wanted, priority);
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(id);
+            }
+            granted = lease.threads();
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        std::this_thread::sleep_for(QUEUE_SETTLE);
+    }
+};
+
+int main() {
+    set_thread_budget(8);
+    CHECK(thread_budget() == 8);
+
+    // Alone: the whole request, capped by the budget
+    {
+        thread_lease lease = lease_threads(6);
+        CHECK(lease.threads() == 6);
+    }
+    {
+        thread_lease lease = lease_threads(32);
+        CHECK(lease.threads() == 8);
+    }
+
+    // One holder: the next caller gets half of the budget
+    {
+        thread_lease first = lease_threads(2);
+        CHECK(first.threads() == 2);
+        thread_lease second = lease_threads(8);
+        CHECK(second.threads() == 4);
+        thread_lease third = lease_threads(8);
+        CHECK(third.threads() == 2); // What is left
+    }
+
+    // Full budget: waiters queue in arrival order, high priority first. The
+    // budget is freed one thread at a time so each grant is seen on its own.
+    {
+        std::mutex order_mutex;
+        std::vector<int> order;
+        std::atomic<bool> release{false};
+        std::vector<thread_lease> held;
+        for (int i = 0; i < 8; ++i) {
+            held.push_back(lease_threads(1));
+        }
+
+        waiter normal_1;
+        waiter normal_2;
+        waiter high;
+        normal_1.start(1, lease_priority::normal, order_mutex, order, 1, release);
+        normal_2.start(1, lease_priority::normal, order_mutex, order, 2, release);
+        high.start(1, lease_priority::high, order_mutex, order, 3, release);
+
+        const std::vector<int> expected = {3, 1, 2};
+        for (size_t granted = 0; granted <= expected.size(); ++granted) {
+            {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                // Nobody runs while the budget is used up
+                CHECK((order == std::vector<int>(expected.begin(), expected.begin() + granted)));
+            }
+            held.pop_back();
+            std::this_thread::sleep_for(QUEUE_SETTLE);
+        }
+        CHECK(normal_1.granted == 1 && normal_2.granted == 1 && high.granted == 1);
+
+        release = true;
+        normal_1.thread.join();
+        normal_2.thread.join();
+        high.thread.join();
+    }
+
+    // A smaller budget applies to new leases
+    set_thread_budget(2);
+    {
+        thread_lease lease = lease_threads(8);
+        CHECK(lease.threads() == 2);
+    }
+    return test_result();
+}
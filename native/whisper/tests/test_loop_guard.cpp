@@ -0,0 +1,80 @@
+// Repetition loop guard: end-of-text is forced only for a phrase repeated at
+// least three times back to back over at least 16 tokens.
+
+#include "loop_guard.h"
+#include "test_common.h"
+#include <cmath>
+#include <vector>
+
+static const whisper_token EOT = 50256;
+static const int N_VOCAB = 51864;
+
+// Prefix tokens followed by `phrase` repeated `repeats` times
+static std::vector<whisper_token> tokens(std::vector<whisper_token> prefix, const std::vector<whisper_token>& phrase,
+                                         int repeats) {
+    for (int i = 0; i < repeats; ++i) {
+        prefix.insert(prefix.end(), phrase.begin(), phrase.end());
+    }
+    return prefix;
+}
+
+static bool only_eot_allowed(const std::vector<float>& logits) {
+    for (int i = 0; i < N_VOCAB; ++i) {
+        if (i == EOT ? logits[i] != 0.0f : !std::isinf(logits[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool untouched(const std::vector<float>& logits) {
+    for (float logit : logits) {
+        if (logit != 1.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the guard over fresh logits (all 1.0) and returns the loop length
+static int run(const std::vector<whisper_token>& text, std::vector<float>& logits) {
+    logits.assign(N_VOCAB, 1.0f);
+    return end_text_on_loop(text, EOT, logits.data(), N_VOCAB);
+}
+
+int main() {
+    std::vector<float> logits;
+    const std::vector<whisper_token> phrase = {11, 12, 13, 14, 15, 16}; // 6 tokens
+
+    // Repeated x3 (18 tokens) after ordinary speech: end-of-text forced
+    CHECK(run(tokens({1, 2, 3, 4}, phrase, 3), logits) == 18);
+    CHECK(only_eot_allowed(logits));
+
+    // Repeated x2, even over 16 tokens: a phrase said twice is left alone
+    CHECK(run(tokens({1, 2, 3, 4}, {21, 22, 23, 24, 25, 26, 27, 28}, 2), logits) == 0);
+    CHECK(untouched(logits));
+    CHECK(run(tokens({1, 2, 3, 4}, phrase, 2), logits) == 0);
+    CHECK(untouched(logits));
+
+    // Fewer than 16 tokens: "no, no, no, no, no" is speech
+    CHECK(run(tokens({}, {7, 8, 9}, 5), logits) == 0); // 15 tokens
+    CHECK(untouched(logits));
+    CHECK(run(tokens({}, {42}, 15), logits) == 0);
+    CHECK(untouched(logits));
+
+    // One more repetition crosses 16 tokens
+    CHECK(run(tokens({}, {7, 8, 9}, 6), logits) == 18);
+    CHECK(only_eot_allowed(logits));
+    CHECK(run(tokens({}, {42}, 16), logits) == 16);
+    CHECK(only_eot_allowed(logits));
+
+    // The loop must be at the end: a repeat followed by new text is over
+    CHECK(run(tokens(tokens({}, phrase, 3), {99, 100, 101}, 1), logits) == 0);
+    CHECK(untouched(logits));
+
+    // No text yet
+    CHECK(run({}, logits) == 0);
+    CHECK(untouched(logits));
+
+    return test_result();
+}
@@ -0,0 +1,44 @@
+// Ogg Opus round trip: the decoder drops the encoder's pre-skip and trims
+// the last page to its granule position, so any length comes back exactly,
+// and a range decode returns exactly the requested samples.
+
+#include "opus_codec.h"
+#include "test_common.h"
+#include <cmath>
+#include <vector>
+
+#ifdef WHISPER_FFI_WITH_OPUS
+// Speech-band tone, long enough to span many pages
+static std::vector<float> tone(size_t n_samples) {
+    std::vector<float> pcm(n_samples);
+    for (size_t i = 0; i < n_samples; ++i) {
+        pcm[i] = 0.3f * std::sin(2.0f * 3.14159265f * 220.0f * (float) i / 16000.0f);
+    }
+    return pcm;
+}
+#endif
+
+int main() {
+#ifndef WHISPER_FFI_WITH_OPUS
+    printf("built without Opus, skipping\n");
+    return TEST_SKIPPED;
+#else
+    // Whole frames, a partial last frame, and less than one frame
+    for (size_t n_samples : {size_t(16000 * 3), size_t(16000 * 3 + 123), size_t(100)}) {
+        const std::string path = temp_path("round_trip.opus");
+        CHECK(encode_ogg_opus(tone(n_samples), path, OPUS_SPEECH_BITRATE));
+        CHECK(decode_ogg_opus(path).size() == n_samples);
+    }
+
+    // Ranges starting mid-file need the seek table and decoder pre-roll
+    const std::string path = temp_path("range.opus");
+    const size_t n_samples = 16000 * 20 + 77;
+    CHECK(encode_ogg_opus(tone(n_samples), path, 0));
+    CHECK(decode_ogg_opus_range(path, 0, 16000).size() == 16000);
+    CHECK(decode_ogg_opus_range(path, 16000 * 7 + 5, 16000 * 9).size() == 16000 * 2 - 5);
+    CHECK(decode_ogg_opus_range(path, 16000 * 19, n_samples + 16000).size() == 16000 + 77);
+    CHECK(decode_ogg_opus_range(path, n_samples + 1, n_samples + 100).empty());
+
+    return test_result();
+#endif
+}
@@ -0,0 +1,100 @@
+// Transcript writers: SRT and WebVTT cue numbering, times, text cleanup and
+// speaker labels, JSON Lines output, and output held back until a flush.
+
+#include "segment_writer.h"
+#include "test_common.h"
+#include <string>
+
+static ffi_segment make_segment(int64_t t0_ms, int64_t t1_ms, const std::string& text, int speaker = -1) {
+    ffi_segment segment;
+    segment.t0_ms = t0_ms;
+    segment.t1_ms = t1_ms;
+    segment.text = text;
+    segment.speaker = speaker;
+    return segment;
+}
+
+// Writer that appends to `out`; no time-based flush during a test
+static segment_writer string_writer(std::string& out, segment_writer_format format) {
+    return segment_writer(
+        [&out](const char* data, size_t size) {
+            out.append(data, size);
+            return true;
+        },
+        format, 3600 * 1000);
+}
+
+static void add_sample(segment_writer& writer) {
+    CHECK(writer.add(make_segment(-20, 1500, " Hello\nworld ")));
+    CHECK(writer.add(make_segment(1500, 2000, "  ")));
+    CHECK(writer.add(make_segment(3723004, 3725000, " Fish & <chips>", 1)));
+}
+
+int main() {
+    // SRT: numbered cues, comma times, empty cues skipped without a gap
+    {
+        std::string out;
+        segment_writer writer = string_writer(out, SEGMENT_WRITER_SRT);
+        add_sample(writer);
+        CHECK(out.empty()); // Held back until a flush
+        CHECK(writer.flush());
+        CHECK(out ==
+              "1\n00:00:00,000 --> 00:00:01,500\nHello world\n\n"
+              "2\n01:02:03,004 --> 01:02:05,000\nSpeaker 2: Fish & <chips>\n\n");
+    }
+
+    // WebVTT: header, dot times, no numbers, escaped text, <v> speakers
+    {
+        std::string out;
+        segment_writer writer = string_writer(out, SEGMENT_WRITER_VTT);
+        add_sample(writer);
+        CHECK(writer.flush());
+        CHECK(out ==
+              "WEBVTT\n\n"
+              "00:00:00.000 --> 00:00:01.500\nHello world\n\n"
+              "01:02:03.004 --> 01:02:05.000\n<v Speaker 2>Fish &amp; &lt;chips&gt;\n\n");
+    }
+
+    // JSON Lines: every segment, one object per line
+    {
+        std::string out;
+        segment_writer writer = string_writer(out, SEGMENT_WRITER_JSONL);
+        add_sample(writer);
+        CHECK(writer.flush());
+        CHECK(out ==
+              "{\"t0\":-20,\"t1\":1500,\"text\":\" Hello\\nworld \"}\n"
+              "{\"t0\":1500,\"t1\":2000,\"text\":\"  \"}\n"
+              "{\"t0\":3723004,\"t1\":3725000,\"text\":\" Fish & <chips>\",\"speaker\":1}\n");
+    }
+
+    // A full pending buffer is written without waiting for a flush
+    {
+        std::string out;
+        segment_writer writer = string_writer(out, SEGMENT_WRITER_SRT);
+        const std::string text(1000, 'x');
+        for (int i = 0; i < 100; ++i) {
+            CHECK(writer.add(make_segment(i * 1000LL, i * 1000LL + 900, text)));
+        }
+        CHECK(!out.empty());
+        CHECK(out.compare(0, 2, "1\n") == 0);
+        CHECK(writer.flush());
+        CHECK(out.find("\n100\n") != std::string::npos);
+    }
+
+    // A failed write fails the writer for good
+    {
+        int writes = 0;
+        segment_writer writer(
+            [&writes](const char*, size_t) {
+                ++writes;
+                return false;
+            },
+            SEGMENT_WRITER_SRT, 3600 * 1000);
+        CHECK(writer.add(make_segment(0, 1000, " one")));
+        CHECK(!writer.flush());
+        CHECK(!writer.add(make_segment(1000, 2000, " two")));
+        CHECK(!writer.flush());
+        CHECK(writes == 1);
+    }
+    return test_result();
+}
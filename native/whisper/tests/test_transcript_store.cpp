@@ -0,0 +1,67 @@
+// Transcript store round trip: memos written through the C API read back
+// unchanged, with or without zstd blocks; a duplicate id or a memo begun
+// while another is open is rejected without touching the stored ones.
+
+#include "whisper_wrapper.h"
+#include "test_common.h"
+#include <string>
+
+static std::string get(whisper_ffi_store_reader* reader, const char* memo_id) {
+    char* json = whisper_ffi_store_get(reader, memo_id);
+    if (!json) {
+        return "<missing>";
+    }
+    std::string result(json);
+    whisper_ffi_free_string(json);
+    return result;
+}
+
+int main() {
+    const std::string path = temp_path("store.bin");
+
+    whisper_ffi_store_writer* writer = whisper_ffi_store_create(path.c_str());
+    CHECK(writer != nullptr);
+    if (!writer) {
+        return test_result();
+    }
+    CHECK(whisper_ffi_store_begin_memo(writer, "memo-1"));
+    CHECK(!whisper_ffi_store_begin_memo(writer, "memo-open"));
+    CHECK(whisper_ffi_store_add_segment(writer, 0, 2500, " Hello \"world\""));
+    CHECK(whisper_ffi_store_add_segment(writer, 2500, 4000, " Grüße, 日本"));
+    CHECK(whisper_ffi_store_add_segment(writer, 4000, 3600000123LL, ""));
+    CHECK(whisper_ffi_store_end_memo(writer));
+    CHECK(!whisper_ffi_store_begin_memo(writer, "memo-1"));
+    CHECK(!whisper_ffi_store_end_memo(writer));
+    CHECK(whisper_ffi_store_begin_memo(writer, "memo-2"));
+    CHECK(whisper_ffi_store_end_memo(writer));
+    CHECK(whisper_ffi_store_begin_memo(writer, "memo-3"));
+    // Enough segments to span several blocks
+    for (int i = 0; i < 5000; ++i) {
+        CHECK(whisper_ffi_store_add_segment(writer, i * 1000LL, i * 1000LL + 900, (" segment " + std::to_string(i)).c_str()));
+    }
+    CHECK(whisper_ffi_store_end_memo(writer));
+    CHECK(whisper_ffi_store_finish(writer));
+
+    whisper_ffi_store_reader* reader = whisper_ffi_store_open(path.c_str());
+    CHECK(reader != nullptr);
+    if (!reader) {
+        return test_result();
+    }
+    CHECK(whisper_ffi_store_memo_count(reader) == 3);
+    CHECK(get(reader, "memo-1") ==
+          "[{\"t0\":0,\"t1\":2500,\"text\":\" Hello \\\"world\\\"\"},"
+          "{\"t0\":2500,\"t1\":4000,\"text\":\" Grüße, 日本\"},"
+          "{\"t0\":4000,\"t1\":3600000123,\"text\":\"\"}]");
+    CHECK(get(reader, "memo-2") == "[]");
+
+    const std::string big = get(reader, "memo-3");
+    CHECK(big.find("{\"t0\":0,\"t1\":900,\"text\":\" segment 0\"}") == 1);
+    CHECK(big.find("{\"t0\":4999000,\"t1\":4999900,\"text\":\" segment 4999\"}]") != std::string::npos);
+
+    CHECK(get(reader, "memo-4") == "<missing>");
+    CHECK(get(reader, "memo-open") == "<missing>");
+    whisper_ffi_store_close(reader);
+
+    CHECK(whisper_ffi_store_open(temp_path("missing.bin").c_str()) == nullptr);
+    return test_result();
+}
@@ -0,0 +1,135 @@
+// Vector index: exact search agrees with brute-force cosine similarity, a
+// trained index still finds every stored vector through its own list, adds
+// after training land in a list, and save/load round trips the index.
+
+#include "whisper_wrapper.h"
+#include "test_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Odd, so the SIMD kernels' tail handling is exercised too
+static const int DIM = 19;
+static const int N_VECTORS = 300;
+static const int K = 5;
+
+static std::vector<float> random_vector(uint32_t& seed) {
+    std::vector<float> v(DIM);
+    for (float& x : v) {
+        seed = seed * 1664525u + 1013904223u;
+        x = (float) (seed >> 8) / (float) (1u << 24) - 0.5f;
+    }
+    return v;
+}
+
+static float cosine(const std::vector<float>& a, const std::vector<float>& b) {
+    double dot = 0.0;
+    double na = 0.0;
+    double nb = 0.0;
+    for (int i = 0; i < DIM; ++i) {
+        dot += a[i] * b[i];
+        na += a[i] * a[i];
+        nb += b[i] * b[i];
+    }
+    return (float) (dot / std::sqrt(na * nb));
+}
+
+// Ids of the k most similar vectors, best first
+static std::vector<int64_t> brute_force(const std::vector<std::vector<float>>& vectors, const std::vector<float>& query) {
+    std::vector<int64_t> ids(vectors.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        ids[i] = (int64_t) i;
+    }
+    std::partial_sort(ids.begin(), ids.begin() + K, ids.end(), [&](int64_t a, int64_t b) {
+        return cosine(vectors[a], query) > cosine(vectors[b], query);
+    });
+    ids.resize(K);
+    return ids;
+}
+
+static std::vector<int64_t> search(whisper_ffi_vector_index* index, const std::vector<float>& query, int n_probe,
+                                   std::vector<float>* scores = nullptr) {
+    std::vector<int64_t> ids(K);
+    std::vector<float> found_scores(K);
+    const int n = whisper_ffi_index_search(index, query.data(), K, n_probe, ids.data(), found_scores.data());
+    ids.resize(std::max(0, n));
+    found_scores.resize(ids.size());
+    if (scores) {
+        *scores = found_scores;
+    }
+    return ids;
+}
+
+int main() {
+    uint32_t seed = 12345;
+    std::vector<std::vector<float>> vectors;
+    for (int i = 0; i < N_VECTORS; ++i) {
+        vectors.push_back(random_vector(seed));
+    }
+
+    whisper_ffi_vector_index* index = whisper_ffi_index_create(DIM);
+    CHECK(index != nullptr);
+    if (!index) {
+        return test_result();
+    }
+    const std::vector<float> zero(DIM, 0.0f);
+    CHECK(!whisper_ffi_index_add(index, -1, zero.data()));
+    for (int i = 0; i < N_VECTORS; ++i) {
+        CHECK(whisper_ffi_index_add(index, i, vectors[i].data()));
+    }
+    CHECK(whisper_ffi_index_size(index) == N_VECTORS);
+
+    // Exact search before training: same ranking as brute force, scores
+    // descending and independent of the query's length
+    for (int q = 0; q < 10; ++q) {
+        const std::vector<float> query = random_vector(seed);
+        std::vector<float> scores;
+        CHECK(search(index, query, 0, &scores) == brute_force(vectors, query));
+        CHECK(std::is_sorted(scores.rbegin(), scores.rend()));
+        CHECK(std::fabs(scores[0] - cosine(vectors[brute_force(vectors, query)[0]], query)) < 1e-4f);
+
+        std::vector<float> scaled = query;
+        for (float& x : scaled) {
+            x *= 3.0f;
+        }
+        CHECK(search(index, scaled, 0) == search(index, query, 0));
+    }
+
+    // Trained: each stored vector is found first through its own list
+    CHECK(whisper_ffi_index_train(index, 0));
+    int self_hits = 0;
+    for (int i = 0; i < N_VECTORS; ++i) {
+        const std::vector<int64_t> ids = search(index, vectors[i], 1);
+        self_hits += !ids.empty() && ids[0] == i;
+    }
+    CHECK(self_hits == N_VECTORS);
+
+    // Adds after training are filed into a list and found
+    const std::vector<float> late = random_vector(seed);
+    CHECK(whisper_ffi_index_add(index, 1000, late.data()));
+    CHECK(whisper_ffi_index_size(index) == N_VECTORS + 1);
+    const std::vector<int64_t> late_ids = search(index, late, 1);
+    CHECK(!late_ids.empty() && late_ids[0] == 1000);
+
+    // Save/load keeps vectors, lists and results
+    const std::string path = temp_path("index.bin");
+    CHECK(whisper_ffi_index_save(index, path.c_str()));
+    whisper_ffi_vector_index* loaded = whisper_ffi_index_load(path.c_str());
+    CHECK(loaded != nullptr);
+    if (loaded) {
+        CHECK(whisper_ffi_index_size(loaded) == N_VECTORS + 1);
+        for (int q = 0; q < 10; ++q) {
+            const std::vector<float> query = random_vector(seed);
+            std::vector<float> before;
+            std::vector<float> after;
+            CHECK(search(index, query, 2, &before) == search(loaded, query, 2, &after));
+            CHECK(before == after);
+        }
+        whisper_ffi_index_free(loaded);
+    }
+    whisper_ffi_index_free(index);
+
+    CHECK(whisper_ffi_index_load(temp_path("missing_index.bin").c_str()) == nullptr);
+    return test_result();
+}
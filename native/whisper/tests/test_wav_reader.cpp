@@ -0,0 +1,169 @@
+// WAV parsing shared by whole-file reads, range reads and streams: chunks
+// skipped with their padding, the extensible fmt's sub-format, multichannel
+// downmix, sizes the writer never patched, and headers that are refused.
+
+#include "audio_range.h"
+#include "audio_stream.h"
+#include "whisper_ffi_internal.h"
+#include "test_common.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static const int N_FRAMES = 16000;
+
+static void put_le(std::string& out, uint32_t value, int n_bytes) {
+    for (int i = 0; i < n_bytes; ++i) {
+        out.push_back((char) ((value >> (8 * i)) & 0xFF));
+    }
+}
+
+static void put_chunk(std::string& out, const char* name, const std::string& body, uint32_t declared_size) {
+    out.append(name, 4);
+    put_le(out, declared_size, 4);
+    out += body;
+    if (body.size() & 1) {
+        out.push_back('\0');
+    }
+}
+
+static std::string fmt_body(uint16_t format, uint16_t channels, uint16_t bits, bool extensible) {
+    std::string fmt;
+    put_le(fmt, extensible ? 0xFFFE : format, 2);
+    put_le(fmt, channels, 2);
+    put_le(fmt, 16000, 4);
+    put_le(fmt, 16000u * channels * bits / 8, 4);
+    put_le(fmt, channels * bits / 8, 2);
+    put_le(fmt, bits, 2);
+    if (extensible) {
+        put_le(fmt, 22, 2);
+        put_le(fmt, bits, 2);
+        put_le(fmt, 0, 4);
+        put_le(fmt, format, 2); // Sub-format GUID, rest of it left zero
+        fmt.append(14, '\0');
+    }
+    return fmt;
+}
+
+// The mono signal every file below carries, exactly representable in 16 bits
+static float expected_sample(int i) {
+    return (float) (int16_t) std::lround(8000.0 * std::sin(i * 0.05)) / 32768.0f;
+}
+
+// 16-bit mono: a LIST chunk before fmt and an odd-sized JUNK chunk after it
+static std::string pcm16_mono(uint32_t riff_size, uint32_t data_size) {
+    std::string data;
+    for (int i = 0; i < N_FRAMES; ++i) {
+        put_le(data, (uint16_t) (int16_t) std::lround(expected_sample(i) * 32768.0f), 2);
+    }
+    std::string body = "WAVE";
+    put_chunk(body, "LIST", "INFOabc", 7);
+    put_chunk(body, "fmt ", fmt_body(1, 1, 16, false), 16);
+    put_chunk(body, "JUNK", "xyz", 3);
+    put_chunk(body, "data", data, data_size);
+    std::string wav = "RIFF";
+    put_le(wav, riff_size ? riff_size : (uint32_t) body.size(), 4);
+    return wav + body;
+}
+
+// 32-bit float stereo in an extensible fmt; the channels average to the signal
+static std::string float_stereo_extensible() {
+    std::string data;
+    for (int i = 0; i < N_FRAMES; ++i) {
+        for (const float value : {expected_sample(i) + 0.25f, expected_sample(i) - 0.25f}) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            put_le(data, bits, 4);
+        }
+    }
+    std::string body = "WAVE";
+    put_chunk(body, "fmt ", fmt_body(3, 2, 32, true), 40);
+    put_chunk(body, "data", data, (uint32_t) data.size());
+    std::string wav = "RIFF";
+    put_le(wav, (uint32_t) body.size(), 4);
+    return wav + body;
+}
+
+static std::string write_wav(const std::string& name, const std::string& bytes) {
+    const std::string path = temp_path(name + ".wav");
+    std::ofstream(path, std::ios::binary) << bytes;
+    return path;
+}
+
+static std::vector<float> decode_bytes(const std::string& bytes) {
+    size_t offset = 0;
+    return decode_audio_stream(
+        [&](void* buffer, size_t size) -> int64_t {
+            // Odd short reads, so frames straddle them
+            const size_t n = std::min({size, bytes.size() - offset, (size_t) 1001});
+            memcpy(buffer, bytes.data() + offset, n);
+            offset += n;
+            return (int64_t) n;
+        },
+        "memory");
+}
+
+static bool matches(const std::vector<float>& pcm, size_t first, size_t count) {
+    if (pcm.size() != count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (std::fabs(pcm[i] - expected_sample((int) (first + i))) > 1e-6f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The whole file, a stream of it and 10..20 ms of it all read the signal
+static void check_reads(const std::string& name, const std::string& bytes, size_t n_frames) {
+    const std::string path = write_wav(name, bytes);
+    CHECK(matches(read_audio_file(path), 0, n_frames));
+    CHECK(matches(decode_bytes(bytes), 0, n_frames));
+    CHECK(matches(read_audio_range(path, 10, 20), 160, 160));
+}
+
+int main() {
+    const uint32_t data_bytes = N_FRAMES * 2;
+
+    check_reads("pcm16", pcm16_mono(0, data_bytes), N_FRAMES);
+    check_reads("float_stereo", float_stereo_extensible(), N_FRAMES);
+    // A recorder that could not seek back: the data runs to the end
+    check_reads("unpatched", pcm16_mono(0xFFFFFFFFu, 0xFFFFFFFFu), N_FRAMES);
+    check_reads("unpatched_zero", pcm16_mono(0xFFFFFFFFu, 0), N_FRAMES);
+
+    // A declared size past the end of the file is cut to what is there
+    {
+        const std::string path = write_wav("overstated", pcm16_mono(0, data_bytes + 1000));
+        CHECK(matches(read_audio_file(path), 0, N_FRAMES));
+        CHECK(read_audio_range(path, 990, 2000).size() == 160);
+    }
+
+    // Refused: 24-bit samples, data before fmt, not a RIFF file at all
+    {
+        std::string wav = "RIFF";
+        put_le(wav, 0, 4);
+        wav += "WAVE";
+        put_chunk(wav, "fmt ", fmt_body(1, 1, 24, false), 16);
+        put_chunk(wav, "data", std::string(30, '\0'), 30);
+        const std::string path = write_wav("pcm24", wav);
+        CHECK(read_audio_file(path).empty());
+        CHECK(read_audio_range(path, 0, 1000).empty());
+        CHECK(decode_bytes(wav).empty());
+    }
+    {
+        std::string wav = "RIFF";
+        put_le(wav, 0, 4);
+        wav += "WAVE";
+        put_chunk(wav, "data", std::string(32, '\0'), 32);
+        put_chunk(wav, "fmt ", fmt_body(1, 1, 16, false), 16);
+        CHECK(read_audio_file(write_wav("data_first", wav)).empty());
+        CHECK(decode_bytes(wav).empty());
+    }
+    CHECK(read_audio_file(write_wav("not_riff", std::string(64, 'x'))).empty());
+    CHECK(read_audio_file(temp_path("missing.wav")).empty());
+    return test_result();
+}
@@ -0,0 +1,657 @@
+#include "transcript_store.h"
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef WHISPER_FFI_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char STORE_MAGIC[4] = {'V', 'B', 'T', 'S'};
+static const uint32_t STORE_VERSION = 1;
+static const size_t STORE_HEADER_SIZE = 16;
+static const size_t STORE_FOOTER_SIZE = 36;
+static const size_t STORE_DIR_ENTRY_SIZE = 16;
+static const size_t STORE_INDEX_ENTRY_SIZE = 16;
+
+// Raw bytes per block before compression. Large enough for zstd to find
+// cross-memo redundancy, small enough that one lookup stays cheap.
+static const size_t STORE_BLOCK_TARGET = 64 * 1024;
+
+#ifdef WHISPER_FFI_WITH_ZSTD
+static const int STORE_ZSTD_LEVEL = 9;
+#endif
+
+// Helper functions for the little-endian on-disk encoding
+
+static void put_u32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out += (char) ((v >> (8 * i)) & 0xff);
+    }
+}
+
+static void put_u64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out += (char) ((v >> (8 * i)) & 0xff);
+    }
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+        v |= (uint32_t) p[i] << (8 * i);
+    }
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) {
+        v |= (uint64_t) p[i] << (8 * i);
+    }
+    return v;
+}
+
+static void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += (char) ((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += (char) v;
+}
+
+static bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t byte = *p++;
+        v |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t zigzag_encode(int64_t v) {
+    return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t v) {
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+// FNV-1a: stable across platforms, so stores can be copied between hosts
+static uint64_t hash_memo_id(const std::string& memo_id) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : memo_id) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool write_bytes(FILE* file, const void* data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+transcript_store_writer::~transcript_store_writer() {
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool transcript_store_writer::open(const std::string& path) {
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "❌ Cannot create transcript store: " << path << std::endl;
+        return false;
+    }
+
+#ifdef WHISPER_FFI_WITH_ZSTD
+    codec = TRANSCRIPT_STORE_CODEC_ZSTD;
+#else
+    codec = TRANSCRIPT_STORE_CODEC_RAW;
+    std::cerr << "⚠️ Built without zstd, transcript store blocks are uncompressed" << std::endl;
+#endif
+
+    std::string header(STORE_MAGIC, 4);
+    put_u32(header, STORE_VERSION);
+    put_u32(header, codec);
+    put_u32(header, 0);
+    file_offset = header.size();
+    return write_bytes(file, header.data(), header.size());
+}
+
+bool transcript_store_writer::begin_memo(const std::string& id) {
+    if (in_memo) {
+        std::cerr << "❌ Memo " << memo_id << " is still open, cannot begin " << id << std::endl;
+        return false;
+    }
+    if (!memo_ids.insert(id).second) {
+        std::cerr << "❌ Memo " << id << " is already in the transcript store" << std::endl;
+        return false;
+    }
+    memo_id = id;
+    memo_segments.clear();
+    in_memo = true;
+    return true;
+}
+
+void transcript_store_writer::add_segment(const ffi_segment& segment) {
+    memo_segments.push_back(segment);
+}
+
+bool transcript_store_writer::end_memo() {
+    if (!file || !in_memo) {
+        return false;
+    }
+    in_memo = false;
+
+    std::string memo;
+    put_varint(memo, memo_id.size());
+    memo += memo_id;
+    put_varint(memo, memo_segments.size());
+
+    int64_t previous_end = 0;
+    for (const ffi_segment& segment : memo_segments) {
+        put_varint(memo, zigzag_encode(segment.t0_ms - previous_end));
+        previous_end = segment.t1_ms;
+    }
+    for (const ffi_segment& segment : memo_segments) {
+        put_varint(memo, (uint64_t) std::max<int64_t>(0, segment.t1_ms - segment.t0_ms));
+    }
+    for (const ffi_segment& segment : memo_segments) {
+        put_varint(memo, segment.text.size());
+    }
+    for (const ffi_segment& segment : memo_segments) {
+        memo += segment.text;
+    }
+
+    if (!block.empty() && block.size() + memo.size() > STORE_BLOCK_TARGET) {
+        if (!flush_block()) {
+            return false;
+        }
+    }
+
+    index.push_back({hash_memo_id(memo_id), (uint32_t) blocks.size(), (uint32_t) block.size()});
+    block += memo;
+    memo_segments.clear();
+
+    return block.size() < STORE_BLOCK_TARGET || flush_block();
+}
+
+bool transcript_store_writer::flush_block() {
+    if (block.empty()) {
+        return true;
+    }
+
+    const char* stored = block.data();
+    size_t stored_size = block.size();
+
+#ifdef WHISPER_FFI_WITH_ZSTD
+    std::vector<char> compressed(ZSTD_compressBound(block.size()));
+    const size_t result = ZSTD_compress(compressed.data(), compressed.size(), block.data(), block.size(), STORE_ZSTD_LEVEL);
+    if (ZSTD_isError(result)) {
+        std::cerr << "❌ zstd compression failed: " << ZSTD_getErrorName(result) << std::endl;
+        return false;
+    }
+    stored = compressed.data();
+    stored_size = result;
+#endif
+
+    if (!write_bytes(file, stored, stored_size)) {
+        std::cerr << "❌ Failed to write transcript store block" << std::endl;
+        return false;
+    }
+
+    blocks.push_back({file_offset, (uint32_t) stored_size, (uint32_t) block.size()});
+    file_offset += stored_size;
+    block.clear();
+    return true;
+}
+
+bool transcript_store_writer::finish() {
+    if (!file) {
+        return false;
+    }
+    if (in_memo && !end_memo()) {
+        return false;
+    }
+    if (!flush_block()) {
+        return false;
+    }
+
+    std::stable_sort(index.begin(), index.end(), [](const index_entry& a, const index_entry& b) {
+        return a.id_hash < b.id_hash;
+    });
+
+    std::string tail;
+    const uint64_t dir_offset = file_offset;
+    for (const block_entry& entry : blocks) {
+        put_u64(tail, entry.offset);
+        put_u32(tail, entry.stored_size);
+        put_u32(tail, entry.raw_size);
+    }
+    const uint64_t index_offset = dir_offset + tail.size();
+    for (const index_entry& entry : index) {
+        put_u64(tail, entry.id_hash);
+        put_u32(tail, entry.block);
+        put_u32(tail, entry.offset);
+    }
+    put_u64(tail, dir_offset);
+    put_u64(tail, blocks.size());
+    put_u64(tail, index_offset);
+    put_u64(tail, index.size());
+    tail.append(STORE_MAGIC, 4);
+
+    bool ok = write_bytes(file, tail.data(), tail.size());
+    ok = fclose(file) == 0 && ok;
+    file = nullptr;
+
+    std::cerr << (ok ? "✅" : "❌") << " Transcript store finished: " << index.size() << " memos in "
+              << blocks.size() << " blocks, " << (dir_offset + tail.size()) << " bytes" << std::endl;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+transcript_store_reader::~transcript_store_reader() {
+    if (!data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE) mapping_handle);
+    CloseHandle((HANDLE) file_handle);
+#else
+    munmap((void*) data, size);
+#endif
+}
+
+bool transcript_store_reader::open(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "❌ Cannot open transcript store: " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        std::cerr << "❌ Cannot map transcript store: " << path << std::endl;
+        return false;
+    }
+    data = (const uint8_t*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        std::cerr << "❌ Cannot map transcript store: " << path << std::endl;
+        return false;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+    size = (size_t) file_size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "❌ Cannot open transcript store: " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        std::cerr << "❌ Transcript store is empty: " << path << std::endl;
+        return false;
+    }
+    void* mapped = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "❌ Cannot map transcript store: " << path << std::endl;
+        return false;
+    }
+    // Lookups jump around the file; readahead would only pollute the page cache
+    madvise(mapped, (size_t) st.st_size, MADV_RANDOM);
+    data = (const uint8_t*) mapped;
+    size = (size_t) st.st_size;
+#endif
+
+    if (size < STORE_HEADER_SIZE + STORE_FOOTER_SIZE ||
+        memcmp(data, STORE_MAGIC, 4) != 0 ||
+        memcmp(data + size - 4, STORE_MAGIC, 4) != 0) {
+        std::cerr << "❌ Not a transcript store: " << path << std::endl;
+        return false;
+    }
+    if (get_u32(data + 4) != STORE_VERSION) {
+        std::cerr << "❌ Unsupported transcript store version: " << get_u32(data + 4) << std::endl;
+        return false;
+    }
+
+    codec = get_u32(data + 8);
+#ifndef WHISPER_FFI_WITH_ZSTD
+    if (codec == TRANSCRIPT_STORE_CODEC_ZSTD) {
+        std::cerr << "❌ Transcript store is zstd-compressed but this build has no zstd" << std::endl;
+        return false;
+    }
+#endif
+
+    const uint8_t* footer = data + size - STORE_FOOTER_SIZE;
+    const uint64_t dir_offset = get_u64(footer);
+    n_blocks = get_u64(footer + 8);
+    const uint64_t index_offset = get_u64(footer + 16);
+    n_memos = get_u64(footer + 24);
+
+    const uint64_t footer_offset = size - STORE_FOOTER_SIZE;
+    if (dir_offset + n_blocks * STORE_DIR_ENTRY_SIZE != index_offset ||
+        index_offset + n_memos * STORE_INDEX_ENTRY_SIZE != footer_offset) {
+        std::cerr << "❌ Corrupt transcript store footer: " << path << std::endl;
+        return false;
+    }
+
+    directory = data + dir_offset;
+    index = data + index_offset;
+
+    std::cerr << "📚 Opened transcript store: " << n_memos << " memos in " << n_blocks << " blocks" << std::endl;
+    return true;
+}
+
+bool transcript_store_reader::load_block(uint32_t block_id) {
+    if (cached_block == (int64_t) block_id) {
+        return true;
+    }
+    if (block_id >= n_blocks) {
+        return false;
+    }
+
+    const uint8_t* entry = directory + (size_t) block_id * STORE_DIR_ENTRY_SIZE;
+    const uint64_t offset = get_u64(entry);
+    const uint32_t stored_size = get_u32(entry + 8);
+    const uint32_t raw_size = get_u32(entry + 12);
+    if (offset + stored_size > size) {
+        return false;
+    }
+
+    if (codec == TRANSCRIPT_STORE_CODEC_RAW) {
+        block_data = data + offset;
+        block_size = stored_size;
+    } else {
+#ifdef WHISPER_FFI_WITH_ZSTD
+        block.resize(raw_size);
+        const size_t result = ZSTD_decompress(block.data(), block.size(), data + offset, stored_size);
+        if (ZSTD_isError(result) || result != raw_size) {
+            std::cerr << "❌ Corrupt transcript store block " << block_id << std::endl;
+            cached_block = -1;
+            return false;
+        }
+        block_data = block.data();
+        block_size = block.size();
+#else
+        (void) raw_size;
+        return false;
+#endif
+    }
+
+    cached_block = block_id;
+    return true;
+}
+
+bool transcript_store_reader::get(const std::string& memo_id, std::vector<ffi_segment>& segments) {
+    const uint64_t hash = hash_memo_id(memo_id);
+
+    // Lower bound over the fixed-size index records, read in place from the mapping
+    uint64_t lo = 0;
+    uint64_t hi = n_memos;
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        if (get_u64(index + mid * STORE_INDEX_ENTRY_SIZE) < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(block_mutex);
+
+    // Several ids may share a hash; the id stored with the memo disambiguates
+    for (uint64_t i = lo; i < n_memos; ++i) {
+        const uint8_t* entry = index + i * STORE_INDEX_ENTRY_SIZE;
+        if (get_u64(entry) != hash) {
+            break;
+        }
+        if (!load_block(get_u32(entry + 8))) {
+            return false;
+        }
+
+        const uint32_t offset = get_u32(entry + 12);
+        if (offset >= block_size) {
+            return false;
+        }
+        const uint8_t* p = block_data + offset;
+        const uint8_t* end = block_data + block_size;
+
+        uint64_t id_len = 0;
+        if (!get_varint(p, end, id_len) || id_len > (uint64_t) (end - p)) {
+            return false;
+        }
+        if (std::string((const char*) p, id_len) != memo_id) {
+            continue;
+        }
+        p += id_len;
+
+        uint64_t n_segments = 0;
+        if (!get_varint(p, end, n_segments) || n_segments > (uint64_t) (end - p)) {
+            return false;
+        }
+
+        segments.resize(n_segments);
+        int64_t previous_end = 0;
+        std::vector<uint64_t> column(n_segments);
+        for (uint64_t s = 0; s < n_segments; ++s) {
+            if (!get_varint(p, end, column[s])) {
+                return false;
+            }
+        }
+        for (uint64_t s = 0; s < n_segments; ++s) {
+            uint64_t duration = 0;
+            if (!get_varint(p, end, duration)) {
+                return false;
+            }
+            segments[s].t0_ms = previous_end + zigzag_decode(column[s]);
+            segments[s].t1_ms = segments[s].t0_ms + (int64_t) duration;
+            previous_end = segments[s].t1_ms;
+        }
+        for (uint64_t s = 0; s < n_segments; ++s) {
+            if (!get_varint(p, end, column[s])) {
+                return false;
+            }
+        }
+        for (uint64_t s = 0; s < n_segments; ++s) {
+            if (column[s] > (uint64_t) (end - p)) {
+                return false;
+            }
+            segments[s].text.assign((const char*) p, column[s]);
+            p += column[s];
+        }
+        return true;
+    }
+
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+// ---------------------------------------------------------------------------
+
+struct whisper_ffi_store_writer {
+    transcript_store_writer impl;
+};
+
+struct whisper_ffi_store_reader {
+    transcript_store_reader impl;
+};
+
+extern "C" {
+
+whisper_ffi_store_writer* whisper_ffi_store_create(const char* path) {
+    if (!path) {
+        return nullptr;
+    }
+    whisper_ffi_store_writer* writer = nullptr;
+    try {
+        writer = new whisper_ffi_store_writer();
+        if (!writer->impl.open(path)) {
+            delete writer;
+            return nullptr;
+        }
+        return writer;
+    } catch (...) {
+        std::cerr << "💥 Exception creating transcript store: " << path << std::endl;
+        delete writer;
+        return nullptr;
+    }
+}
+
+bool whisper_ffi_store_begin_memo(whisper_ffi_store_writer* writer, const char* memo_id) {
+    if (!writer || !memo_id) {
+        return false;
+    }
+    try {
+        return writer->impl.begin_memo(memo_id);
+    } catch (...) {
+        std::cerr << "💥 Exception beginning memo: " << memo_id << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_store_add_segment(whisper_ffi_store_writer* writer, int64_t t0_ms, int64_t t1_ms, const char* text) {
+    if (!writer) {
+        return false;
+    }
+    try {
+        ffi_segment segment;
+        segment.t0_ms = t0_ms;
+        segment.t1_ms = t1_ms;
+        segment.text = text ? text : "";
+        writer->impl.add_segment(segment);
+        return true;
+    } catch (...) {
+        std::cerr << "💥 Exception adding segment to transcript store" << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_store_end_memo(whisper_ffi_store_writer* writer) {
+    if (!writer) {
+        return false;
+    }
+    try {
+        return writer->impl.end_memo();
+    } catch (...) {
+        std::cerr << "💥 Exception ending memo in transcript store" << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_store_add_transcription(whisper_ffi_store_writer* writer, const char* memo_id,
+                                         whisper_context* ctx, const char* audio_path,
+                                         const struct whisper_ffi_transcribe_params* params) {
+    if (!writer || !memo_id || !ctx || !audio_path) {
+        return false;
+    }
+
+    try {
+        std::vector<ffi_segment> segments;
+        if (!transcribe_segments(ctx, audio_path, params ? *params : whisper_ffi_transcribe_default_params(), segments)) {
+            return false;
+        }
+        if (!writer->impl.begin_memo(memo_id)) {
+            return false;
+        }
+        for (const ffi_segment& segment : segments) {
+            writer->impl.add_segment(segment);
+        }
+        return writer->impl.end_memo();
+    } catch (...) {
+        std::cerr << "💥 Exception while storing transcription for: " << memo_id << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_store_finish(whisper_ffi_store_writer* writer) {
+    if (!writer) {
+        return false;
+    }
+    bool ok = false;
+    try {
+        ok = writer->impl.finish();
+    } catch (...) {
+        std::cerr << "💥 Exception finishing transcript store" << std::endl;
+    }
+    delete writer;
+    return ok;
+}
+
+whisper_ffi_store_reader* whisper_ffi_store_open(const char* path) {
+    if (!path) {
+        return nullptr;
+    }
+    whisper_ffi_store_reader* reader = nullptr;
+    try {
+        reader = new whisper_ffi_store_reader();
+        if (!reader->impl.open(path)) {
+            delete reader;
+            return nullptr;
+        }
+        return reader;
+    } catch (...) {
+        std::cerr << "💥 Exception opening transcript store: " << path << std::endl;
+        delete reader;
+        return nullptr;
+    }
+}
+
+char* whisper_ffi_store_get(whisper_ffi_store_reader* reader, const char* memo_id) {
+    if (!reader || !memo_id) {
+        return nullptr;
+    }
+
+    try {
+        std::vector<ffi_segment> segments;
+        if (!reader->impl.get(memo_id, segments)) {
+            return nullptr;
+        }
+        const std::string json = segments_to_json(segments);
+        return copy_to_c_string(json);
+    } catch (...) {
+        std::cerr << "💥 Exception reading memo: " << memo_id << std::endl;
+        return nullptr;
+    }
+}
+
+int64_t whisper_ffi_store_memo_count(whisper_ffi_store_reader* reader) {
+    return reader ? (int64_t) reader->impl.memo_count() : 0;
+}
+
+void whisper_ffi_store_close(whisper_ffi_store_reader* reader) {
+    delete reader;
+}
+
+}
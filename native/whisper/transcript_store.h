@@ -0,0 +1,111 @@
+#ifndef TRANSCRIPT_STORE_H
+#define TRANSCRIPT_STORE_H
+
+// Compressed columnar transcript store.
+//
+// File layout (all integers little-endian):
+//
+//   header     "VBTS" | u32 version | u32 codec | u32 reserved
+//   blocks     codec-compressed, each holding whole memos
+//   directory  n_blocks x { u64 offset | u32 stored_size | u32 raw_size }
+//   index      n_memos  x { u64 id_hash | u32 block | u32 offset_in_block }, sorted by hash
+//   footer     u64 dir_offset | u64 n_blocks | u64 index_offset | u64 n_memos | "VBTS"
+//
+// Inside a decompressed block every memo is stored column by column:
+//
+//   varint id_len | id bytes | varint n_segments
+//   n_segments x zigzag varint  start delta against the previous segment's end
+//   n_segments x varint         duration
+//   n_segments x varint         text length
+//   concatenated segment text
+//
+// A memo never spans blocks, so reading one transcript touches the index
+// (binary search over the mapped file) and decompresses a single block.
+
+#include "whisper_ffi_internal.h"
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+enum transcript_store_codec : uint32_t {
+    TRANSCRIPT_STORE_CODEC_RAW  = 0,
+    TRANSCRIPT_STORE_CODEC_ZSTD = 1,
+};
+
+struct transcript_store_writer {
+    ~transcript_store_writer();
+
+    bool open(const std::string& path);
+    // False while another memo is open or when memo_id was already written
+    bool begin_memo(const std::string& memo_id);
+    void add_segment(const ffi_segment& segment);
+    bool end_memo();
+    bool finish();
+
+    size_t memo_count() const { return index.size(); }
+
+private:
+    struct index_entry {
+        uint64_t id_hash;
+        uint32_t block;
+        uint32_t offset;
+    };
+    struct block_entry {
+        uint64_t offset;
+        uint32_t stored_size;
+        uint32_t raw_size;
+    };
+
+    bool flush_block();
+
+    FILE* file = nullptr;
+    uint32_t codec = TRANSCRIPT_STORE_CODEC_RAW;
+    uint64_t file_offset = 0;
+
+    std::string memo_id;
+    std::vector<ffi_segment> memo_segments;
+    bool in_memo = false;
+
+    std::string block;
+    std::vector<block_entry> blocks;
+    std::vector<index_entry> index;
+    std::unordered_set<std::string> memo_ids; // Ids begun so far; the index only keeps hashes
+};
+
+struct transcript_store_reader {
+    ~transcript_store_reader();
+
+    bool open(const std::string& path);
+    bool get(const std::string& memo_id, std::vector<ffi_segment>& segments);
+
+    uint64_t memo_count() const { return n_memos; }
+
+private:
+    bool load_block(uint32_t block_id);
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+
+    uint32_t codec = TRANSCRIPT_STORE_CODEC_RAW;
+    const uint8_t* directory = nullptr;
+    uint64_t n_blocks = 0;
+    const uint8_t* index = nullptr;
+    uint64_t n_memos = 0;
+
+    // Last loaded block; lookups for neighbouring memos reuse it.
+    // Raw blocks point straight into the mapping, compressed ones into `block`.
+    std::mutex block_mutex;
+    int64_t cached_block = -1;
+    std::vector<uint8_t> block;
+    const uint8_t* block_data = nullptr;
+    size_t block_size = 0;
+};
+
+#endif // TRANSCRIPT_STORE_H
@@ -0,0 +1,428 @@
+#include "vector_index.h"
+#include "cpu_budget.h"
+#include "whisper_wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VECTOR_INDEX_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const char VECTOR_INDEX_MAGIC[4] = {'V', 'B', 'V', 'I'};
+static const uint32_t VECTOR_INDEX_VERSION = 1;
+static const int KMEANS_ITERATIONS = 10;
+static const size_t KMEANS_SAMPLES_PER_LIST = 64;
+
+static float dot_scalar(const float* a, const float* b, size_t n) {
+    // Independent sums so the additions pipeline
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+#if defined(VECTOR_INDEX_X86_DISPATCH)
+
+__attribute__((target("avx2,fma"))) static float dot_avx2(const float* a, const float* b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_hadd_ps(sum, sum);
+    sum = _mm_hadd_ps(sum, sum);
+    float result = _mm_cvtss_f32(sum);
+    for (; i < n; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+using dot_kernel = float (*)(const float*, const float*, size_t);
+
+static dot_kernel select_dot_kernel() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return dot_avx2;
+    }
+    return dot_scalar;
+}
+
+float dot_product(const float* a, const float* b, size_t n) {
+    static const dot_kernel kernel = select_dot_kernel();
+    return kernel(a, b, n);
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+float dot_product(const float* a, const float* b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float result = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < n; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+#else
+
+float dot_product(const float* a, const float* b, size_t n) {
+    return dot_scalar(a, b, n);
+}
+
+#endif
+
+// Scale to unit length; false for a zero (or non-finite) vector
+static bool normalize(float* vector, int dim) {
+    const float norm = sqrtf(dot_product(vector, vector, (size_t) dim));
+    if (!(norm > 0.0f) || !std::isfinite(norm)) {
+        return false;
+    }
+    for (int k = 0; k < dim; ++k) {
+        vector[k] /= norm;
+    }
+    return true;
+}
+
+whisper_ffi_vector_index::whisper_ffi_vector_index(int dim) : dim(dim) {}
+
+uint32_t whisper_ffi_vector_index::nearest_list(const float* vector) const {
+    uint32_t best = 0;
+    float best_score = -INFINITY;
+    for (uint32_t l = 0; l < lists.size(); ++l) {
+        const float score = dot_product(vector, centroids.data() + (size_t) l * dim, dim);
+        if (score > best_score) {
+            best_score = score;
+            best = l;
+        }
+    }
+    return best;
+}
+
+bool whisper_ffi_vector_index::add(int64_t id, const float* vector) {
+    std::vector<float> unit(vector, vector + dim);
+    if (!normalize(unit.data(), dim)) {
+        return false;
+    }
+    const uint32_t row = (uint32_t) ids.size();
+    ids.push_back(id);
+    vectors.insert(vectors.end(), unit.begin(), unit.end());
+    if (!lists.empty()) {
+        const uint32_t list = nearest_list(unit.data());
+        list_of.push_back(list);
+        lists[list].push_back(row);
+    }
+    return true;
+}
+
+bool whisper_ffi_vector_index::train(int n_lists) {
+    const size_t n = ids.size();
+    if (n_lists <= 0) {
+        n_lists = (int) std::lround(std::sqrt((double) n));
+    }
+    n_lists = (int) std::min<size_t>((size_t) n_lists, n);
+    if (n_lists < 1) {
+        return false;
+    }
+
+    // Spherical k-means on a sample, seeded with distinct random vectors
+    std::mt19937 rng(0x5EED);
+    std::vector<uint32_t> rows(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        rows[i] = i;
+    }
+    std::shuffle(rows.begin(), rows.end(), rng);
+    const size_t n_sample = std::min(n, (size_t) n_lists * KMEANS_SAMPLES_PER_LIST);
+
+    std::vector<float> trained((size_t) n_lists * dim);
+    for (int l = 0; l < n_lists; ++l) {
+        memcpy(trained.data() + (size_t) l * dim, vectors.data() + (size_t) rows[l] * dim, sizeof(float) * dim);
+    }
+    centroids.swap(trained);
+    lists.assign(n_lists, {});
+
+    std::vector<float> sums((size_t) n_lists * dim);
+    std::vector<size_t> counts(n_lists);
+    for (int iteration = 0; iteration < KMEANS_ITERATIONS; ++iteration) {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t s = 0; s < n_sample; ++s) {
+            const float* vector = vectors.data() + (size_t) rows[s] * dim;
+            const uint32_t list = nearest_list(vector);
+            float* sum = sums.data() + (size_t) list * dim;
+            for (int k = 0; k < dim; ++k) {
+                sum[k] += vector[k];
+            }
+            ++counts[list];
+        }
+        for (int l = 0; l < n_lists; ++l) {
+            float* centroid = centroids.data() + (size_t) l * dim;
+            // An empty list keeps its centroid
+            if (counts[l] > 0 && normalize(sums.data() + (size_t) l * dim, dim)) {
+                memcpy(centroid, sums.data() + (size_t) l * dim, sizeof(float) * dim);
+            }
+        }
+    }
+
+    // File every vector, in parallel: this is n x n_lists dot products
+    list_of.assign(n, 0);
+    const size_t n_workers = std::max<size_t>(1, std::min<size_t>((size_t) available_cpus(), n / 1024 + 1));
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < n_workers; ++w) {
+        workers.emplace_back([this, w, n, n_workers] {
+            for (size_t i = w; i < n; i += n_workers) {
+                list_of[i] = nearest_list(vectors.data() + i * dim);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        lists[list_of[i]].push_back(i);
+    }
+
+    std::cerr << "🧭 Trained vector index: " << n << " vectors in " << n_lists << " lists" << std::endl;
+    return true;
+}
+
+int whisper_ffi_vector_index::search(const float* query, int k, int n_probe, int64_t* out_ids, float* out_scores) const {
+    if (k <= 0 || ids.empty()) {
+        return 0;
+    }
+    std::vector<float> unit(query, query + dim);
+    if (!normalize(unit.data(), dim)) {
+        return 0;
+    }
+
+    // Min-heap of the best k so far
+    using match = std::pair<float, uint32_t>;
+    std::priority_queue<match, std::vector<match>, std::greater<match>> best;
+    auto consider = [&](uint32_t row) {
+        const float score = dot_product(unit.data(), vectors.data() + (size_t) row * dim, dim);
+        if ((int) best.size() < k) {
+            best.emplace(score, row);
+        } else if (score > best.top().first) {
+            best.pop();
+            best.emplace(score, row);
+        }
+    };
+
+    if (lists.empty()) {
+        for (uint32_t row = 0; row < ids.size(); ++row) {
+            consider(row);
+        }
+    } else {
+        if (n_probe <= 0) {
+            n_probe = (int) std::ceil(std::sqrt((double) lists.size()));
+        }
+        n_probe = std::min<int>(n_probe, (int) lists.size());
+        std::vector<match> list_scores(lists.size());
+        for (uint32_t l = 0; l < lists.size(); ++l) {
+            list_scores[l] = {dot_product(unit.data(), centroids.data() + (size_t) l * dim, dim), l};
+        }
+        std::partial_sort(list_scores.begin(), list_scores.begin() + n_probe, list_scores.end(), std::greater<match>());
+        for (int p = 0; p < n_probe; ++p) {
+            for (uint32_t row : lists[list_scores[p].second]) {
+                consider(row);
+            }
+        }
+    }
+
+    const int found = (int) best.size();
+    for (int i = found - 1; i >= 0; --i) {
+        out_ids[i] = ids[best.top().second];
+        if (out_scores) {
+            out_scores[i] = best.top().first;
+        }
+        best.pop();
+    }
+    return found;
+}
+
+bool whisper_ffi_vector_index::save(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "❌ Could not create vector index: " << path << std::endl;
+        return false;
+    }
+    const uint32_t header[3] = {VECTOR_INDEX_VERSION, (uint32_t) dim, (uint32_t) lists.size()};
+    const uint64_t n = ids.size();
+    bool ok = fwrite(VECTOR_INDEX_MAGIC, 1, 4, file) == 4 && fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(&n, sizeof(n), 1, file) == 1 &&
+              fwrite(ids.data(), sizeof(int64_t), n, file) == n &&
+              fwrite(vectors.data(), sizeof(float), vectors.size(), file) == vectors.size() &&
+              fwrite(centroids.data(), sizeof(float), centroids.size(), file) == centroids.size() &&
+              fwrite(list_of.data(), sizeof(uint32_t), list_of.size(), file) == list_of.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        std::cerr << "❌ Failed to write vector index: " << path << std::endl;
+        remove(path.c_str());
+    }
+    return ok;
+}
+
+std::unique_ptr<whisper_ffi_vector_index> whisper_ffi_vector_index::load(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "❌ Could not open vector index: " << path << std::endl;
+        return nullptr;
+    }
+    char magic[4];
+    uint32_t header[3];
+    uint64_t n = 0;
+    std::unique_ptr<whisper_ffi_vector_index> index;
+    if (fread(magic, 1, 4, file) == 4 && memcmp(magic, VECTOR_INDEX_MAGIC, 4) == 0 &&
+        fread(header, sizeof(header), 1, file) == 1 && header[0] == VECTOR_INDEX_VERSION && header[1] > 0 &&
+        fread(&n, sizeof(n), 1, file) == 1 && header[2] <= n) {
+        const size_t dim = header[1];
+        const size_t n_lists = header[2];
+        index.reset(new whisper_ffi_vector_index((int) dim));
+        index->ids.resize(n);
+        index->vectors.resize(n * dim);
+        index->centroids.resize(n_lists * dim);
+        index->list_of.resize(n_lists > 0 ? n : 0);
+        bool ok = fread(index->ids.data(), sizeof(int64_t), n, file) == n &&
+                  fread(index->vectors.data(), sizeof(float), n * dim, file) == n * dim &&
+                  fread(index->centroids.data(), sizeof(float), n_lists * dim, file) == n_lists * dim &&
+                  fread(index->list_of.data(), sizeof(uint32_t), index->list_of.size(), file) == index->list_of.size();
+        index->lists.assign(n_lists, {});
+        for (uint32_t i = 0; ok && i < index->list_of.size(); ++i) {
+            ok = index->list_of[i] < n_lists;
+            if (ok) {
+                index->lists[index->list_of[i]].push_back(i);
+            }
+        }
+        if (!ok) {
+            index.reset();
+        }
+    }
+    fclose(file);
+    if (!index) {
+        std::cerr << "❌ Invalid vector index: " << path << std::endl;
+    }
+    return index;
+}
+
+extern "C" {
+
+whisper_ffi_vector_index* whisper_ffi_index_create(int dim) {
+    if (dim <= 0) {
+        return nullptr;
+    }
+    try {
+        return new whisper_ffi_vector_index(dim);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+whisper_ffi_vector_index* whisper_ffi_index_load(const char* path) {
+    if (!path) {
+        return nullptr;
+    }
+    try {
+        return whisper_ffi_vector_index::load(path).release();
+    } catch (...) {
+        std::cerr << "💥 Exception loading vector index: " << path << std::endl;
+        return nullptr;
+    }
+}
+
+bool whisper_ffi_index_add(whisper_ffi_vector_index* index, int64_t id, const float* vector) {
+    if (!index || !vector) {
+        return false;
+    }
+    try {
+        std::unique_lock<std::shared_mutex> lock(index->mutex);
+        return index->add(id, vector);
+    } catch (...) {
+        std::cerr << "💥 Exception adding to vector index" << std::endl;
+        return false;
+    }
+}
+
+bool whisper_ffi_index_train(whisper_ffi_vector_index* index, int n_lists) {
+    if (!index) {
+        return false;
+    }
+    try {
+        std::unique_lock<std::shared_mutex> lock(index->mutex);
+        return index->train(n_lists);
+    } catch (...) {
+        std::cerr << "💥 Exception training vector index" << std::endl;
+        return false;
+    }
+}
+
+int whisper_ffi_index_search(whisper_ffi_vector_index* index, const float* query, int k, int n_probe,
+                             int64_t* ids, float* scores) {
+    if (!index || !query || !ids) {
+        return 0;
+    }
+    try {
+        std::shared_lock<std::shared_mutex> lock(index->mutex);
+        return index->search(query, k, n_probe, ids, scores);
+    } catch (...) {
+        std::cerr << "💥 Exception searching vector index" << std::endl;
+        return 0;
+    }
+}
+
+int64_t whisper_ffi_index_size(whisper_ffi_vector_index* index) {
+    if (!index) {
+        return 0;
+    }
+    std::shared_lock<std::shared_mutex> lock(index->mutex);
+    return (int64_t) index->size();
+}
+
+bool whisper_ffi_index_save(whisper_ffi_vector_index* index, const char* path) {
+    if (!index || !path) {
+        return false;
+    }
+    try {
+        std::shared_lock<std::shared_mutex> lock(index->mutex);
+        return index->save(path);
+    } catch (...) {
+        std::cerr << "💥 Exception saving vector index: " << path << std::endl;
+        return false;
+    }
+}
+
+void whisper_ffi_index_free(whisper_ffi_vector_index* index) {
+    delete index;
+}
+
+}
@@ -0,0 +1,65 @@
+#ifndef VECTOR_INDEX_H
+#define VECTOR_INDEX_H
+
+// Nearest-neighbour index over audio embeddings.
+//
+// Vectors are normalized on insertion and stored in one contiguous array,
+// so cosine similarity is a plain dot product (AVX2/FMA or NEON kernels,
+// chosen at runtime on x86). Until train() runs every query scans all
+// vectors. train() adds an IVF layer: spherical k-means centroids, every
+// vector filed in the list of its nearest centroid, and queries scan only
+// the n_probe lists closest to them, which keeps hundreds of thousands of
+// memos within a few milliseconds per query.
+//
+// File layout (little-endian):
+//
+//   header     "VBVI" | u32 version | u32 dim | u32 n_lists | u64 n_vectors
+//   ids        n_vectors x i64
+//   vectors    n_vectors x dim f32
+//   centroids  n_lists x dim f32
+//   lists      n_vectors x u32  list of every vector
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Dot product of two float arrays
+float dot_product(const float* a, const float* b, size_t n);
+
+struct whisper_ffi_vector_index {
+    explicit whisper_ffi_vector_index(int dim);
+
+    // Append a vector (normalized here); false for a zero vector
+    bool add(int64_t id, const float* vector);
+
+    // Build n_lists IVF lists (0 = sqrt of the vector count)
+    bool train(int n_lists);
+
+    // Up to k best matches by cosine similarity, best first; n_probe lists
+    // are scanned once trained (0 = sqrt of the list count). Returns the count.
+    int search(const float* query, int k, int n_probe, int64_t* ids, float* scores) const;
+
+    bool save(const std::string& path) const;
+    static std::unique_ptr<whisper_ffi_vector_index> load(const std::string& path);
+
+    size_t size() const { return ids.size(); }
+
+    const int dim;
+
+    // Searches share, adds and training are exclusive
+    mutable std::shared_mutex mutex;
+
+private:
+    uint32_t nearest_list(const float* vector) const;
+
+    std::vector<int64_t> ids;
+    std::vector<float> vectors;
+    std::vector<float> centroids;      // n_lists x dim, empty until trained
+    std::vector<uint32_t> list_of;     // List of every vector
+    std::vector<std::vector<uint32_t>> lists; // Vector rows per list
+};
+
+#endif // VECTOR_INDEX_H
@@ -0,0 +1,121 @@
+# Flutter FFI wrapper library.
+# Included from the whisper.cpp CMakeLists.txt by scripts/build_whisper.sh,
+# so CMAKE_CURRENT_SOURCE_DIR is the whisper.cpp checkout.
+
+set(WHISPER_FFI_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+file(GLOB WHISPER_FFI_SOURCES ${WHISPER_FFI_DIR}/*.cpp)
+
+add_library(whisper_ffi SHARED ${WHISPER_FFI_SOURCES})
+
+# whisper_ffi_cpp.h uses coroutines
+target_compile_features(whisper_ffi PUBLIC cxx_std_20)
+
+target_link_libraries(whisper_ffi whisper)
+target_include_directories(whisper_ffi PRIVATE ${CMAKE_CURRENT_SOURCE_DIR} ${CMAKE_CURRENT_SOURCE_DIR}/include)
+target_include_directories(whisper_ffi PRIVATE ${WHISPER_FFI_DIR})
+
+# CPU matrix backend chosen by build_whisper.sh --blas, reported at runtime by
+# whisper_ffi_system_info. A requested BLAS that ggml could not find falls
+# back to the built-in kernels, so report what was actually built.
+set(WHISPER_FFI_BLAS_BACKEND "default" CACHE STRING "CPU matrix backend label (default, ggml, openblas, blis)")
+set(WHISPER_FFI_BLAS_REPORTED ${WHISPER_FFI_BLAS_BACKEND})
+if (NOT WHISPER_FFI_BLAS_BACKEND MATCHES "^(default|ggml)$" AND NOT TARGET ggml-blas)
+    message(WARNING "whisper_ffi: ${WHISPER_FFI_BLAS_BACKEND} requested but the ggml BLAS backend was not built, using ggml kernels")
+    set(WHISPER_FFI_BLAS_REPORTED "ggml")
+endif()
+target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_BLAS_BACKEND="${WHISPER_FFI_BLAS_REPORTED}")
+
+# OpenVINO encoder (build_whisper.sh --openvino sets WHISPER_OPENVINO)
+if (WHISPER_OPENVINO)
+    target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_OPENVINO)
+endif()
+
+# Audio embeddings read the encoder output through the accessor that
+# build_whisper.sh appends to whisper.cpp
+file(STRINGS ${CMAKE_CURRENT_SOURCE_DIR}/src/whisper.cpp WHISPER_FFI_ENCODER_OUTPUT REGEX "whisper_ffi_encoder_output")
+if (WHISPER_FFI_ENCODER_OUTPUT)
+    target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_ENCODER_OUTPUT)
+endif()
+
+# Optional zstd compression for the transcript store
+find_package(PkgConfig QUIET)
+if (PKG_CONFIG_FOUND)
+    pkg_check_modules(WHISPER_FFI_ZSTD IMPORTED_TARGET libzstd)
+    if (WHISPER_FFI_ZSTD_FOUND)
+        target_link_libraries(whisper_ffi PkgConfig::WHISPER_FFI_ZSTD)
+        target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_ZSTD)
+    endif()
+
+    # Optional Ogg Opus storage for recordings
+    pkg_check_modules(WHISPER_FFI_OPUS IMPORTED_TARGET opus ogg)
+    if (WHISPER_FFI_OPUS_FOUND)
+        target_link_libraries(whisper_ffi PkgConfig::WHISPER_FFI_OPUS)
+        target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_OPUS)
+    endif()
+
+    # Optional FLAC input for streamed audio
+    pkg_check_modules(WHISPER_FFI_FLAC IMPORTED_TARGET flac)
+    if (WHISPER_FFI_FLAC_FOUND)
+        target_link_libraries(whisper_ffi PkgConfig::WHISPER_FFI_FLAC)
+        target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_FLAC)
+    endif()
+endif()
+
+# Optional Arrow IPC / Parquet segment export
+find_package(Arrow CONFIG QUIET)
+if (Arrow_FOUND)
+    target_link_libraries(whisper_ffi Arrow::arrow_shared)
+    target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_ARROW)
+
+    find_package(Parquet CONFIG QUIET)
+    if (Parquet_FOUND)
+        target_link_libraries(whisper_ffi Parquet::parquet_shared)
+        target_compile_definitions(whisper_ffi PRIVATE WHISPER_FFI_WITH_PARQUET)
+    endif()
+endif()
+
+# whisper_ffi_probe_* boundary probes for the FFI benchmarks; shipping builds
+# leave them out (./scripts/build_whisper.sh --bench turns them on)
+option(WHISPER_FFI_WITH_PROBES "Export the whisper_ffi_probe_* benchmark probes" OFF)
+if (WHISPER_FFI_WITH_PROBES)
+    target_compile_definitions(whisper_ffi PUBLIC WHISPER_FFI_WITH_PROBES)
+endif()
+
+# Benchmarks for the wrapper API (./scripts/build_whisper.sh --bench)
+option(WHISPER_FFI_BUILD_BENCH "Build whisper_ffi benchmarks" OFF)
+if (WHISPER_FFI_BUILD_BENCH)
+    file(GLOB WHISPER_FFI_BENCH_SOURCES ${WHISPER_FFI_DIR}/bench/*.cpp)
+    foreach (bench_source ${WHISPER_FFI_BENCH_SOURCES})
+        get_filename_component(bench_name ${bench_source} NAME_WE)
+        if (bench_name STREQUAL "bench_ffi_boundary" AND NOT WHISPER_FFI_WITH_PROBES)
+            continue()
+        endif()
+        add_executable(${bench_name} ${bench_source})
+        target_link_libraries(${bench_name} whisper_ffi)
+        target_include_directories(${bench_name} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR} ${CMAKE_CURRENT_SOURCE_DIR}/include ${WHISPER_FFI_DIR})
+    endforeach()
+endif()
+
+# Behavior tests for the wrapper (./scripts/build_whisper.sh --test runs them
+# with ctest). They need no model: each exercises one component directly.
+option(WHISPER_FFI_BUILD_TESTS "Build whisper_ffi tests" OFF)
+if (WHISPER_FFI_BUILD_TESTS)
+    enable_testing()
+    # Tests may call internal functions (loop_guard.h, opus_codec.h) besides the C API
+    set_target_properties(whisper_ffi PROPERTIES CXX_VISIBILITY_PRESET default WINDOWS_EXPORT_ALL_SYMBOLS ON)
+    file(GLOB WHISPER_FFI_TEST_SOURCES ${WHISPER_FFI_DIR}/tests/*.cpp)
+    foreach (test_source ${WHISPER_FFI_TEST_SOURCES})
+        get_filename_component(test_name ${test_source} NAME_WE)
+        add_executable(${test_name} ${test_source})
+        target_link_libraries(${test_name} whisper_ffi whisper)
+        target_include_directories(${test_name} PRIVATE ${CMAKE_CURRENT_SOURCE_DIR} ${CMAKE_CURRENT_SOURCE_DIR}/include ${WHISPER_FFI_DIR})
+        add_test(NAME whisper_ffi_${test_name} COMMAND ${test_name})
+        # test_common.h: TEST_SKIPPED when an optional library is missing. Some
+        # tests block on leases, so a regression times out instead of hanging.
+        set_tests_properties(whisper_ffi_${test_name} PROPERTIES SKIP_RETURN_CODE 77 TIMEOUT 60)
+    endforeach()
+    if (WHISPER_FFI_OPUS_FOUND)
+        target_compile_definitions(test_opus_codec PRIVATE WHISPER_FFI_WITH_OPUS)
+    endif()
+endif()
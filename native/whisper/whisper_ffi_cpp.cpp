@@ -0,0 +1,205 @@
+#include "whisper_ffi_cpp.h"
+#include "whisper_ffi_internal.h"
+#include "scratch_arena.h"
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace whisper_ffi {
+
+model::model(const std::string& path, const init_params& params) : ctx_(load_model(path.c_str(), params)) {}
+
+model::~model() {
+    if (ctx_) {
+        free_model(ctx_);
+    }
+}
+
+model& model::operator=(model&& other) noexcept {
+    if (this != &other) {
+        if (ctx_) {
+            free_model(ctx_);
+        }
+        ctx_ = std::exchange(other.ctx_, nullptr);
+    }
+    return *this;
+}
+
+model model::adopt(whisper_context* ctx) {
+    model owned;
+    owned.ctx_ = ctx;
+    return owned;
+}
+
+std::string transcript::text() const {
+    std::string text;
+    for (const segment& s : segments_) {
+        text += s.text;
+    }
+    return text;
+}
+
+session::session(const model& model, const transcribe_params& params) : session(model.get(), params) {}
+
+session::session(whisper_context* ctx, const transcribe_params& params) : ctx_(ctx), params_(params) {
+    if (ctx_) {
+        std::vector<whisper_state*> states = acquire_states(ctx_, 1);
+        state_ = states.empty() ? nullptr : states[0];
+    }
+}
+
+session::~session() {
+    if (state_) {
+        release_states(ctx_, {state_});
+    }
+}
+
+session::session(session&& other) noexcept
+    : ctx_(other.ctx_), state_(std::exchange(other.state_, nullptr)), params_(other.params_) {}
+
+transcript session::transcribe(const std::string& audio_path) {
+    std::cerr << "🎵 Starting transcription for: " << audio_path << std::endl;
+
+    scratch_pcm pcm(scratch_slot::pcm);
+    if (!read_audio_file(audio_path, *pcm)) {
+        std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+        return transcript();
+    }
+    return transcribe(*pcm);
+}
+
+transcript session::transcribe(const std::vector<float>& pcm) {
+    transcript result;
+    if (!state_) {
+        std::cerr << "❌ Session has no model or decoder state" << std::endl;
+        return result;
+    }
+    result.ok_ = transcribe_pcm(ctx_, state_, pcm, params_, [&result](segment&& s) {
+        result.segments_.push_back(std::move(s));
+        return true;
+    });
+    return result;
+}
+
+namespace {
+
+// Segments decoded ahead of the consumer before the decode waits for it
+static const size_t SEGMENT_CHANNEL_CAPACITY = 4;
+
+// Hands segments from the decoding thread to the generator. A full queue
+// blocks the decoder, so a slow consumer holds back decoding instead of
+// buffering the whole file.
+class segment_channel {
+public:
+    // Blocks while the queue is full; false once the consumer has cancelled
+    bool push(segment&& s) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return queue_.size() < SEGMENT_CHANNEL_CAPACITY || cancelled_; });
+        if (cancelled_) {
+            return false;
+        }
+        queue_.push_back(std::move(s));
+        ready_.notify_one();
+        return true;
+    }
+
+    // Blocks until a segment arrives; false once the producer is done and the queue is drained
+    bool pop(segment& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return !queue_.empty() || closed_; });
+        if (queue_.empty()) {
+            return false;
+        }
+        out = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // No more segments; `error` says why the decode ended early, if it did
+    void close(std::exception_ptr error = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        error_ = error;
+        ready_.notify_all();
+    }
+
+    // Failure recorded by close(); read after pop() returned false
+    std::exception_ptr error() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return error_;
+    }
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        queue_.clear();
+        not_full_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable not_full_;
+    std::deque<segment> queue_;
+    std::exception_ptr error_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+};
+
+// Lives in the coroutine frame: when the generator is destroyed before the
+// end, the decode is told to stop and the thread is joined
+struct producer_guard {
+    segment_channel& channel;
+    std::thread thread;
+
+    ~producer_guard() {
+        channel.cancel();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+};
+
+} // namespace
+
+segment_generator session::segments(std::string audio_path) {
+    if (!state_) {
+        std::cerr << "❌ Session has no model or decoder state" << std::endl;
+        throw std::runtime_error("session has no model or decoder state");
+    }
+
+    segment_channel channel;
+    producer_guard producer{channel, std::thread([this, &channel, &audio_path] {
+        std::exception_ptr error;
+        try {
+            const std::vector<float> pcm = read_audio_file(audio_path);
+            if (pcm.empty()) {
+                std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+                throw std::runtime_error("failed to read audio file: " + audio_path);
+            }
+            // Also false when the consumer stopped early, but then nobody reads the error
+            if (!transcribe_pcm(ctx_, state_, pcm, params_, [&channel](segment&& s) {
+                    return channel.push(std::move(s));
+                })) {
+                throw std::runtime_error("transcription failed: " + audio_path);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        channel.close(error);
+    })};
+
+    segment current;
+    while (channel.pop(current)) {
+        co_yield current;
+    }
+    if (std::exception_ptr error = channel.error()) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace whisper_ffi
@@ -0,0 +1,230 @@
+#ifndef WHISPER_FFI_CPP_H
+#define WHISPER_FFI_CPP_H
+
+// C++20 interface to the transcription engine.
+//
+// The C functions in whisper_wrapper.h are a thin shim over these types; C++
+// callers can use them directly and get segments as structs instead of
+// JSON or joined strings:
+//
+//   whisper_ffi::model model("ggml-base.en.bin");
+//   whisper_ffi::session session(model);
+//   for (whisper_ffi::segment& segment : session.segments("memo.opus")) {
+//       consume(std::move(segment)); // Yielded while later windows still decode
+//   }
+//
+// Errors are reported the way the C API reports them: a model that failed to
+// load tests false, a failed transcript has ok() == false, and details go to
+// stderr. A segment generator cannot return a status, so iterating it throws
+// once a failed decode's earlier segments have been consumed.
+
+#include "whisper_wrapper.h"
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace whisper_ffi {
+
+using init_params = whisper_ffi_init_params;
+using transcribe_params = whisper_ffi_transcribe_params;
+
+// A word assembled from one or more tokens, timed by DTW alignment
+struct word {
+    int64_t t0_ms = 0;
+    int64_t t1_ms = 0;
+    std::string text;
+    float p = 0.0f; // Mean token probability
+};
+
+// A transcribed segment with timestamps in milliseconds from the start of the audio
+struct segment {
+    int64_t t0_ms = 0;
+    int64_t t1_ms = 0;
+    std::string text;
+    std::vector<word> words; // Only filled when word timestamps were requested
+    int speaker = -1;        // Speaker index when diarization ran
+    bool suspect = false;    // Looks like a hallucination loop (see loop_guard.h)
+    float p = 0.0f;          // Mean text token probability
+    std::vector<float> embedding; // Pooled encoder states when embeddings were requested
+};
+
+// Loaded model. Owns the whisper_context and its pooled decoder states.
+class model {
+public:
+    model() = default;
+    explicit model(const std::string& path, const init_params& params = whisper_ffi_init_default_params());
+    ~model();
+
+    model(model&& other) noexcept : ctx_(std::exchange(other.ctx_, nullptr)) {}
+    model& operator=(model&& other) noexcept;
+    model(const model&) = delete;
+    model& operator=(const model&) = delete;
+
+    explicit operator bool() const { return ctx_ != nullptr; }
+    whisper_context* get() const { return ctx_; }
+
+    // Hand the context to the C API (freed by whisper_ffi_free)
+    whisper_context* release() { return std::exchange(ctx_, nullptr); }
+
+    // Take ownership of a context created by whisper_ffi_init*
+    static model adopt(whisper_context* ctx);
+
+private:
+    whisper_context* ctx_ = nullptr;
+};
+
+// Result of a whole-file transcription. Move-only, so segment text and
+// word lists are never copied on the way to the caller.
+class transcript {
+public:
+    transcript() = default;
+    transcript(transcript&&) noexcept = default;
+    transcript& operator=(transcript&&) noexcept = default;
+    transcript(const transcript&) = delete;
+    transcript& operator=(const transcript&) = delete;
+
+    bool ok() const { return ok_; }
+    explicit operator bool() const { return ok_; }
+
+    const std::vector<segment>& segments() const { return segments_; }
+
+    // Move the segments out, leaving the transcript empty
+    std::vector<segment> take_segments() { return std::move(segments_); }
+
+    // Segment texts joined in order
+    std::string text() const;
+
+private:
+    friend class session;
+
+    std::vector<segment> segments_;
+    bool ok_ = false;
+};
+
+// Lazily evaluated sequence of segments (a minimal std::generator).
+// Iterate it once; destroying it early stops the decode behind it.
+class segment_generator {
+public:
+    struct promise_type {
+        segment* current = nullptr;
+        std::exception_ptr error;
+
+        segment_generator get_return_object() {
+            return segment_generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(segment& value) noexcept {
+            current = &value;
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = segment;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        segment& operator*() const { return *handle_.promise().current; }
+        segment* operator->() const { return handle_.promise().current; }
+        iterator& operator++() {
+            resume(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return !handle_ || handle_.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    segment_generator(segment_generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    segment_generator& operator=(segment_generator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    segment_generator(const segment_generator&) = delete;
+    segment_generator& operator=(const segment_generator&) = delete;
+    ~segment_generator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    iterator begin() {
+        resume(handle_);
+        return iterator(handle_);
+    }
+    std::default_sentinel_t end() const { return {}; }
+
+private:
+    explicit segment_generator(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    static void resume(std::coroutine_handle<promise_type> handle) {
+        if (handle && !handle.done()) {
+            handle.resume();
+            if (handle.promise().error) {
+                std::rethrow_exception(handle.promise().error);
+            }
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// A decoding session on one model. Holds a pooled whisper_state for its
+// lifetime, so consecutive transcriptions skip state allocation. Sessions on
+// the same model may run concurrently; a single session may not.
+class session {
+public:
+    explicit session(const model& model, const transcribe_params& params = whisper_ffi_transcribe_default_params());
+    // Non-owning session on a context created through the C API
+    explicit session(whisper_context* ctx, const transcribe_params& params = whisper_ffi_transcribe_default_params());
+    ~session();
+
+    session(session&& other) noexcept;
+    session& operator=(session&&) = delete;
+    session(const session&) = delete;
+    session& operator=(const session&) = delete;
+
+    // Whole-file transcription (WAV or Opus)
+    transcript transcribe(const std::string& audio_path);
+
+    // Transcription of 16 kHz mono samples already in memory
+    transcript transcribe(const std::vector<float>& pcm);
+
+    // Segments yielded as they are decoded. Decoding runs on a producer
+    // thread that stays at most a few segments ahead of the consumer;
+    // the session must outlive the generator. An unreadable file or failed
+    // decode throws std::runtime_error from the iteration after the segments
+    // decoded before it, so it is never mistaken for a silent recording.
+    segment_generator segments(std::string audio_path);
+
+    const transcribe_params& params() const { return params_; }
+
+private:
+    whisper_context* ctx_ = nullptr;
+    whisper_state* state_ = nullptr;
+    transcribe_params params_;
+};
+
+} // namespace whisper_ffi
+
+#endif // WHISPER_FFI_CPP_H
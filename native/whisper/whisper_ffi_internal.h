@@ -0,0 +1,79 @@
+#ifndef WHISPER_FFI_INTERNAL_H
+#define WHISPER_FFI_INTERNAL_H
+
+// Helpers shared between the wrapper's translation units.
+// Not part of the FFI surface: Dart only sees whisper_wrapper.h.
+
+#include "whisper_wrapper.h"
+#include "whisper_ffi_cpp.h"
+#include "cpu_budget.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using ffi_word = whisper_ffi::word;
+using ffi_segment = whisper_ffi::segment;
+
+// Receives segments in order as they are decoded; return false to stop decoding
+using segment_callback = std::function<bool(ffi_segment&&)>;
+
+// Read a WAV (16-bit PCM or 32-bit float) or Ogg Opus file into mono float samples
+std::vector<float> read_audio_file(const std::string& filename);
+
+// Same into `pcm` (cleared first, capacity kept); false when nothing was read
+bool read_audio_file(const std::string& filename, std::vector<float>& pcm);
+
+// Lower-case extension of a file name ("" if none)
+std::string get_file_extension(const std::string& filename);
+
+// Move a segment and its words later by offset_ms
+void shift_segment(ffi_segment& segment, int64_t offset_ms);
+
+// Load a model with the wrapper's context options; null on failure
+whisper_context* load_model(const char* model_path, const whisper_ffi_init_params& params);
+
+// Free a context together with its pooled states
+void free_model(whisper_context* ctx);
+
+// Take up to `count` decoder states from the context's pool, creating missing ones
+std::vector<whisper_state*> acquire_states(whisper_context* ctx, int count);
+
+// Return states to the context's pool
+void release_states(whisper_context* ctx, const std::vector<whisper_state*>& states);
+
+// Decode 16 kHz mono samples, handing segments to `on_segment` in order.
+// `state` is the caller's pooled state (null = borrow one for the call);
+// `priority` orders the call's thread lease against other decodes.
+bool transcribe_pcm(whisper_context* ctx, whisper_state* state, const std::vector<float>& pcm,
+                    const whisper_ffi_transcribe_params& params, const segment_callback& on_segment,
+                    lease_priority priority = lease_priority::normal);
+
+// Decode an audio file into timestamped segments
+bool transcribe_segments(whisper_context* ctx, const char* audio_path,
+                         const whisper_ffi_transcribe_params& params, std::vector<ffi_segment>& segments);
+
+// Copy into a string the caller releases with whisper_ffi_free_string
+char* copy_to_c_string(const std::string& str);
+
+// Escape a UTF-8 string for embedding in a JSON string literal
+std::string json_escape(const std::string& str);
+
+// JSON array of segments, including words when present
+std::string segments_to_json(const std::vector<ffi_segment>& segments);
+
+// Appending forms of the above (append_segment_json: one element of the array)
+void append_json_escaped(std::string& out, const std::string& str);
+void append_segment_json(std::string& json, const ffi_segment& segment);
+void append_segments_json(std::string& json, const std::vector<ffi_segment>& segments);
+// `language`, when set, leads the result block as "language"
+void append_result_json(std::string& json, const std::vector<ffi_segment>& segments, const char* language = nullptr);
+
+// {"text": ..., "segments": [...]} result block of whisper_ffi_transcribe_json
+std::string result_to_json(const std::vector<ffi_segment>& segments);
+
+// The result block built in the thread's scratch text and copied out once,
+// freed with whisper_ffi_free_string
+char* result_to_c_string(const std::vector<ffi_segment>& segments);
+
+#endif // WHISPER_FFI_INTERNAL_H
@@ -1,12 +1,32 @@
 #include "whisper_wrapper.h"
+#include "whisper_ffi_internal.h"
+#include "cpu_budget.h"
+#include "diarization.h"
+#include "audio_classifier.h"
+#include "audio_embedding.h"
+#include "audio_stream.h"
+#include "loop_guard.h"
+#include "opus_codec.h"
+#include "scratch_arena.h"
 #include "whisper.h"
 #include <cstring>
+#include <cstdio>
 #include <vector>
 #include <iostream>
 #include <fstream> // Required for file operations
 #include <cstdlib>
 #include <algorithm>
 #include <cctype>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+#ifndef WHISPER_FFI_BLAS_BACKEND
+#define WHISPER_FFI_BLAS_BACKEND "default"
+#endif
 
 // Helper function to convert string to lowercase for case-insensitive comparison
 std::string to_lower(const std::string& str) {
@@ -44,11 +64,12 @@ bool check_file_info(const std::string &fname, size_t& file_size) {
 }
 
 // Helper function to read audio file into float array
-std::vector<float> read_audio_file(const std::string& filename) {
+bool read_audio_file(const std::string& filename, std::vector<float>& audio_data) {
+    audio_data.clear();
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "❌ Could not open file: " << filename << std::endl;
-        return {};
+        return false;
     }
     
     // Read file size
@@ -61,213 +82,850 @@ std::vector<float> read_audio_file(const std::string& filename) {
     std::string extension = get_file_extension(filename);
     std::cout << "📄 File extension: " << extension << std::endl;
     
+    // Opus memos are decoded straight to 16 kHz float, no intermediate WAV
+    if (extension == "opus" || extension == "ogg") {
+        audio_data = decode_ogg_opus(filename);
+        return !audio_data.empty();
+    }
+
     if (extension != "wav") {
-        std::cerr << "❌ Unsupported file format: " << extension << " (only WAV supported)" << std::endl;
-        return {};
+        std::cerr << "❌ Unsupported file format: " << extension << " (only WAV and Opus supported)" << std::endl;
+        return false;
     }
     
-    // Read and validate RIFF header
-    char riff_header[12];
-    file.read(riff_header, 12);
-    
-    if (std::string(riff_header, 4) != "RIFF") {
-        std::cerr << "❌ Invalid RIFF header" << std::endl;
-        return {};
+    // Any channel count (downmixed), 16-bit PCM or 32-bit float
+    if (!read_wav_file(filename, 0, SIZE_MAX, audio_data)) {
+        return false;
     }
     
-    if (std::string(riff_header + 8, 4) != "WAVE") {
-        std::cerr << "❌ Invalid WAVE header" << std::endl;
-        return {};
+    std::cout << "✅ Successfully read " << audio_data.size() << " audio samples" << std::endl;
+    return !audio_data.empty();
+}
+
+std::vector<float> read_audio_file(const std::string& filename) {
+    std::vector<float> audio_data;
+    read_audio_file(filename, audio_data);
+    return audio_data;
+}
+
+// Model name from a ggml file path: "models/ggml-base.en-q5_1.bin" -> "base.en"
+static std::string model_name_from_path(const std::string& path) {
+    std::string name = path.substr(path.find_last_of("/\\") + 1);
+    if (name.compare(0, 5, "ggml-") == 0) {
+        name = name.substr(5);
     }
-    
-    // Search for fmt chunk (not at fixed offset due to possible JUNK chunks)
-    uint16_t audio_format = 0;
-    uint16_t num_channels = 0;
-    uint32_t sample_rate = 0;
-    uint16_t bits_per_sample = 0;
-    bool fmt_found = false;
-    
-    while (file.tellg() < file_size - 8) {
-        char chunk_id[4];
-        uint32_t chunk_size;
-        
-        file.read(chunk_id, 4);
-        file.read(reinterpret_cast<char*>(&chunk_size), 4);
-        
-        std::string chunk_name(chunk_id, 4);
-        std::cout << "🔍 Found chunk: '" << chunk_name << "' size: " << chunk_size << std::endl;
-        
-        if (chunk_name == "fmt ") {
-            fmt_found = true;
-            
-            // Read format chunk
-            file.read(reinterpret_cast<char*>(&audio_format), 2);
-            file.read(reinterpret_cast<char*>(&num_channels), 2);
-            file.read(reinterpret_cast<char*>(&sample_rate), 4);
-            
-            // Skip byte rate and block align
-            file.seekg(6, std::ios::cur);
-            
-            file.read(reinterpret_cast<char*>(&bits_per_sample), 2);
-            
-            // Skip any remaining format chunk data
-            size_t remaining = chunk_size - 16;
-            if (remaining > 0) {
-                file.seekg(remaining, std::ios::cur);
-            }
-            
-            break;
-        } else if (chunk_name == "data") {
-            // Found data chunk but no fmt chunk yet - this shouldn't happen
-            std::cerr << "❌ Found data chunk before fmt chunk" << std::endl;
-            return {};
-        } else {
-            // Skip unknown chunk (like JUNK)
-            std::cout << "⏭️ Skipping chunk: " << chunk_name << std::endl;
-            file.seekg(chunk_size, std::ios::cur);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+        name = name.substr(0, name.size() - 4);
+    }
+    const size_t quant = name.find("-q");
+    if (quant != std::string::npos) {
+        name = name.substr(0, quant);
+    }
+    return to_lower(name);
+}
+
+// Alignment heads whisper.cpp ships for each official model
+static whisper_alignment_heads_preset alignment_heads_preset(const std::string& name) {
+    static const std::pair<const char*, whisper_alignment_heads_preset> presets[] = {
+        {"tiny.en", WHISPER_AHEADS_TINY_EN},
+        {"tiny", WHISPER_AHEADS_TINY},
+        {"base.en", WHISPER_AHEADS_BASE_EN},
+        {"base", WHISPER_AHEADS_BASE},
+        {"small.en", WHISPER_AHEADS_SMALL_EN},
+        {"small", WHISPER_AHEADS_SMALL},
+        {"medium.en", WHISPER_AHEADS_MEDIUM_EN},
+        {"medium", WHISPER_AHEADS_MEDIUM},
+        {"large-v1", WHISPER_AHEADS_LARGE_V1},
+        {"large-v2", WHISPER_AHEADS_LARGE_V2},
+        {"large-v3-turbo", WHISPER_AHEADS_LARGE_V3_TURBO},
+        {"large-v3", WHISPER_AHEADS_LARGE_V3},
+        {"large", WHISPER_AHEADS_LARGE_V3},
+    };
+    for (const auto& preset : presets) {
+        if (name == preset.first) {
+            return preset.second;
         }
     }
-    
-    if (!fmt_found) {
-        std::cerr << "❌ No fmt chunk found in WAV file" << std::endl;
-        return {};
+    return WHISPER_AHEADS_N_TOP_MOST;
+}
+
+// Wrapper-owned resources that live as long as a whisper_context
+struct ffi_context_extras {
+    std::mutex mutex;
+    std::vector<whisper_state*> idle_states; // One state per concurrent decode
+    bool word_timestamps = false;            // Context was created with DTW alignment heads
+    // OpenVINO encoder attached to every new state; empty device = ggml encoder
+    std::string openvino_device;
+    std::string openvino_encoder;
+    std::string openvino_cache_dir;
+};
+
+static std::mutex g_extras_mutex;
+static std::unordered_map<whisper_context*, std::unique_ptr<ffi_context_extras>> g_extras;
+
+static ffi_context_extras* get_context_extras(whisper_context* ctx) {
+    std::lock_guard<std::mutex> lock(g_extras_mutex);
+    std::unique_ptr<ffi_context_extras>& extras = g_extras[ctx];
+    if (!extras) {
+        extras.reset(new ffi_context_extras());
     }
-    
-    std::cout << "📊 WAV Info:" << std::endl;
-    std::cout << "   - Format: " << audio_format << " (1=PCM)" << std::endl;
-    std::cout << "   - Channels: " << num_channels << std::endl;
-    std::cout << "   - Sample Rate: " << sample_rate << " Hz" << std::endl;
-    std::cout << "   - Bits per Sample: " << bits_per_sample << std::endl;
-    
-    // Validate audio format
-    if (audio_format != 1) {
-        std::cerr << "❌ Unsupported audio format: " << audio_format << " (only PCM format supported)" << std::endl;
-        return {};
+    return extras.get();
+}
+
+static void release_context_extras(whisper_context* ctx) {
+    std::unique_ptr<ffi_context_extras> extras;
+    {
+        std::lock_guard<std::mutex> lock(g_extras_mutex);
+        auto it = g_extras.find(ctx);
+        if (it == g_extras.end()) {
+            return;
+        }
+        extras = std::move(it->second);
+        g_extras.erase(it);
     }
-    
-    if (num_channels != 1) {
-        std::cerr << "❌ Whisper requires mono audio (1 channel), got: " << num_channels << std::endl;
-        return {};
+    for (whisper_state* state : extras->idle_states) {
+        whisper_free_state(state);
     }
-    
-    if (sample_rate != 16000) {
-        std::cout << "⚠️ Sample rate is " << sample_rate << "Hz, Whisper expects 16kHz. Audio may not transcribe optimally." << std::endl;
+}
+
+static bool word_timestamps_enabled(whisper_context* ctx) {
+    ffi_context_extras* extras = get_context_extras(ctx);
+    std::lock_guard<std::mutex> lock(extras->mutex);
+    return extras->word_timestamps;
+}
+
+#ifdef WHISPER_FFI_WITH_OPENVINO
+// Encoder IR exported by whisper.cpp's convert-whisper-to-openvino.py:
+// models/ggml-base.en.bin -> models/ggml-base.en-encoder-openvino.xml
+static std::string openvino_sibling(const std::string& model_path, const char* suffix) {
+    std::string base = model_path;
+    if (base.size() > 4 && base.compare(base.size() - 4, 4, ".bin") == 0) {
+        base.resize(base.size() - 4);
     }
-    
-    if (bits_per_sample != 16) {
-        std::cout << "⚠️ Bit depth is " << bits_per_sample << " bits, expected 16 bits." << std::endl;
+    return base + suffix;
+}
+#endif
+
+// Point a fresh state's encoder at OpenVINO. The IR is compiled per state
+// (or loaded from the blob cache); on failure the context drops back to
+// the ggml encoder for good instead of retrying on every new state.
+static void attach_openvino_encoder(whisper_context* ctx, ffi_context_extras* extras, whisper_state* state) {
+    std::string device;
+    std::string encoder;
+    std::string cache_dir;
+    {
+        std::lock_guard<std::mutex> lock(extras->mutex);
+        if (extras->openvino_device.empty()) {
+            return;
+        }
+        device = extras->openvino_device;
+        encoder = extras->openvino_encoder;
+        cache_dir = extras->openvino_cache_dir;
     }
-    
-    // Now search for data chunk
-    bool data_found = false;
-    uint32_t data_size = 0;
-    
-    while (file.tellg() < file_size - 8) {
-        char chunk_id[4];
-        uint32_t chunk_size;
-        
-        file.read(chunk_id, 4);
-        file.read(reinterpret_cast<char*>(&chunk_size), 4);
-        
-        std::string chunk_name(chunk_id, 4);
-        
-        if (chunk_name == "data") {
-            data_found = true;
-            data_size = chunk_size;
-            std::cout << "💾 Found data chunk, size: " << data_size << " bytes" << std::endl;
+    if (whisper_ctx_init_openvino_encoder_with_state(ctx, state, encoder.c_str(), device.c_str(), cache_dir.c_str()) != 0) {
+        std::cerr << "⚠️ OpenVINO encoder failed to load on " << device << ", using ggml encoder" << std::endl;
+        std::lock_guard<std::mutex> lock(extras->mutex);
+        extras->openvino_device.clear();
+    }
+}
+
+// Take up to `count` states from the context's pool, creating missing ones.
+// States are kept after use so repeated jobs skip buffer allocation, and
+// concurrent calls on one context never share decoder state.
+std::vector<whisper_state*> acquire_states(whisper_context* ctx, int count) {
+    ffi_context_extras* extras = get_context_extras(ctx);
+    std::vector<whisper_state*> states;
+    {
+        std::lock_guard<std::mutex> lock(extras->mutex);
+        while (!extras->idle_states.empty() && (int) states.size() < count) {
+            states.push_back(extras->idle_states.back());
+            extras->idle_states.pop_back();
+        }
+    }
+    while ((int) states.size() < count) {
+        whisper_state* state = whisper_init_state(ctx);
+        if (!state) {
+            std::cerr << "⚠️ Could only allocate " << states.size() << " of " << count << " whisper states" << std::endl;
             break;
-        } else {
-            // Skip chunk
-            file.seekg(chunk_size, std::ios::cur);
         }
+        attach_openvino_encoder(ctx, extras, state);
+        states.push_back(state);
     }
-    
-    if (!data_found) {
-        std::cerr << "❌ No data chunk found in WAV file" << std::endl;
-        return {};
+    return states;
+}
+
+void release_states(whisper_context* ctx, const std::vector<whisper_state*>& states) {
+    ffi_context_extras* extras = get_context_extras(ctx);
+    std::lock_guard<std::mutex> lock(extras->mutex);
+    extras->idle_states.insert(extras->idle_states.end(), states.begin(), states.end());
+}
+
+// Base whisper parameters shared by every transcription path
+static whisper_full_params make_full_params(int n_threads, const char* language) {
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    if (language) {
+        wparams.language = language;
     }
-    
-    // Read audio data
-    size_t num_samples = data_size / (bits_per_sample / 8);
-    std::cout << "🎵 Number of samples: " << num_samples << std::endl;
-    
-    std::vector<float> audio_data;
-    audio_data.reserve(num_samples);
-    
-    if (bits_per_sample == 16) {
-        for (size_t i = 0; i < num_samples; ++i) {
-            int16_t sample;
-            file.read(reinterpret_cast<char*>(&sample), 2);
-            // Convert to float [-1.0, 1.0]
-            audio_data.push_back(sample / 32768.0f);
+    wparams.print_progress = false;
+    wparams.print_realtime = false;
+    wparams.print_timestamps = false;
+    // whisper.cpp's own default counts host cores, not the container's share
+    wparams.n_threads = n_threads > 0 ? n_threads : default_decode_threads();
+    return wparams;
+}
+
+// Group a segment's text tokens into words. A token starting with a space
+// opens a new word; each word starts at the DTW time of its first token and
+// ends where the next word starts (the last one at the segment end).
+static void collect_words(whisper_context* ctx, whisper_state* state, int i_segment,
+                          int64_t offset_ms, ffi_segment& segment) {
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_tokens = whisper_full_n_tokens_from_state(state, i_segment);
+
+    int n_word_tokens = 0;
+    for (int j = 0; j < n_tokens; ++j) {
+        const whisper_token_data token = whisper_full_get_token_data_from_state(state, i_segment, j);
+        if (token.id >= eot) {
+            continue; // Timestamp and other special tokens
         }
-    } else {
-        std::cerr << "❌ Unsupported bit depth: " << bits_per_sample << std::endl;
-        return {};
+        const char* text = whisper_full_get_token_text_from_state(ctx, state, i_segment, j);
+        if (!text || !*text) {
+            continue;
+        }
+
+        if (segment.words.empty() || text[0] == ' ') {
+            if (!segment.words.empty()) {
+                segment.words.back().p /= n_word_tokens;
+            }
+            ffi_word word;
+            word.t0_ms = token.t_dtw >= 0 ? offset_ms + token.t_dtw * 10 : segment.t0_ms;
+            word.t1_ms = segment.t1_ms;
+            word.p = 0.0f;
+            segment.words.push_back(std::move(word));
+            n_word_tokens = 0;
+        }
+
+        ffi_word& word = segment.words.back();
+        word.text += text[0] == ' ' && word.text.empty() ? text + 1 : text;
+        word.p += token.p;
+        ++n_word_tokens;
+    }
+    if (!segment.words.empty()) {
+        segment.words.back().p /= std::max(1, n_word_tokens);
+    }
+
+    for (size_t k = 0; k + 1 < segment.words.size(); ++k) {
+        // DTW times are monotonic in practice, but clamp so a word never ends before it starts
+        segment.words[k].t1_ms = std::max(segment.words[k].t0_ms, segment.words[k + 1].t0_ms);
     }
-    
-    std::cout << "✅ Successfully read " << audio_data.size() << " audio samples" << std::endl;
-    return audio_data;
 }
 
-extern "C" {
+static float mean_text_probability(whisper_context* ctx, whisper_state* state, int i_segment) {
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_tokens = whisper_full_n_tokens_from_state(state, i_segment);
+    float sum = 0.0f;
+    int n_text = 0;
+    for (int j = 0; j < n_tokens; ++j) {
+        const whisper_token_data token = whisper_full_get_token_data_from_state(state, i_segment, j);
+        if (token.id < eot) {
+            sum += token.p;
+            ++n_text;
+        }
+    }
+    return n_text > 0 ? sum / n_text : 0.0f;
+}
 
-whisper_context* whisper_ffi_init(const char* model_path) {
-    std::cerr << "🤖 Initializing Whisper with model: " << model_path << std::endl;
-    try {
-        struct whisper_context_params cparams = whisper_context_default_params();
-        struct whisper_context* ctx = whisper_init_from_file_with_params(model_path, cparams);
-        if (ctx) {
-            std::cerr << "✅ Whisper context initialized successfully" << std::endl;
-        } else {
-            std::cerr << "❌ Failed to initialize Whisper context" << std::endl;
+static ffi_segment make_segment(whisper_context* ctx, whisper_state* state, int i_segment,
+                                int64_t offset_ms, bool with_words) {
+    const char* text = whisper_full_get_segment_text_from_state(state, i_segment);
+    ffi_segment segment;
+    // Whisper timestamps are in 10 ms units
+    segment.t0_ms = offset_ms + whisper_full_get_segment_t0_from_state(state, i_segment) * 10;
+    segment.t1_ms = offset_ms + whisper_full_get_segment_t1_from_state(state, i_segment) * 10;
+    segment.text = text ? text : "";
+    segment.suspect = segment_is_suspect(ctx, state, i_segment);
+    segment.p = mean_text_probability(ctx, state, i_segment);
+    if (with_words) {
+        collect_words(ctx, state, i_segment, offset_ms, segment);
+    }
+    return segment;
+}
+
+static void append_segments(whisper_context* ctx, whisper_state* state, int64_t offset_ms,
+                            bool with_words, std::vector<ffi_segment>& out) {
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        out.push_back(make_segment(ctx, state, i, offset_ms, with_words));
+    }
+}
+
+// Streams segments out of a running whisper_full through new_segment_callback
+struct segment_stream {
+    const segment_callback* on_segment;
+    bool with_words;
+    int emitted;
+    bool stopped;
+    embedding_capture* embeddings; // Null when not requested
+    loop_guard guard;
+};
+
+static void on_new_segments(whisper_context* ctx, whisper_state* state, int n_new, void* user_data) {
+    // With DTW enabled whisper.cpp reports aligned segments one at a time,
+    // so track what was handed out instead of trusting n_new
+    (void) n_new;
+    segment_stream* stream = static_cast<segment_stream*>(user_data);
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    // A cut loop ends the window, so it lives in the window's last segment
+    const bool cut = stream->guard.take_cut();
+    if (stream->embeddings) {
+        embed_new_segments(ctx, state, *stream->embeddings);
+    }
+    for (; stream->emitted < n_segments && !stream->stopped; ++stream->emitted) {
+        ffi_segment segment = make_segment(ctx, state, stream->emitted, 0, stream->with_words);
+        segment.suspect |= cut && stream->emitted == n_segments - 1;
+        if (stream->embeddings) {
+            segment.embedding = std::move(stream->embeddings->by_segment[stream->emitted]);
+        }
+        if (!(*stream->on_segment)(std::move(segment))) {
+            stream->stopped = true;
         }
-        return ctx;
-    } catch (...) {
-        std::cerr << "💥 Exception during Whisper initialization" << std::endl;
-        return nullptr;
     }
 }
 
-char* whisper_ffi_transcribe(whisper_context* ctx, const char* audio_path) {
-    std::cerr << "🎵 Starting transcription for: " << audio_path << std::endl;
-    
-    if (!ctx || !audio_path) {
-        std::cerr << "❌ Invalid parameters: ctx=" << (ctx ? "valid" : "null") 
-                  << ", audio_path=" << (audio_path ? audio_path : "null") << std::endl;
-        return nullptr;
+static bool abort_stopped_stream(void* user_data) {
+    return static_cast<segment_stream*>(user_data)->stopped;
+}
+
+// Split point for a window: the quietest 20 ms frame in the last two seconds
+// before `target`, so window boundaries rarely cut through a word.
+static size_t find_quiet_split(const std::vector<float>& pcm, size_t begin, size_t target) {
+    const size_t frame = WHISPER_SAMPLE_RATE / 50;
+    const size_t search = 2 * WHISPER_SAMPLE_RATE;
+    if (target >= pcm.size()) {
+        return pcm.size();
     }
-    
-    try {
-        std::vector<float> pcmf32 = read_audio_file(audio_path);
 
-        if (pcmf32.empty()) {
-            std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
-            return nullptr;
+    size_t best = target;
+    float best_energy = -1.0f;
+    const size_t lo = std::max(begin + frame, target > search ? target - search : 0);
+    for (size_t pos = target; pos >= lo + frame; pos -= frame) {
+        float energy = 0.0f;
+        for (size_t i = pos - frame; i < pos; ++i) {
+            energy += pcm[i] * pcm[i];
+        }
+        if (best_energy < 0.0f || energy < best_energy) {
+            best_energy = energy;
+            best = pos;
+        }
+    }
+    return best;
+}
+
+// Long-file path: cut the recording into window-sized chunks and decode
+// `batch` of them at a time. Each window is an independent
+// whisper_full_with_state call on its own pooled state, with the leased
+// threads split evenly between them. A worker picks up the next chunk as
+// soon as it finishes, so `batch` windows are always decoding.
+// Finished windows are handed to `on_segment` as soon as every window
+// before them is done.
+static bool transcribe_windows_batched(whisper_context* ctx, whisper_state* own_state, const std::vector<float>& pcm,
+                                       int batch, int total_threads, const char* language, bool with_words,
+                                       bool embeddings, const segment_callback& on_segment) {
+    const size_t window = WHISPER_CHUNK_SIZE * WHISPER_SAMPLE_RATE;
+
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t begin = 0; begin < pcm.size();) {
+        size_t end = find_quiet_split(pcm, begin, begin + window);
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+
+    batch = std::min<int>(batch, (int) chunks.size());
+    std::vector<whisper_state*> pooled = acquire_states(ctx, own_state ? batch - 1 : batch);
+    std::vector<whisper_state*> states = pooled;
+    if (own_state) {
+        states.insert(states.begin(), own_state);
+    }
+    if (states.empty()) {
+        return false;
+    }
+    batch = (int) states.size();
+
+    const int threads_per_window = std::max(1, total_threads / batch);
+    std::cerr << "🧩 Decoding " << chunks.size() << " windows, " << batch << " at a time ("
+              << threads_per_window << " threads each)" << std::endl;
+
+    std::vector<std::vector<ffi_segment>> chunk_segments(chunks.size());
+    std::vector<bool> chunk_done(chunks.size(), false);
+    size_t next_emit = 0;
+    std::mutex emit_mutex;
+    std::atomic<size_t> next_chunk(0);
+    std::atomic<bool> failed(false);
+    std::atomic<bool> stopped(false);
+
+    auto worker = [&](whisper_state* state) {
+        whisper_full_params wparams = make_full_params(threads_per_window, language);
+        // Windows decode independently, so there is no previous text to condition on
+        wparams.no_context = true;
+        wparams.abort_callback = [](void* user_data) { return static_cast<std::atomic<bool>*>(user_data)->load(); };
+        wparams.abort_callback_user_data = &stopped;
+        loop_guard guard;
+        install_loop_guard(wparams, guard);
+        embedding_capture capture;
+        if (embeddings) {
+            install_embedding_capture(wparams, capture);
+            // Pool while the window's encoder output is still in the state
+            wparams.new_segment_callback = [](whisper_context* ctx, whisper_state* state, int, void* user_data) {
+                embed_new_segments(ctx, state, *static_cast<embedding_capture*>(user_data));
+            };
+            wparams.new_segment_callback_user_data = &capture;
+        }
+
+        for (size_t i = next_chunk++; i < chunks.size() && !failed && !stopped; i = next_chunk++) {
+            const size_t begin = chunks[i].first;
+            const size_t length = chunks[i].second - begin;
+            capture.reset();
+            if (whisper_full_with_state(ctx, state, wparams, pcm.data() + begin, (int) length) != 0) {
+                if (!stopped) {
+                    std::cerr << "❌ Whisper processing failed for window " << i << std::endl;
+                    failed = true;
+                }
+                return;
+            }
+            append_segments(ctx, state, (int64_t) (begin * 1000 / WHISPER_SAMPLE_RATE), with_words, chunk_segments[i]);
+            if (embeddings) {
+                embed_new_segments(ctx, state, capture);
+                for (size_t k = 0; k < chunk_segments[i].size(); ++k) {
+                    chunk_segments[i][k].embedding = std::move(capture.by_segment[k]);
+                }
+            }
+            if (guard.take_cut() && !chunk_segments[i].empty()) {
+                chunk_segments[i].back().suspect = true;
+            }
+
+            std::lock_guard<std::mutex> lock(emit_mutex);
+            chunk_done[i] = true;
+            for (; next_emit < chunks.size() && chunk_done[next_emit] && !stopped; ++next_emit) {
+                for (ffi_segment& segment : chunk_segments[next_emit]) {
+                    if (!on_segment(std::move(segment))) {
+                        stopped = true;
+                        break;
+                    }
+                }
+                chunk_segments[next_emit].clear();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < batch; ++i) {
+        workers.emplace_back(worker, states[i]);
+    }
+    worker(states[0]);
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    release_states(ctx, pooled);
+
+    if (stopped) {
+        std::cerr << "⏹️ Transcription stopped by consumer" << std::endl;
+    }
+    return !failed && !stopped;
+}
+
+// The recording with long music and noise stretches cut out. Kept spans are
+// joined with a short pause so Whisper does not run their words together,
+// and segment times are mapped back to the original recording.
+struct skip_map {
+    struct span {
+        size_t compact_begin;
+        size_t original_begin;
+        size_t length;
+    };
+    std::vector<span> spans;
+
+    int64_t to_original_ms(int64_t compact_ms) const {
+        const size_t sample = (size_t) std::max<int64_t>(0, compact_ms) * (WHISPER_SAMPLE_RATE / 1000);
+        auto it = std::upper_bound(spans.begin(), spans.end(), sample,
+                                   [](size_t value, const span& s) { return value < s.compact_begin; });
+        if (it == spans.begin()) {
+            return compact_ms;
+        }
+        --it;
+        // Times inside the joining pause belong to the end of the span before it
+        const size_t original = it->original_begin + std::min(sample - it->compact_begin, it->length);
+        return (int64_t) (original / (WHISPER_SAMPLE_RATE / 1000));
+    }
+};
+
+static const size_t SKIP_MIN_SAMPLES = 3 * WHISPER_SAMPLE_RATE;  // Only skip long stretches
+static const size_t SKIP_PAD_SAMPLES = WHISPER_SAMPLE_RATE / 2;  // Margin kept next to speech
+static const size_t SKIP_JOIN_SAMPLES = WHISPER_SAMPLE_RATE * 3 / 10;
+
+// False when there is nothing worth skipping
+static bool cut_non_speech(const std::vector<float>& pcm, std::vector<float>& compact, skip_map& map) {
+    const std::vector<classified_region> skipped = non_speech_regions(pcm, SKIP_MIN_SAMPLES, SKIP_PAD_SAMPLES);
+    if (skipped.empty()) {
+        return false;
+    }
+
+    double music_s = 0.0;
+    double noise_s = 0.0;
+    size_t kept_from = 0;
+    auto keep = [&](size_t end) {
+        if (end > kept_from) {
+            if (!compact.empty()) {
+                compact.insert(compact.end(), SKIP_JOIN_SAMPLES, 0.0f);
+            }
+            map.spans.push_back({compact.size(), kept_from, end - kept_from});
+            compact.insert(compact.end(), pcm.begin() + kept_from, pcm.begin() + end);
+        }
+    };
+    for (const classified_region& region : skipped) {
+        keep(region.begin);
+        kept_from = region.end;
+        (region.kind == audio_class::music ? music_s : noise_s) += (double) (region.end - region.begin) / WHISPER_SAMPLE_RATE;
+    }
+    keep(pcm.size());
+
+    std::cerr << "🎼 Skipping " << (int) music_s << " s of music and " << (int) noise_s << " s of noise/silence in "
+              << skipped.size() << " regions (" << compact.size() / WHISPER_SAMPLE_RATE << " s left to decode)" << std::endl;
+    return true;
+}
+
+bool transcribe_pcm(whisper_context* ctx, whisper_state* state, const std::vector<float>& original_pcm,
+                    const whisper_ffi_transcribe_params& params, const segment_callback& on_segment,
+                    lease_priority priority) {
+    const size_t window = WHISPER_CHUNK_SIZE * WHISPER_SAMPLE_RATE;
+    const bool with_words = params.word_timestamps && word_timestamps_enabled(ctx);
+
+    // Diarization labels segments from the whole recording, so hold them back until the end
+    std::vector<ffi_segment> held;
+    const segment_callback hold = [&held](ffi_segment&& segment) {
+        held.push_back(std::move(segment));
+        return true;
+    };
+    const segment_callback& output = params.diarize ? hold : on_segment;
+
+    skip_map skips;
+    scratch_pcm compact(scratch_slot::speech);
+    const bool skipping = params.skip_non_speech && cut_non_speech(original_pcm, *compact, skips);
+    if (skipping && compact->empty()) {
+        return true; // Nothing but music and noise
+    }
+    const std::vector<float>& pcm = skipping ? *compact : original_pcm;
+
+    const segment_callback to_original = [&skips, &output](ffi_segment&& segment) {
+        segment.t0_ms = skips.to_original_ms(segment.t0_ms);
+        segment.t1_ms = skips.to_original_ms(segment.t1_ms);
+        for (ffi_word& word : segment.words) {
+            word.t0_ms = skips.to_original_ms(word.t0_ms);
+            word.t1_ms = skips.to_original_ms(word.t1_ms);
+        }
+        return output(std::move(segment));
+    };
+    const segment_callback& sink = skipping ? to_original : output;
+
+    bool ok = false;
+    if (params.encoder_batch > 1 && pcm.size() > window) {
+        const int total_threads = params.n_threads > 0 ? params.n_threads : available_cpus();
+        const thread_lease lease = lease_threads(total_threads, priority);
+        ok = transcribe_windows_batched(ctx, state, pcm, std::min(params.encoder_batch, lease.threads()),
+                                        lease.threads(), params.language, with_words, params.embeddings, sink);
+    } else {
+        std::vector<whisper_state*> pooled;
+        if (!state) {
+            pooled = acquire_states(ctx, 1);
+            if (pooled.empty()) {
+                return false;
+            }
+            state = pooled[0];
         }
 
         std::cerr << "⚙️  Configuring Whisper parameters..." << std::endl;
-        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        wparams.print_progress = false;
-        wparams.print_realtime = false;
-        wparams.print_timestamps = false;
+        whisper_full_params wparams = make_full_params(params.n_threads, params.language);
+        const thread_lease lease = lease_threads(wparams.n_threads, priority);
+        wparams.n_threads = lease.threads();
+        embedding_capture capture;
+        segment_stream stream = {&sink, with_words, 0, false, params.embeddings ? &capture : nullptr, {}};
+        install_loop_guard(wparams, stream.guard);
+        if (params.embeddings) {
+            install_embedding_capture(wparams, capture);
+        }
+        wparams.new_segment_callback = on_new_segments;
+        wparams.new_segment_callback_user_data = &stream;
+        wparams.abort_callback = abort_stopped_stream;
+        wparams.abort_callback_user_data = &stream;
 
-        std::cerr << "🔄 Processing audio with Whisper (" << pcmf32.size() << " samples)..." << std::endl;
-        if (whisper_full(ctx, wparams, pcmf32.data(), pcmf32.size()) != 0) {
+        std::cerr << "🔄 Processing audio with Whisper (" << pcm.size() << " samples)..." << std::endl;
+        ok = whisper_full_with_state(ctx, state, wparams, pcm.data(), pcm.size()) == 0;
+        if (ok) {
+            // Anything the callback has not reported yet (e.g. the final flush)
+            on_new_segments(ctx, state, 0, &stream);
+        }
+        if (stream.stopped) {
+            std::cerr << "⏹️ Transcription stopped by consumer" << std::endl;
+            ok = false;
+        } else if (!ok) {
             std::cerr << "❌ Whisper processing failed" << std::endl;
-            return nullptr;
         }
 
-        const int n_segments = whisper_full_n_segments(ctx);
-        std::cerr << "📝 Extracting " << n_segments << " text segments..." << std::endl;
-        
-        std::string result_text = "";
-        for (int i = 0; i < n_segments; ++i) {
-            const char* text = whisper_full_get_segment_text(ctx, i);
-            if (text) {
-                result_text += text;
+        release_states(ctx, pooled);
+    }
+
+    // Diarization reuses the decoded PCM instead of reading the file again
+    if (ok && params.diarize) {
+        diarize_segments(original_pcm, held, params.max_speakers);
+        for (ffi_segment& segment : held) {
+            if (!on_segment(std::move(segment))) {
+                return false;
             }
         }
+    }
+    return ok;
+}
+
+void shift_segment(ffi_segment& segment, int64_t offset_ms) {
+    segment.t0_ms += offset_ms;
+    segment.t1_ms += offset_ms;
+    for (ffi_word& word : segment.words) {
+        word.t0_ms += offset_ms;
+        word.t1_ms += offset_ms;
+    }
+}
+
+bool transcribe_segments(whisper_context* ctx, const char* audio_path,
+                         const whisper_ffi_transcribe_params& params, std::vector<ffi_segment>& segments) {
+    std::cerr << "🎵 Starting transcription for: " << audio_path << std::endl;
+
+    scratch_pcm pcmf32(scratch_slot::pcm);
+    if (!read_audio_file(audio_path, *pcmf32)) {
+        std::cerr << "❌ Failed to read audio file: " << audio_path << std::endl;
+        return false;
+    }
+
+    return transcribe_pcm(ctx, nullptr, *pcmf32, params, [&segments](ffi_segment&& segment) {
+        segments.push_back(std::move(segment));
+        return true;
+    });
+}
+
+char* copy_to_c_string(const std::string& str) {
+    char* result = new char[str.length() + 1];
+    memcpy(result, str.c_str(), str.length() + 1);
+    return result;
+}
+
+void append_json_escaped(std::string& out, const std::string& str) {
+    for (unsigned char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += (char) c;
+                }
+        }
+    }
+}
+
+std::string json_escape(const std::string& str) {
+    std::string out;
+    out.reserve(str.size() + 2);
+    append_json_escaped(out, str);
+    return out;
+}
+
+// Numbers are formatted on the stack, so appending a segment only grows `json`
+static void append_json_number(std::string& json, const char* format, double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), format, value);
+    json += buf;
+}
+
+static void append_json_int(std::string& json, int64_t value) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lld", (long long) value);
+    json += buf;
+}
+
+void append_segment_json(std::string& json, const ffi_segment& segment) {
+    json += "{\"t0\":";
+    append_json_int(json, segment.t0_ms);
+    json += ",\"t1\":";
+    append_json_int(json, segment.t1_ms);
+    json += ",\"text\":\"";
+    append_json_escaped(json, segment.text);
+    json += "\"";
+    if (segment.speaker >= 0) {
+        json += ",\"speaker\":";
+        append_json_int(json, segment.speaker);
+    }
+    if (segment.suspect) {
+        json += ",\"suspect\":true";
+    }
+    if (!segment.embedding.empty()) {
+        json += ",\"embedding\":[";
+        for (size_t k = 0; k < segment.embedding.size(); ++k) {
+            append_json_number(json, k > 0 ? ",%.5g" : "%.5g", segment.embedding[k]);
+        }
+        json += "]";
+    }
+    if (!segment.words.empty()) {
+        json += ",\"words\":[";
+        for (size_t k = 0; k < segment.words.size(); ++k) {
+            const ffi_word& word = segment.words[k];
+            json += k > 0 ? ",{\"word\":\"" : "{\"word\":\"";
+            append_json_escaped(json, word.text);
+            json += "\",\"t0\":";
+            append_json_int(json, word.t0_ms);
+            json += ",\"t1\":";
+            append_json_int(json, word.t1_ms);
+            json += ",\"p\":";
+            append_json_number(json, "%.3f", word.p);
+            json += "}";
+        }
+        json += "]";
+    }
+    json += "}";
+}
+
+void append_segments_json(std::string& json, const std::vector<ffi_segment>& segments) {
+    json += "[";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i > 0) {
+            json += ",";
+        }
+        append_segment_json(json, segments[i]);
+    }
+    json += "]";
+}
+
+std::string segments_to_json(const std::vector<ffi_segment>& segments) {
+    std::string json;
+    append_segments_json(json, segments);
+    return json;
+}
+
+void append_result_json(std::string& json, const std::vector<ffi_segment>& segments, const char* language) {
+    json += "{";
+    if (language) {
+        json += "\"language\":\"";
+        append_json_escaped(json, language);
+        json += "\",";
+    }
+    json += "\"text\":\"";
+    for (const ffi_segment& segment : segments) {
+        append_json_escaped(json, segment.text);
+    }
+    json += "\",\"segments\":";
+    append_segments_json(json, segments);
+    json += "}";
+}
+
+std::string result_to_json(const std::vector<ffi_segment>& segments) {
+    std::string json;
+    append_result_json(json, segments);
+    return json;
+}
+
+char* result_to_c_string(const std::vector<ffi_segment>& segments) {
+    scratch_text json(scratch_slot::text);
+    append_result_json(*json, segments);
+    return copy_to_c_string(*json);
+}
+
+// Enable the OpenVINO encoder for states created from now on, if this build
+// and the model directory support it
+static void configure_openvino(ffi_context_extras* extras, const char* model_path,
+                               const whisper_ffi_init_params& options) {
+#ifdef WHISPER_FFI_WITH_OPENVINO
+    const std::string encoder = openvino_sibling(model_path, "-encoder-openvino.xml");
+    if (!std::ifstream(encoder).good()) {
+        std::cerr << "⚠️ No OpenVINO encoder IR at " << encoder << ", using ggml encoder" << std::endl;
+        return;
+    }
+    extras->openvino_device = options.openvino_device;
+    extras->openvino_encoder = encoder;
+    extras->openvino_cache_dir = options.openvino_cache_dir
+        ? options.openvino_cache_dir
+        : openvino_sibling(model_path, "-encoder-openvino-cache");
+    std::cerr << "🧠 OpenVINO encoder on " << extras->openvino_device
+              << " (blob cache: " << extras->openvino_cache_dir << ")" << std::endl;
+#else
+    (void) extras;
+    (void) model_path;
+    std::cerr << "⚠️ OpenVINO device '" << options.openvino_device
+              << "' requested but this library was built without OpenVINO, using ggml encoder" << std::endl;
+#endif
+}
+
+whisper_context* load_model(const char* model_path, const whisper_ffi_init_params& options) {
+    std::cerr << "🤖 Initializing Whisper with model: " << model_path << std::endl;
+
+    struct whisper_context_params cparams = whisper_context_default_params();
+    if (options.word_timestamps) {
+        const std::string preset_name = options.alignment_heads
+            ? options.alignment_heads
+            : model_name_from_path(model_path);
+        cparams.dtw_token_timestamps = true;
+        cparams.dtw_aheads_preset = alignment_heads_preset(preset_name);
+        // whisper.cpp turns DTW off (with only a warning) under flash
+        // attention, which recent versions enable by default
+        if (cparams.flash_attn) {
+            std::cerr << "⏱️ Disabling flash attention for DTW word timestamps" << std::endl;
+            cparams.flash_attn = false;
+        }
+        if (cparams.dtw_aheads_preset == WHISPER_AHEADS_N_TOP_MOST) {
+            std::cerr << "⚠️ No alignment heads known for '" << preset_name
+                      << "', using all heads of the top text layers" << std::endl;
+            cparams.dtw_n_top = 2;
+        } else {
+            std::cerr << "⏱️ Word timestamps enabled (alignment heads: " << preset_name << ")" << std::endl;
+        }
+    }
+
+    // Decoding always runs on pooled states, so skip the context's default state
+    struct whisper_context* ctx = whisper_init_from_file_with_params_no_state(model_path, cparams);
+    if (ctx) {
+        ffi_context_extras* extras = get_context_extras(ctx);
+        extras->word_timestamps = options.word_timestamps;
+        if (options.openvino_device) {
+            configure_openvino(extras, model_path, options);
+        }
+        std::cerr << "✅ Whisper context initialized successfully" << std::endl;
+    } else {
+        std::cerr << "❌ Failed to initialize Whisper context" << std::endl;
+    }
+    return ctx;
+}
+
+void free_model(whisper_context* ctx) {
+    std::cerr << "🧹 Freeing Whisper context" << std::endl;
+    release_context_extras(ctx);
+    whisper_free(ctx);
+}
+
+static char* transcribe_file(whisper_context* ctx, const char* audio_path,
+                             const whisper_ffi_transcribe_params& params) {
+    try {
+        whisper_ffi::session session(ctx, params);
+        whisper_ffi::transcript transcript = session.transcribe(audio_path);
+        if (!transcript) {
+            return nullptr;
+        }
+
+        std::cerr << "📝 Extracting " << transcript.segments().size() << " text segments..." << std::endl;
+
+        std::string result_text = transcript.text();
 
         if (result_text.empty()) {
             std::cerr << "⚠️  Warning: Transcription completed but no text extracted" << std::endl;
@@ -278,9 +936,7 @@ char* whisper_ffi_transcribe(whisper_context* ctx, const char* audio_path) {
         std::cerr << "📄 Result (" << result_text.length() << " chars): " << result_text.substr(0, 100) 
                   << (result_text.length() > 100 ? "..." : "") << std::endl;
 
-        char* result = new char[result_text.length() + 1];
-        strcpy(result, result_text.c_str());
-        return result;
+        return copy_to_c_string(result_text);
         
     } catch (...) {
         std::cerr << "💥 Exception during transcription" << std::endl;
@@ -288,13 +944,147 @@ char* whisper_ffi_transcribe(whisper_context* ctx, const char* audio_path) {
     }
 }
 
-void whisper_ffi_free(whisper_context* ctx) {
-    if (ctx) {
-        std::cerr << "🧹 Freeing Whisper context" << std::endl;
-        whisper_free(ctx);
+static char* transcript_to_json(const whisper_ffi::transcript& transcript) {
+    if (!transcript) {
+        return nullptr;
+    }
+    std::cerr << "✅ Transcription completed successfully (" << transcript.segments().size() << " segments)" << std::endl;
+    return result_to_c_string(transcript.segments());
+}
+
+// The whole stream is decoded as it is read, then transcribed like a file:
+// VAD and window planning need the complete recording
+static char* transcribe_stream_json(whisper_context* ctx, const audio_read_fn& read, const std::string& label,
+                                    const struct whisper_ffi_transcribe_params* params) {
+    std::cerr << "🎵 Starting transcription for: " << label << std::endl;
+    scratch_pcm pcm(scratch_slot::pcm);
+    if (!decode_audio_stream(read, label, *pcm)) {
+        std::cerr << "❌ Failed to read audio stream: " << label << std::endl;
+        return nullptr;
+    }
+    whisper_ffi::session session(ctx, params ? *params : whisper_ffi_transcribe_default_params());
+    return transcript_to_json(session.transcribe(*pcm));
+}
+
+extern "C" {
+
+struct whisper_ffi_init_params whisper_ffi_init_default_params(void) {
+    whisper_ffi_init_params params;
+    params.word_timestamps = false;
+    params.alignment_heads = nullptr;
+    params.openvino_device = nullptr;
+    params.openvino_cache_dir = nullptr;
+    return params;
+}
+
+whisper_context* whisper_ffi_init(const char* model_path) {
+    return whisper_ffi_init_with_params(model_path, nullptr);
+}
+
+whisper_context* whisper_ffi_init_with_params(const char* model_path, const struct whisper_ffi_init_params* params) {
+    if (!model_path) {
+        std::cerr << "❌ Invalid parameters: model_path=null" << std::endl;
+        return nullptr;
+    }
+
+    try {
+        whisper_ffi::model model(model_path, params ? *params : whisper_ffi_init_default_params());
+        return model.release();
+    } catch (...) {
+        std::cerr << "💥 Exception during Whisper initialization" << std::endl;
+        return nullptr;
+    }
+}
+
+struct whisper_ffi_transcribe_params whisper_ffi_transcribe_default_params(void) {
+    whisper_ffi_transcribe_params params;
+    params.encoder_batch = 1;
+    params.n_threads = 0;
+    params.word_timestamps = false;
+    params.diarize = false;
+    params.max_speakers = 0;
+    params.skip_non_speech = false;
+    params.embeddings = false;
+    params.language = nullptr;
+    return params;
+}
+
+char* whisper_ffi_transcribe(whisper_context* ctx, const char* audio_path) {
+    return whisper_ffi_transcribe_with_params(ctx, audio_path, nullptr);
+}
+
+char* whisper_ffi_transcribe_with_params(whisper_context* ctx, const char* audio_path,
+                                         const struct whisper_ffi_transcribe_params* params) {
+    if (!ctx || !audio_path) {
+        std::cerr << "❌ Invalid parameters: ctx=" << (ctx ? "valid" : "null") 
+                  << ", audio_path=" << (audio_path ? audio_path : "null") << std::endl;
+        return nullptr;
+    }
+
+    return transcribe_file(ctx, audio_path, params ? *params : whisper_ffi_transcribe_default_params());
+}
+
+char* whisper_ffi_transcribe_json(whisper_context* ctx, const char* audio_path,
+                                  const struct whisper_ffi_transcribe_params* params) {
+    if (!ctx || !audio_path) {
+        std::cerr << "❌ Invalid parameters: ctx=" << (ctx ? "valid" : "null") 
+                  << ", audio_path=" << (audio_path ? audio_path : "null") << std::endl;
+        return nullptr;
+    }
+
+    try {
+        whisper_ffi::session session(ctx, params ? *params : whisper_ffi_transcribe_default_params());
+        return transcript_to_json(session.transcribe(audio_path));
+    } catch (...) {
+        std::cerr << "💥 Exception during transcription" << std::endl;
+        return nullptr;
+    }
+}
+
+char* whisper_ffi_transcribe_fd_json(whisper_context* ctx, int fd,
+                                     const struct whisper_ffi_transcribe_params* params) {
+    if (!ctx || fd < 0) {
+        std::cerr << "❌ Invalid parameters: ctx=" << (ctx ? "valid" : "null") << ", fd=" << fd << std::endl;
+        return nullptr;
+    }
+
+    try {
+        return transcribe_stream_json(ctx, fd_reader(fd), "fd " + std::to_string(fd), params);
+    } catch (...) {
+        std::cerr << "💥 Exception during transcription" << std::endl;
+        return nullptr;
+    }
+}
+
+char* whisper_ffi_transcribe_callback_json(whisper_context* ctx, whisper_ffi_read_callback read, void* user_data,
+                                           const struct whisper_ffi_transcribe_params* params) {
+    if (!ctx || !read) {
+        std::cerr << "❌ Invalid parameters: ctx=" << (ctx ? "valid" : "null")
+                  << ", read=" << (read ? "valid" : "null") << std::endl;
+        return nullptr;
+    }
+
+    try {
+        const audio_read_fn reader = [read, user_data](void* buffer, size_t size) {
+            return read(user_data, buffer, (int64_t) size);
+        };
+        return transcribe_stream_json(ctx, reader, "read callback", params);
+    } catch (...) {
+        std::cerr << "💥 Exception during transcription" << std::endl;
+        return nullptr;
     }
 }
 
+const char* whisper_ffi_system_info(void) {
+    static const std::string info = std::string("blas: ") + WHISPER_FFI_BLAS_BACKEND + " | " + whisper_print_system_info();
+    return info.c_str();
+}
+
+void whisper_ffi_free(whisper_context* ctx) {
+    // The adopted model frees the context and its pooled states
+    whisper_ffi::model::adopt(ctx);
+}
+
 void whisper_ffi_free_string(char* str) {
     if (str) {
         delete[] str; // Use delete[] for memory allocated with new[]
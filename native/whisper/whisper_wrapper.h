@@ -13,15 +13,431 @@ typedef struct whisper_context whisper_context;
 // Initialize Whisper with model file
 whisper_context* whisper_ffi_init(const char* model_path);
 
+// Model load options
+struct whisper_ffi_init_params {
+    // Track cross-attention alignment heads during decoding so every token
+    // gets a DTW timestamp; costs a little extra work per decoder step and
+    // turns off flash attention, which whisper.cpp cannot combine with DTW
+    bool word_timestamps;
+    // Alignment heads preset ("tiny.en", "base", "large-v3", ...);
+    // null = derive from the model file name
+    const char* alignment_heads;
+    // Run the encoder through OpenVINO on this device ("CPU", "GPU", ...);
+    // null = ggml encoder. Needs a build with --openvino and the encoder IR
+    // next to the model (ggml-<model>-encoder-openvino.xml), otherwise the
+    // ggml encoder is used
+    const char* openvino_device;
+    // Cache for compiled OpenVINO blobs, so only the first start compiles the
+    // IR (null = ggml-<model>-encoder-openvino-cache next to the model)
+    const char* openvino_cache_dir;
+};
+
+// Default model load options (no word timestamps, ggml encoder)
+struct whisper_ffi_init_params whisper_ffi_init_default_params(void);
+
+// Initialize Whisper with model file and explicit options
+whisper_context* whisper_ffi_init_with_params(const char* model_path, const struct whisper_ffi_init_params* params);
+
+// Start loading and warming a model on a background thread (returns
+// immediately). Called by the desktop runner before Dart starts.
+bool whisper_ffi_preload(const char* model_path);
+
+// Take ownership of the preloaded context for model_path, waiting for the
+// preload to finish if needed; null if no preload matches (load normally).
+// A preload of a different model is freed and the slot cleared.
+whisper_context* whisper_ffi_adopt_preloaded(const char* model_path);
+
 // Transcribe audio file
 char* whisper_ffi_transcribe(whisper_context* ctx, const char* audio_path);
 
+// Per-call transcription options
+struct whisper_ffi_transcribe_params {
+    // Number of 30 s windows of a long recording decoded concurrently,
+    // each on its own whisper_state (1 = sequential whisper_full).
+    // Every extra window costs one state's KV cache and compute buffers.
+    int encoder_batch;
+    // Total compute threads shared by the batch (0 = all available CPUs),
+    // capped by what the process thread budget can lend right now
+    int n_threads;
+    // Group tokens into words with DTW timestamps (context must be
+    // initialized with word_timestamps); only used by whisper_ffi_transcribe_json
+    bool word_timestamps;
+    // Label segments with speakers from the already-decoded PCM;
+    // only used by whisper_ffi_transcribe_json
+    bool diarize;
+    // Upper bound on distinct speakers (0 = 8)
+    int max_speakers;
+    // Leave out stretches of 3 s or more that the spectral classifier marks
+    // as music (hold music, jingles) or noise/silence; segment times still
+    // refer to the original recording
+    bool skip_non_speech;
+    // Give every segment a unit-length audio embedding pooled from the
+    // encoder output of its window ("embedding" in JSON); needs a build with
+    // the encoder output accessor, see whisper_ffi_embedding_size
+    bool embeddings;
+    // Spoken language ("en", "de", ...) or "auto" to detect it per window;
+    // null = "en". Only read during the call.
+    const char* language;
+};
+
+// Default transcription options (encoder_batch = 1)
+struct whisper_ffi_transcribe_params whisper_ffi_transcribe_default_params(void);
+
+// Transcribe audio file with explicit options
+char* whisper_ffi_transcribe_with_params(whisper_context* ctx, const char* audio_path,
+                                         const struct whisper_ffi_transcribe_params* params);
+
+// Transcribe audio file into a JSON result block:
+// {"text": ..., "segments": [{"t0", "t1", "text", "speaker", "suspect", "words": [{"word", "t0", "t1", "p"}]}]}
+// Times are in milliseconds from the start of the file; "suspect": true marks
+// a segment that looks like a repetition loop or hallucination
+char* whisper_ffi_transcribe_json(whisper_context* ctx, const char* audio_path,
+                                  const struct whisper_ffi_transcribe_params* params);
+
+// Pull-style audio source: fill up to `size` bytes of `buffer` and return the
+// bytes written, 0 at the end of the audio or -1 on error
+typedef int64_t (*whisper_ffi_read_callback)(void* user_data, void* buffer, int64_t size);
+
+// Same JSON result for audio read front to back from a file descriptor
+// (pipe, socket, file). WAV (also with unknown sizes), Ogg Opus or FLAC is
+// recognized from the first bytes; nothing is written to disk. The caller
+// keeps ownership of fd.
+char* whisper_ffi_transcribe_fd_json(whisper_context* ctx, int fd,
+                                     const struct whisper_ffi_transcribe_params* params);
+
+// Same for audio pulled through a read callback
+char* whisper_ffi_transcribe_callback_json(whisper_context* ctx, whisper_ffi_read_callback read, void* user_data,
+                                           const struct whisper_ffi_transcribe_params* params);
+
+// Same JSON result for [t_start_ms, t_end_ms) of a file, without decoding the
+// rest: WAV is read at the computed offset, Ogg Opus from the nearest page
+// before t_start_ms. Two seconds on each side are decoded for context;
+// segments overlapping the range are returned with times in the file.
+char* whisper_ffi_transcribe_range_json(whisper_context* ctx, const char* audio_path,
+                                        int64_t t_start_ms, int64_t t_end_ms,
+                                        const struct whisper_ffi_transcribe_params* params);
+
+// Language-routed transcription over two models: English goes to an
+// English-only (.en) context, other languages to a multilingual one, each
+// with its own state pool. Language ID runs on the first 30 s with the
+// multilingual model; confident results are cached per source. Contexts
+// stay owned by the caller and must outlive the router.
+typedef struct whisper_ffi_router whisper_ffi_router;
+
+// Either context may be null (every job then goes to the other one)
+whisper_ffi_router* whisper_ffi_router_create(whisper_context* english_ctx, whisper_context* multilingual_ctx);
+
+// whisper_ffi_transcribe_json on the model for the audio's language, with
+// "language" added to the result. `source` keys the language cache (e.g. a
+// speaker or device id; null = audio_path); params->language other than
+// null or "auto" skips language ID.
+char* whisper_ffi_router_transcribe_json(whisper_ffi_router* router, const char* audio_path, const char* source,
+                                         const struct whisper_ffi_transcribe_params* params);
+
+void whisper_ffi_router_free(whisper_ffi_router* router);
+
+// Audio embedding size of this context (the encoder width, e.g. 512 for
+// base), or 0 when the library was built without encoder output access
+int whisper_ffi_embedding_size(whisper_context* ctx);
+
+// whisper_ffi_transcribe_json that also writes the memo's audio embedding
+// (whisper_ffi_embedding_size floats, unit length, pooled from the same
+// encoder passes) to `embedding`. Segment embeddings stay in the JSON only
+// when params->embeddings is set.
+char* whisper_ffi_transcribe_embed_json(whisper_context* ctx, const char* audio_path,
+                                        const struct whisper_ffi_transcribe_params* params, float* embedding);
+
+// Similarity index over embeddings: cosine nearest neighbours by brute
+// force, or over IVF lists once trained. Safe to search from several
+// threads; adds and training wait for running searches.
+typedef struct whisper_ffi_vector_index whisper_ffi_vector_index;
+
+// Create an empty index of dim-float vectors
+whisper_ffi_vector_index* whisper_ffi_index_create(int dim);
+
+// Load an index written by whisper_ffi_index_save
+whisper_ffi_vector_index* whisper_ffi_index_load(const char* path);
+
+// Add a vector under id (normalized on the way in); false for a zero vector
+bool whisper_ffi_index_add(whisper_ffi_vector_index* index, int64_t id, const float* vector);
+
+// Cluster the vectors into n_lists lists (0 = sqrt of the count); later
+// adds are filed into the nearest list. Retrain after large growth.
+bool whisper_ffi_index_train(whisper_ffi_vector_index* index, int n_lists);
+
+// Write up to k best ids (and cosine scores, may be null), best first;
+// n_probe lists are scanned once trained (0 = sqrt of the list count).
+// Returns the number of matches.
+int whisper_ffi_index_search(whisper_ffi_vector_index* index, const float* query, int k, int n_probe,
+                             int64_t* ids, float* scores);
+
+// Number of vectors in the index
+int64_t whisper_ffi_index_size(whisper_ffi_vector_index* index);
+
+// Save the index, including its lists (overwrites)
+bool whisper_ffi_index_save(whisper_ffi_vector_index* index, const char* path);
+
+// Free an index
+void whisper_ffi_index_free(whisper_ffi_vector_index* index);
+
+// Preview-first transcription for long recordings: the opening speech is
+// decoded at high priority and returned first, the rest continues in the
+// background at normal priority. The context must outlive the job: the
+// background thread keeps decoding with it after whisper_ffi_preview_start
+// returns, until whisper_ffi_preview_finish has joined it.
+typedef struct whisper_ffi_preview_job whisper_ffi_preview_job;
+
+// Decode about preview_ms of opening speech (0 = 60 s), cut at a pause, and
+// return once that preview is ready; the remaining audio is decoded on a
+// background thread. Null on failure.
+whisper_ffi_preview_job* whisper_ffi_preview_start(whisper_context* ctx, const char* audio_path,
+                                                   const struct whisper_ffi_transcribe_params* params,
+                                                   int preview_ms);
+
+// Preview result in the whisper_ffi_transcribe_json layout
+char* whisper_ffi_preview_json(whisper_ffi_preview_job* job);
+
+// True once the full result is ready and whisper_ffi_preview_finish will not block
+bool whisper_ffi_preview_done(whisper_ffi_preview_job* job);
+
+// Stop decoding the rest at its next segment, for when the full result is no
+// longer wanted; whisper_ffi_preview_finish then returns null without waiting
+// for the rest of the recording.
+void whisper_ffi_preview_cancel(whisper_ffi_preview_job* job);
+
+// Wait for the rest, free the job and return the full JSON result (null on failure)
+char* whisper_ffi_preview_finish(whisper_ffi_preview_job* job);
+
+// Compressed transcript store: columnar segment tables in compressed blocks
+// with a per-memo index, memory-mapped for random access
+typedef struct whisper_ffi_store_writer whisper_ffi_store_writer;
+typedef struct whisper_ffi_store_reader whisper_ffi_store_reader;
+
+// Create a transcript store (overwrites an existing file)
+whisper_ffi_store_writer* whisper_ffi_store_create(const char* path);
+
+// Start a memo; segments added until whisper_ffi_store_end_memo belong to it.
+// False while another memo is still open or if memo_id was already stored.
+bool whisper_ffi_store_begin_memo(whisper_ffi_store_writer* writer, const char* memo_id);
+
+// Append a segment to the current memo
+bool whisper_ffi_store_add_segment(whisper_ffi_store_writer* writer, int64_t t0_ms, int64_t t1_ms, const char* text);
+
+// Close the current memo
+bool whisper_ffi_store_end_memo(whisper_ffi_store_writer* writer);
+
+// Transcribe audio file straight into the store as one memo
+bool whisper_ffi_store_add_transcription(whisper_ffi_store_writer* writer, const char* memo_id,
+                                         whisper_context* ctx, const char* audio_path,
+                                         const struct whisper_ffi_transcribe_params* params);
+
+// Write the index and footer, then free the writer
+bool whisper_ffi_store_finish(whisper_ffi_store_writer* writer);
+
+// Open a transcript store for reading
+whisper_ffi_store_reader* whisper_ffi_store_open(const char* path);
+
+// Memo transcript as a JSON array of {t0, t1, text} (ms); null if not stored
+char* whisper_ffi_store_get(whisper_ffi_store_reader* reader, const char* memo_id);
+
+// Number of memos in the store
+int64_t whisper_ffi_store_memo_count(whisper_ffi_store_reader* reader);
+
+// Close a transcript store
+void whisper_ffi_store_close(whisper_ffi_store_reader* reader);
+
+// Columnar export for analytics: one row per segment (file, segment,
+// t0_ms, t1_ms, text, confidence, speaker, suspect) written in record
+// batches as Arrow IPC or Parquet. Needs a build with Arrow.
+typedef struct whisper_ffi_export_writer whisper_ffi_export_writer;
+
+#define WHISPER_FFI_EXPORT_ARROW 0
+#define WHISPER_FFI_EXPORT_PARQUET 1
+
+// Create an export file (overwrites); rows_per_batch 0 = 65536 rows per batch
+whisper_ffi_export_writer* whisper_ffi_export_create(const char* path, int format, int rows_per_batch);
+
+// Append one segment of source_file
+bool whisper_ffi_export_add_segment(whisper_ffi_export_writer* writer, const char* source_file,
+                                    int64_t t0_ms, int64_t t1_ms, const char* text, float confidence);
+
+// Transcribe audio file straight into the export, batch by batch. Several
+// transcriptions may export into one writer concurrently.
+bool whisper_ffi_export_add_transcription(whisper_ffi_export_writer* writer, whisper_context* ctx,
+                                          const char* audio_path,
+                                          const struct whisper_ffi_transcribe_params* params);
+
+// Write the remaining rows and the footer, then free the writer
+bool whisper_ffi_export_finish(whisper_ffi_export_writer* writer);
+
+// Subtitles and transcripts written while the recording is decoded: each
+// segment is formatted as it lands and pending output is written at least
+// every flush_ms, so what is on disk is usable before the decode finishes
+// and output memory stays small for hours-long recordings.
+typedef struct whisper_ffi_segment_writer whisper_ffi_segment_writer;
+
+#define WHISPER_FFI_WRITER_SRT 0
+#define WHISPER_FFI_WRITER_VTT 1
+#define WHISPER_FFI_WRITER_JSONL 2 // One JSON segment object per line
+
+// Output sink: consume `size` bytes of `data` and return how many were
+// taken; anything short of `size` stops the writer
+typedef int64_t (*whisper_ffi_write_callback)(void* user_data, const void* data, int64_t size);
+
+// Create a transcript file (overwrites); flush_ms 0 = write every second
+whisper_ffi_segment_writer* whisper_ffi_writer_create(const char* path, int format, int flush_ms);
+
+// Same with output handed to a callback, e.g. into a socket or a Dart buffer
+whisper_ffi_segment_writer* whisper_ffi_writer_create_callback(whisper_ffi_write_callback write, void* user_data,
+                                                               int format, int flush_ms);
+
+// Transcribe audio file into the writer; returns once everything is written.
+// One recording per writer (cue times are those of the file).
+bool whisper_ffi_writer_add_transcription(whisper_ffi_segment_writer* writer, whisper_context* ctx,
+                                          const char* audio_path,
+                                          const struct whisper_ffi_transcribe_params* params);
+
+// Write anything pending, close the file and free the writer
+bool whisper_ffi_writer_finish(whisper_ffi_segment_writer* writer);
+
+// Live captions: a streaming session decodes pushed audio on its own thread
+// and publishes the caption text into a shared buffer that Dart reads
+// straight through an FFI pointer, without messages or copies per update
+typedef struct whisper_ffi_stream whisper_ffi_stream;
+
+// Streaming options
+struct whisper_ffi_stream_params {
+    // Audio collected between decode passes
+    int step_ms;
+    // Longest stretch of audio kept tentative before it is committed
+    int max_window_ms;
+    // Compute threads for the stream (0 = up to 4 of the available CPUs)
+    int n_threads;
+    // Lag behind the pushed audio at which the stream steps down to cheaper
+    // decoding (0 = 3000 ms); it steps back up once passes have headroom
+    int max_lag_ms;
+    // Smaller model used as the last step down (null = none); must outlive the stream
+    whisper_context* fallback_ctx;
+};
+
+// Stream decoding modes, from full quality down; each keeps the savings of the ones above it
+#define WHISPER_FFI_STREAM_MODE_FULL 0           // Whole encoder context, temperature fallback
+#define WHISPER_FFI_STREAM_MODE_SHORT_CONTEXT 1  // Encoder context sized to the window
+#define WHISPER_FFI_STREAM_MODE_GREEDY 2         // One greedy pass, no temperature fallback
+#define WHISPER_FFI_STREAM_MODE_SPARSE 3         // Tentative text re-decoded every third step only
+#define WHISPER_FFI_STREAM_MODE_FALLBACK_MODEL 4 // Decoding with fallback_ctx
+
+#define WHISPER_FFI_CAPTION_STABLE_BYTES 4096
+#define WHISPER_FFI_CAPTION_TENTATIVE_BYTES 1024
+#define WHISPER_FFI_CAPTION_FINAL 1u
+
+// Seqlock-protected caption snapshot. The writer makes `sequence` odd,
+// updates the fields, then makes it even again. A reader copies the fields
+// between two reads of `sequence` and keeps the copy only if both reads
+// returned the same even value; whisper_ffi_stream_snapshot does this with
+// the required memory ordering.
+struct whisper_ffi_caption_buffer {
+    uint32_t sequence;
+    uint32_t stable_length;    // Bytes used in stable
+    uint32_t tentative_length; // Bytes used in tentative
+    uint32_t flags;            // WHISPER_FFI_CAPTION_FINAL once the stream has stopped
+    int64_t audio_ms;          // Audio decoded so far
+    uint32_t mode;             // WHISPER_FFI_STREAM_MODE_* of the last pass
+    int32_t lag_ms;            // How far decoding trailed the pushed audio at the last pass
+    char stable[WHISPER_FFI_CAPTION_STABLE_BYTES];       // UTF-8 tail of committed text
+    char tentative[WHISPER_FFI_CAPTION_TENTATIVE_BYTES]; // UTF-8 text that may still change
+};
+
+// Default streaming options (1 s steps, 10 s window, step down past 3 s of lag)
+struct whisper_ffi_stream_params whisper_ffi_stream_default_params(void);
+
+// Start a streaming session on a context
+whisper_ffi_stream* whisper_ffi_stream_start(whisper_context* ctx, const struct whisper_ffi_stream_params* params);
+
+// Append 16 kHz mono samples
+bool whisper_ffi_stream_push(whisper_ffi_stream* stream, const float* samples, int n_samples);
+
+// Caption buffer of the stream; valid until whisper_ffi_stream_free
+const struct whisper_ffi_caption_buffer* whisper_ffi_stream_captions(whisper_ffi_stream* stream);
+
+// Consistent copy of the caption buffer into caller-owned memory, read under
+// the seqlock with acquire ordering (plain loads from Dart may be reordered
+// on ARM). Only the used bytes of the text arrays are copied. False if the
+// writer was mid-update on every attempt; keep the previous snapshot.
+bool whisper_ffi_stream_snapshot(whisper_ffi_stream* stream, struct whisper_ffi_caption_buffer* out);
+
+// Decode the remaining audio, commit it and publish the final caption
+void whisper_ffi_stream_stop(whisper_ffi_stream* stream);
+
+// Stop if needed and free the session and its caption buffer
+void whisper_ffi_stream_free(whisper_ffi_stream* stream);
+
+// Encode a recording to Ogg Opus at 16 kHz for storage (bitrate in bits/s,
+// 0 for the 24 kbps speech default). .opus files can be passed to the
+// transcribe functions directly.
+bool whisper_ffi_encode_opus(const char* audio_path, const char* opus_path, int bitrate);
+
+// Compute threads shared by all concurrent transcriptions in the process
+// (0 = available CPUs: hardware threads narrowed by the cpuset and the
+// cgroup CPU quota). Each decode leases its n_threads from this budget,
+// getting fewer or waiting when others hold it.
+void whisper_ffi_set_thread_budget(int n_threads);
+int whisper_ffi_thread_budget(void);
+
+// Counters of the per-thread scratch buffers (decoded PCM, speech-only copy,
+// result JSON) that transcriptions borrow instead of allocating. Counts are
+// process-wide since start; bytes cover all live threads.
+struct whisper_ffi_scratch_stats {
+    uint64_t borrows;             // Buffers lent to jobs that used them
+    uint64_t reuses;              // Jobs served from retained capacity: allocations avoided
+    uint64_t grows;               // Jobs that had to grow their buffer (first use, larger input)
+    uint64_t fallbacks;           // Nested borrows given a private buffer
+    uint64_t trims;               // Buffers shrunk after a job that needed far less than they held
+    uint64_t retained_bytes;      // Capacity kept between jobs
+    uint64_t peak_retained_bytes;
+};
+
+void whisper_ffi_get_scratch_stats(struct whisper_ffi_scratch_stats* stats);
+
+// Free the calling thread's scratch buffers, e.g. before the thread idles
+void whisper_ffi_scratch_trim(void);
+
+// Build and CPU feature summary, e.g. "blas: openblas | WHISPER : ... | CPU : AVX2 = 1 ...".
+// Static string, do not free.
+const char* whisper_ffi_system_info(void);
+
 // Free Whisper context
 void whisper_ffi_free(whisper_context* ctx);
 
 // Free string returned by whisper_transcribe
 void whisper_ffi_free_string(char* str);
 
+#ifdef WHISPER_FFI_WITH_PROBES
+// Boundary probes, only in builds with WHISPER_FFI_WITH_PROBES
+// (build_whisper.sh --bench): exports that do next to nothing, so that
+// benchmark/ffi_boundary_benchmark.dart can time each kind of Dart<->native
+// crossing on its own (bench/bench_ffi_boundary.cpp has the native baselines)
+void whisper_ffi_probe_noop(void);
+
+// Length of a NUL-terminated string (reads every byte, like a path would be)
+int64_t whisper_ffi_probe_string(const char* str);
+
+// Transcript-shaped JSON result with n_segments segments; free with whisper_ffi_free_string
+char* whisper_ffi_probe_result(int n_segments);
+
+// Sum of n samples
+double whisper_ffi_probe_sum(const float* samples, int64_t n);
+
+typedef void (*whisper_ffi_probe_callback)(int64_t value);
+
+// Call back n times on the calling thread
+void whisper_ffi_probe_call(whisper_ffi_probe_callback callback, int64_t n);
+
+// Call back n times from a new native thread, joined before returning; for
+// posting to a Dart isolate through NativeCallable.listener
+void whisper_ffi_probe_post(whisper_ffi_probe_callback callback, int64_t n);
+#endif // WHISPER_FFI_WITH_PROBES
+
 #ifdef __cplusplus
 }
 #endif
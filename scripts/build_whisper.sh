@@ -33,6 +33,70 @@ log_error() {
     echo -e "${RED}❌ [Whisper Build] $1${NC}"
 }
 
+# Extra CMake flags collected from command line options
+EXTRA_CMAKE_ARGS=()
+
+# CPU matrix backend comparison (--compare-blas=<audio>)
+COMPARE_BLAS_AUDIO=""
+BENCH_MODEL=""
+BENCH_THREADS=""
+BLAS_BACKENDS=(ggml openblas blis)
+
+# OpenVINO encoder (--openvino)
+OPENVINO=false
+
+# Native tests (--test)
+RUN_TESTS=false
+
+# CMake flags for a CPU matrix backend
+blas_cmake_args() {
+    case $1 in
+        ggml)     echo "-DGGML_BLAS=OFF -DWHISPER_FFI_BLAS_BACKEND=ggml" ;;
+        openblas) echo "-DGGML_BLAS=ON -DGGML_BLAS_VENDOR=OpenBLAS -DWHISPER_FFI_BLAS_BACKEND=openblas" ;;
+        blis)     echo "-DGGML_BLAS=ON -DGGML_BLAS_VENDOR=FLAME -DWHISPER_FFI_BLAS_BACKEND=blis" ;;
+    esac
+}
+
+# Parse build options
+parse_args() {
+    for arg in "$@"; do
+        case $arg in
+            --bench)
+                EXTRA_CMAKE_ARGS+=(-DWHISPER_FFI_BUILD_BENCH=ON -DWHISPER_FFI_WITH_PROBES=ON)
+                ;;
+            --test)
+                RUN_TESTS=true
+                EXTRA_CMAKE_ARGS+=(-DWHISPER_FFI_BUILD_TESTS=ON)
+                ;;
+            --blas=*)
+                if [[ ! " ${BLAS_BACKENDS[*]} " =~ " ${arg#--blas=} " ]]; then
+                    log_error "Unknown BLAS backend: ${arg#--blas=} (expected ${BLAS_BACKENDS[*]})"
+                    exit 1
+                fi
+                read -r -a blas_args <<< "$(blas_cmake_args "${arg#--blas=}")"
+                EXTRA_CMAKE_ARGS+=("${blas_args[@]}")
+                ;;
+            --openvino)
+                OPENVINO=true
+                EXTRA_CMAKE_ARGS+=(-DWHISPER_OPENVINO=ON)
+                ;;
+            --compare-blas=*)
+                COMPARE_BLAS_AUDIO="${arg#--compare-blas=}"
+                ;;
+            --bench-model=*)
+                BENCH_MODEL="${arg#--bench-model=}"
+                ;;
+            --bench-threads=*)
+                BENCH_THREADS="${arg#--bench-threads=}"
+                ;;
+            *)
+                log_error "Unknown option: $arg (see --help)"
+                exit 1
+                ;;
+        esac
+    done
+}
+
 # Detect platform
 detect_platform() {
     case "$(uname -s)" in
@@ -66,6 +130,8 @@ download_whisper() {
     if [ -d "$WHISPER_DIR/whisper.cpp" ]; then
         log_warning "Whisper.cpp already exists. Updating..."
         cd "$WHISPER_DIR/whisper.cpp"
+        # Drop the encoder output accessor so the pull applies cleanly
+        git checkout -- src/whisper.cpp
         git pull
     else
         cd "$WHISPER_DIR"
@@ -106,7 +172,8 @@ compile_macos() {
         -DCMAKE_BUILD_TYPE=Release \
         -DBUILD_SHARED_LIBS=ON \
         -DWHISPER_BUILD_TESTS=OFF \
-        -DWHISPER_BUILD_EXAMPLES=OFF
+        -DWHISPER_BUILD_EXAMPLES=OFF \
+        "${EXTRA_CMAKE_ARGS[@]}"
     
     make -j$(sysctl -n hw.ncpu)
     
@@ -127,7 +194,8 @@ compile_linux() {
         -DCMAKE_BUILD_TYPE=Release \
         -DBUILD_SHARED_LIBS=ON \
         -DWHISPER_BUILD_TESTS=OFF \
-        -DWHISPER_BUILD_EXAMPLES=OFF
+        -DWHISPER_BUILD_EXAMPLES=OFF \
+        "${EXTRA_CMAKE_ARGS[@]}"
     
     make -j$(nproc)
     
@@ -148,7 +216,8 @@ compile_windows() {
         -DCMAKE_BUILD_TYPE=Release \
         -DBUILD_SHARED_LIBS=ON \
         -DWHISPER_BUILD_TESTS=OFF \
-        -DWHISPER_BUILD_EXAMPLES=OFF
+        -DWHISPER_BUILD_EXAMPLES=OFF \
+        "${EXTRA_CMAKE_ARGS[@]}"
     
     cmake --build . --config Release
     
@@ -158,6 +227,19 @@ compile_windows() {
     log_success "Windows compilation complete"
 }
 
+# Run the wrapper tests built by --test (Windows keeps them per configuration)
+run_tests() {
+    log_info "Running native tests..."
+
+    cd "$WHISPER_DIR/whisper.cpp/build"
+    if ! ctest --output-on-failure -C Release; then
+        log_error "Native tests failed"
+        exit 1
+    fi
+
+    log_success "Native tests passed"
+}
+
 # Download default model
 download_model() {
     log_info "Downloading default Whisper model (base.en)..."
@@ -183,6 +265,28 @@ download_model() {
     log_success "Model downloaded and copied to Flutter assets"
 }
 
+# Export the OpenVINO encoder IR for the default model (--openvino).
+# Needs Python with openvino, torch and openai-whisper; without it the
+# library still builds and the wrapper falls back to the ggml encoder.
+convert_openvino_encoder() {
+    local ir="ggml-base.en-encoder-openvino"
+
+    cd "$WHISPER_DIR/whisper.cpp/models"
+
+    if [ ! -f "$ir.xml" ]; then
+        log_info "Converting base.en encoder to OpenVINO IR..."
+        if ! python3 convert-whisper-to-openvino.py --model base.en; then
+            log_warning "OpenVINO conversion failed (pip install -r requirements-openvino.txt), using ggml encoder"
+            return
+        fi
+    else
+        log_warning "OpenVINO encoder IR already exists: $ir.xml"
+    fi
+
+    cp "$ir.xml" "$ir.bin" "$MODEL_DIR/"
+    log_success "OpenVINO encoder IR copied next to the model"
+}
+
 # Create C wrapper for simplified FFI
 create_c_wrapper() {
     log_info "Creating C wrapper for FFI..."
@@ -292,24 +396,118 @@ update_cmake() {
     
     cd "$WHISPER_DIR/whisper.cpp"
     
-    # Add wrapper to CMakeLists.txt if not already present
-    if ! grep -q "whisper_wrapper" CMakeLists.txt; then
-        cat >> CMakeLists.txt << 'EOF'
+    # The wrapper block is always appended last; drop any previous copy so
+    # changes to native/whisper/whisper_ffi.cmake are picked up on rebuild
+    if grep -q "# Flutter FFI Wrapper" CMakeLists.txt; then
+        sed -i.bak '/^# Flutter FFI Wrapper/,$d' CMakeLists.txt
+        rm -f CMakeLists.txt.bak
+    fi
 
+    cat >> CMakeLists.txt << 'EOF'
 # Flutter FFI Wrapper
-add_library(whisper_ffi SHARED
-    ../whisper_wrapper.cpp
-)
-
-target_link_libraries(whisper_ffi whisper)
-target_include_directories(whisper_ffi PRIVATE .)
-target_include_directories(whisper_ffi PRIVATE ..)
+include(${CMAKE_CURRENT_SOURCE_DIR}/../whisper_ffi.cmake)
 EOF
-    fi
     
     log_success "CMakeLists.txt updated"
 }
 
+# whisper.cpp keeps the encoder output private; append a small accessor so
+# the wrapper can pool audio embeddings from it (WHISPER_FFI_WITH_ENCODER_OUTPUT)
+patch_encoder_output() {
+    cd "$WHISPER_DIR/whisper.cpp"
+
+    if grep -q "whisper_ffi_encoder_output" src/whisper.cpp; then
+        return
+    fi
+    if ! grep -q "embd_enc" src/whisper.cpp; then
+        log_warning "whisper.cpp has no embd_enc tensor, audio embeddings will be unavailable"
+        return
+    fi
+
+    cat >> src/whisper.cpp << 'EOF'
+
+// Flutter FFI: copy up to n_max floats of the last encoder output, return the full count
+extern "C" int whisper_ffi_encoder_output(struct whisper_state * state, float * out, int n_max) {
+    ggml_tensor * embd = state->embd_enc;
+    if (!embd) {
+        return 0;
+    }
+    const int n = (int) ggml_nelements(embd);
+    if (out && n_max > 0) {
+        ggml_backend_tensor_get(embd, out, 0, sizeof(float) * std::min(n, n_max));
+    }
+    return n;
+}
+EOF
+
+    log_success "Encoder output accessor added"
+}
+
+# Build every CPU matrix backend side by side (build-<backend>) and run
+# bench_backend on each, so the fastest one can be picked per host
+compare_blas_backends() {
+    local model="${BENCH_MODEL:-$MODEL_DIR/ggml-base.en.bin}"
+    local jobs
+    jobs=$(nproc 2>/dev/null || sysctl -n hw.ncpu)
+
+    if [ ! -f "$COMPARE_BLAS_AUDIO" ]; then
+        log_error "Benchmark audio not found: $COMPARE_BLAS_AUDIO"
+        exit 1
+    fi
+
+    # Every backend runs on the same thread count: --bench-threads, or the
+    # CPUs bench_backend finds available
+    local bench_args=("$model" "$COMPARE_BLAS_AUDIO")
+    if [ -n "$BENCH_THREADS" ]; then
+        bench_args+=(5 "$BENCH_THREADS")
+    fi
+
+    local results=()
+    for backend in "${BLAS_BACKENDS[@]}"; do
+        local build_dir="$WHISPER_DIR/whisper.cpp/build-$backend"
+        local backend_args
+        read -r -a backend_args <<< "$(blas_cmake_args "$backend")"
+
+        log_info "Building $backend backend in $build_dir..."
+        if ! cmake -S "$WHISPER_DIR/whisper.cpp" -B "$build_dir" \
+                -DCMAKE_BUILD_TYPE=Release \
+                -DBUILD_SHARED_LIBS=ON \
+                -DWHISPER_BUILD_TESTS=OFF \
+                -DWHISPER_BUILD_EXAMPLES=OFF \
+                -DWHISPER_FFI_BUILD_BENCH=ON \
+                "${backend_args[@]}" > "$build_dir.log" 2>&1 \
+            || ! cmake --build "$build_dir" --target bench_backend -j"$jobs" >> "$build_dir.log" 2>&1; then
+            log_warning "Skipping $backend: build failed (is the library installed?), see $build_dir.log"
+            continue
+        fi
+
+        local bench
+        bench=$(find "$build_dir" -name bench_backend -type f | head -n 1)
+        log_info "Benchmarking $backend..."
+        local result
+        if result=$("$bench" "${bench_args[@]}" 2>/dev/null | grep '^RESULT'); then
+            results+=("$result")
+        else
+            log_warning "Benchmark failed for $backend"
+        fi
+    done
+
+    echo
+    log_info "CPU backend comparison ($(basename "$model"), $(basename "$COMPARE_BLAS_AUDIO")):"
+    printf '  %-10s %8s %14s %16s\n' "backend" "threads" "encode (ms)" "transcribe (ms)"
+    for result in "${results[@]}"; do
+        # RESULT backend=<name> threads=<n> encode_ms=<ms> transcribe_ms=<ms>
+        local name threads encode transcribe
+        name=$(sed -E 's/.*backend=([^ ]+).*/\1/' <<< "$result")
+        threads=$(sed -E 's/.*threads=([^ ]+).*/\1/' <<< "$result")
+        encode=$(sed -E 's/.*encode_ms=([^ ]+).*/\1/' <<< "$result")
+        transcribe=$(sed -E 's/.*transcribe_ms=([^ ]+).*/\1/' <<< "$result")
+        printf '  %-10s %8s %14s %16s\n' "$name" "$threads" "$encode" "$transcribe"
+    done
+    echo
+    log_info "Build the winner with: ./scripts/build_whisper.sh --blas=<backend>"
+}
+
 # Print next steps
 print_next_steps() {
     log_success "Whisper.cpp build complete!"
@@ -330,13 +528,28 @@ print_next_steps() {
 main() {
     log_info "Starting Whisper.cpp build process..."
     
+    parse_args "$@"
     detect_platform
     setup_directories
     download_whisper
     create_c_wrapper
     update_cmake
+    patch_encoder_output
+
+    if [ -n "$COMPARE_BLAS_AUDIO" ]; then
+        download_model
+        compare_blas_backends
+        return
+    fi
+
     compile_whisper
+    if [ "$RUN_TESTS" = true ]; then
+        run_tests
+    fi
     download_model
+    if [ "$OPENVINO" = true ]; then
+        convert_openvino_encoder
+    fi
     print_next_steps
     
     log_success "Build process completed successfully!"
@@ -349,12 +562,31 @@ if [[ "$1" == "--help" || "$1" == "-h" ]]; then
     echo "This script downloads, compiles, and sets up Whisper.cpp for FFI usage."
     echo
     echo "Usage:"
-    echo "  ./scripts/build_whisper.sh"
+    echo "  ./scripts/build_whisper.sh [options]"
+    echo
+    echo "Options:"
+    echo "  --bench                  Also build the wrapper benchmarks in native/whisper/bench and"
+    echo "                           export the whisper_ffi_probe_* FFI boundary probes"
+    echo "  --test                   Also build the wrapper tests in native/whisper/tests and run them"
+    echo "  --blas=<backend>         CPU matrix backend: ggml (built-in kernels), openblas or blis"
+    echo "                           (default: whisper.cpp's own choice, Accelerate on Apple)"
+    echo "  --openvino               Build the OpenVINO encoder and export its IR for the default model"
+    echo "                           (source OpenVINO's setupvars.sh first)"
+    echo "  --compare-blas=<audio>   Build every backend side by side and benchmark them on <audio>"
+    echo "                           (16 kHz mono 16-bit PCM WAV)"
+    echo "  --bench-model=<model>    Model for --compare-blas (default: assets/models/ggml-base.en.bin)"
+    echo "  --bench-threads=<n>      Threads for --compare-blas (default: the CPUs available to the process)"
     echo
     echo "Requirements:"
     echo "  - Git"
     echo "  - CMake"
     echo "  - C++ compiler (gcc/clang/MSVC)"
+    echo "  - libzstd (optional, compresses the transcript store)"
+    echo "  - libopus + libogg (optional, Opus storage for recordings)"
+    echo "  - libFLAC (optional, FLAC input for fd/callback transcription)"
+    echo "  - Apache Arrow + Parquet C++ (optional, columnar segment export)"
+    echo "  - OpenBLAS or BLIS (only for --blas=openblas / --blas=blis)"
+    echo "  - OpenVINO runtime + Python openvino/torch/openai-whisper (only for --openvino)"
     echo "  - Internet connection for downloads"
     echo
     exit 0